@@ -0,0 +1,114 @@
+#include "PreComp.h"
+#include "AssetReloader.h"
+
+#include "Gust/Core/ThreadPool.h"
+
+namespace Gust
+{
+    AssetReloader::AssetReloader(const std::string& rootDirectory, float debounceSeconds) :
+        _watcher(FileWatcher::create(rootDirectory, debounceSeconds))
+    {
+    }
+
+    AssetReloader::~AssetReloader()
+    {
+        //Jobs capture this, so they must be finished before we go away.
+        std::unique_lock<std::mutex> lock(_completedMutex);
+        _idle.wait(lock, [this]() { return _inFlight == 0; });
+    }
+
+    void AssetReloader::watch(const std::string& filePath, ReloadFunc reload)
+    {
+        std::string key = filePath;
+        std::replace(key.begin(), key.end(), '\\', '/');
+        _handlers[key] = std::move(reload);
+    }
+
+    void AssetReloader::watchDirectory(const std::string& directory, ReloadFunc reload)
+    {
+        std::string prefix = directory;
+        std::replace(prefix.begin(), prefix.end(), '\\', '/');
+        if (prefix.empty() == false && prefix.back() != '/')
+        {
+            prefix += '/';
+        }
+        _directoryHandlers.emplace_back(std::move(prefix), std::move(reload));
+    }
+
+    void AssetReloader::update()
+    {
+        GUST_PROFILE_FUNCTION();
+
+        _changes.clear();
+        _watcher->poll(_changes);
+
+        for (const auto& change : _changes)
+        {
+            const ReloadFunc* handler = findHandler(change.path);
+            if (handler == nullptr)
+            {
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_completedMutex);
+                _inFlight++;
+            }
+
+            GUST_INFO("{0} changed, reloading.", change.path);
+            ThreadPool::get().submit([this, reload = *handler, change]()
+            {
+                auto loadStart = std::chrono::steady_clock::now();
+                std::function<void()> apply = reload(change.path);
+                float loadMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+
+                std::lock_guard<std::mutex> lock(_completedMutex);
+                _completed.push_back({ change.path, std::move(apply), change.firstSeen, loadMilliseconds });
+                _inFlight--;
+                _idle.notify_all();
+            });
+        }
+
+        std::vector<CompletedReload> completed;
+        {
+            std::lock_guard<std::mutex> lock(_completedMutex);
+            completed.swap(_completed);
+        }
+
+        for (auto& reload : completed)
+        {
+            if (!reload.apply)
+            {
+                GUST_WARN("Reloading {0} failed, keeping the old version.", reload.filePath);
+                continue;
+            }
+
+            auto applyStart = std::chrono::steady_clock::now();
+            reload.apply();
+            auto now = std::chrono::steady_clock::now();
+
+            float applyMilliseconds = std::chrono::duration<float, std::milli>(now - applyStart).count();
+            float totalMilliseconds = std::chrono::duration<float, std::milli>(now - reload.firstSeen).count();
+            GUST_INFO("Reloaded {0} in {1:.1f} ms (load {2:.1f} ms, apply {3:.1f} ms).",
+                      reload.filePath, totalMilliseconds, reload.loadMilliseconds, applyMilliseconds);
+        }
+    }
+
+    const AssetReloader::ReloadFunc* AssetReloader::findHandler(const std::string& filePath) const
+    {
+        auto handler = _handlers.find(filePath);
+        if (handler != _handlers.end())
+        {
+            return &handler->second;
+        }
+
+        for (const auto& [prefix, reload] : _directoryHandlers)
+        {
+            if (filePath.compare(0, prefix.size(), prefix) == 0)
+            {
+                return &reload;
+            }
+        }
+        return nullptr;
+    }
+}
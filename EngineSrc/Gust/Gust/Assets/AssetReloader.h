@@ -0,0 +1,61 @@
+#ifndef ASSET_RELOADER_HDR
+#define ASSET_RELOADER_HDR
+
+#include "PreComp.h"
+
+#include "Gust/Core/FileWatcher.h"
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace Gust
+{
+    //Reloads assets when the files behind them change. The expensive part,
+    //reading and decoding, happens on the thread pool. What it hands back is
+    //run on the main thread at the frame boundary where it is safe to swap
+    //GPU resources.
+    class AssetReloader
+    {
+    public:
+        //Runs on a worker thread. Returns the work that has to happen on the
+        //main thread, or an empty function if the load failed.
+        using ReloadFunc = std::function<std::function<void()>(const std::string&)>;
+
+        AssetReloader(const std::string& rootDirectory, float debounceSeconds = 0.2f);
+        ~AssetReloader();
+
+        AssetReloader(const AssetReloader&) = delete;
+        AssetReloader& operator=(const AssetReloader&) = delete;
+
+        void watch(const std::string& filePath, ReloadFunc reload);
+        //Every file under the directory without a handler of its own.
+        void watchDirectory(const std::string& directory, ReloadFunc reload);
+
+        //Call once a frame from the main thread.
+        void update();
+    private:
+        const ReloadFunc* findHandler(const std::string& filePath) const;
+    private:
+        struct CompletedReload
+        {
+            std::string filePath;
+            std::function<void()> apply;
+            std::chrono::steady_clock::time_point firstSeen;
+            float loadMilliseconds;
+        };
+
+        std::unique_ptr<FileWatcher> _watcher;
+        std::unordered_map<std::string, ReloadFunc> _handlers;
+        //Directory with a trailing slash, first match wins.
+        std::vector<std::pair<std::string, ReloadFunc>> _directoryHandlers;
+        std::vector<FileChange> _changes;
+
+        std::mutex _completedMutex;
+        std::condition_variable _idle;
+        std::vector<CompletedReload> _completed;
+        uint32_t _inFlight = 0;
+    };
+}
+
+#endif // !ASSET_RELOADER_HDR
@@ -0,0 +1,258 @@
+#include "PreComp.h"
+#include "CookedAssets.h"
+
+#include <fstream>
+#include <cstring>
+
+namespace
+{
+    void unpack565(uint16_t packed, uint8_t* rgb)
+    {
+        uint8_t r = static_cast<uint8_t>((packed >> 11) & 0x1F);
+        uint8_t g = static_cast<uint8_t>((packed >> 5) & 0x3F);
+        uint8_t b = static_cast<uint8_t>(packed & 0x1F);
+
+        rgb[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+        rgb[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+        rgb[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+    }
+
+    //Decodes a single BC1 colour block into 16 RGBA texels. BC3 always uses
+    //the four colour mode for its colour block.
+    void decodeColourBlock(const uint8_t* block, uint8_t* texels, bool forceFourColour)
+    {
+        uint16_t colour0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+        uint16_t colour1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+
+        uint8_t palette[4][4] = {};
+        unpack565(colour0, palette[0]);
+        unpack565(colour1, palette[1]);
+        palette[0][3] = 255;
+        palette[1][3] = 255;
+
+        for (int c = 0; c < 3; c++)
+        {
+            if (forceFourColour || colour0 > colour1)
+            {
+                palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c]) / 3);
+                palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c]) / 3);
+            }
+            else
+            {
+                palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c]) / 2);
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = (forceFourColour || colour0 > colour1) ? 255 : 0;
+
+        uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+        for (int i = 0; i < 16; i++)
+        {
+            memcpy(&texels[i * 4], palette[(indices >> (i * 2)) & 0x3], 4);
+        }
+    }
+
+    void decodeAlphaBlock(const uint8_t* block, uint8_t* texels)
+    {
+        uint8_t alpha[8];
+        alpha[0] = block[0];
+        alpha[1] = block[1];
+
+        if (alpha[0] > alpha[1])
+        {
+            for (int i = 1; i < 7; i++)
+            {
+                alpha[i + 1] = static_cast<uint8_t>(((7 - i) * alpha[0] + i * alpha[1]) / 7);
+            }
+        }
+        else
+        {
+            for (int i = 1; i < 5; i++)
+            {
+                alpha[i + 1] = static_cast<uint8_t>(((5 - i) * alpha[0] + i * alpha[1]) / 5);
+            }
+            alpha[6] = 0;
+            alpha[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; i++)
+        {
+            indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            texels[i * 4 + 3] = alpha[(indices >> (i * 3)) & 0x7];
+        }
+    }
+}
+
+namespace Gust
+{
+    bool CookedAssets::loadMesh(const std::string& filePath, CookedMesh& mesh)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        std::vector<uint8_t> bytes;
+        if (readWholeFile(filePath, bytes) == false || bytes.size() < sizeof(CookedMeshHeader))
+        {
+            GUST_ERROR("Failed to read cooked mesh {0}", filePath);
+            return false;
+        }
+
+        CookedMeshHeader header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        if (header.magic != COOKED_MESH_MAGIC || header.version != COOKED_MESH_VERSION)
+        {
+            GUST_ERROR("Cooked mesh {0} is out of date, re-run GustCook.", filePath);
+            return false;
+        }
+
+        size_t vertexBytes = sizeof(CookedVertex) * header.vertexCount;
+        size_t indexBytes = sizeof(uint32_t) * header.indexCount;
+        if (bytes.size() < sizeof(header) + vertexBytes + indexBytes)
+        {
+            GUST_ERROR("Cooked mesh {0} is truncated.", filePath);
+            return false;
+        }
+
+        mesh.vertices.resize(header.vertexCount);
+        mesh.indices.resize(header.indexCount);
+        memcpy(mesh.vertices.data(), bytes.data() + sizeof(header), vertexBytes);
+        memcpy(mesh.indices.data(), bytes.data() + sizeof(header) + vertexBytes, indexBytes);
+        memcpy(mesh.boundsMin, header.boundsMin, sizeof(mesh.boundsMin));
+        memcpy(mesh.boundsMax, header.boundsMax, sizeof(mesh.boundsMax));
+
+        return true;
+    }
+
+    bool CookedAssets::loadTexture(const std::string& filePath, CookedTexture& texture)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        std::vector<uint8_t> bytes;
+        if (readWholeFile(filePath, bytes) == false || bytes.size() < sizeof(CookedTextureHeader))
+        {
+            GUST_ERROR("Failed to read cooked texture {0}", filePath);
+            return false;
+        }
+
+        CookedTextureHeader header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        if (header.magic != COOKED_TEXTURE_MAGIC || header.version != COOKED_TEXTURE_VERSION)
+        {
+            GUST_ERROR("Cooked texture {0} is out of date, re-run GustCook.", filePath);
+            return false;
+        }
+
+        size_t mipTableEnd = sizeof(header) + sizeof(CookedMipHeader) * header.mipLevels;
+        if (header.mipLevels == 0 || bytes.size() < mipTableEnd)
+        {
+            GUST_ERROR("Cooked texture {0} has a broken mip table.", filePath);
+            return false;
+        }
+
+        texture.format = header.format;
+        texture.width = header.width;
+        texture.height = header.height;
+        texture.mips.resize(header.mipLevels);
+        memcpy(texture.mips.data(), bytes.data() + sizeof(header), sizeof(CookedMipHeader) * header.mipLevels);
+
+        //Rebase the mip offsets so they index into the data block rather
+        //than the file.
+        for (auto& mip : texture.mips)
+        {
+            if (mip.offset < mipTableEnd || mip.offset + mip.size > bytes.size())
+            {
+                GUST_ERROR("Cooked texture {0} is truncated.", filePath);
+                return false;
+            }
+            mip.offset -= mipTableEnd;
+        }
+
+        texture.data.assign(bytes.begin() + mipTableEnd, bytes.end());
+
+        return true;
+    }
+
+    void CookedAssets::decompressTexture(CookedTexture& texture)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        if (isBlockCompressed(texture.format) == false)
+        {
+            return;
+        }
+
+        bool hasAlphaBlock = texture.format == CookedTextureFormat::BC3_SRGB;
+        size_t blockSize = hasAlphaBlock ? 16 : 8;
+
+        std::vector<CookedMipHeader> mips = texture.mips;
+        std::vector<uint8_t> data;
+
+        for (auto& mip : mips)
+        {
+            const uint8_t* source = texture.data.data() + mip.offset;
+            uint64_t offset = data.size();
+            data.resize(offset + cookedMipSize(CookedTextureFormat::RGBA8_SRGB, mip.width, mip.height));
+
+            uint32_t blocksWide = (mip.width + 3) / 4;
+            uint32_t blocksHigh = (mip.height + 3) / 4;
+            uint8_t texels[16 * 4];
+
+            for (uint32_t by = 0; by < blocksHigh; by++)
+            {
+                for (uint32_t bx = 0; bx < blocksWide; bx++)
+                {
+                    const uint8_t* block = source + (static_cast<size_t>(by) * blocksWide + bx) * blockSize;
+                    if (hasAlphaBlock)
+                    {
+                        decodeColourBlock(block + 8, texels, true);
+                        decodeAlphaBlock(block, texels);
+                    }
+                    else
+                    {
+                        decodeColourBlock(block, texels, false);
+                    }
+
+                    //Blocks on the right and bottom edge can hang off the
+                    //image so only copy the texels that exist.
+                    for (uint32_t y = 0; y < 4 && by * 4 + y < mip.height; y++)
+                    {
+                        for (uint32_t x = 0; x < 4 && bx * 4 + x < mip.width; x++)
+                        {
+                            size_t dest = offset + ((static_cast<size_t>(by) * 4 + y) * mip.width + bx * 4 + x) * 4;
+                            memcpy(&data[dest], &texels[(y * 4 + x) * 4], 4);
+                        }
+                    }
+                }
+            }
+
+            mip.offset = offset;
+            mip.size = data.size() - offset;
+        }
+
+        texture.format = CookedTextureFormat::RGBA8_SRGB;
+        texture.mips = std::move(mips);
+        texture.data = std::move(data);
+    }
+
+    bool CookedAssets::readWholeFile(const std::string& filePath, std::vector<uint8_t>& bytes)
+    {
+        std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        bytes.resize(fileSize);
+
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(bytes.data()), fileSize);
+
+        return file.good();
+    }
+}
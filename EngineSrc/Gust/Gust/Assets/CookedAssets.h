@@ -0,0 +1,44 @@
+#ifndef COOKED_ASSETS_HDR
+#define COOKED_ASSETS_HDR
+
+#include "PreComp.h"
+
+#include "CookedFormats.h"
+
+namespace Gust
+{
+    struct CookedMesh
+    {
+        std::vector<CookedVertex> vertices;
+        std::vector<uint32_t> indices;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    struct CookedTexture
+    {
+        CookedTextureFormat format = CookedTextureFormat::RGBA8_SRGB;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        //Mip offsets point into data, not into the original file.
+        std::vector<CookedMipHeader> mips;
+        std::vector<uint8_t> data;
+    };
+
+    //Runtime loaders for the assets GustCook produces. The cooker has already
+    //done all the expensive work so these are a validate and a copy.
+    class CookedAssets
+    {
+    public:
+        static bool loadMesh(const std::string& filePath, CookedMesh& mesh);
+        static bool loadTexture(const std::string& filePath, CookedTexture& texture);
+
+        //Used when the device can't sample block compressed formats. Expands
+        //every mip back out to RGBA8 in place.
+        static void decompressTexture(CookedTexture& texture);
+    private:
+        static bool readWholeFile(const std::string& filePath, std::vector<uint8_t>& bytes);
+    };
+}
+
+#endif // !COOKED_ASSETS_HDR
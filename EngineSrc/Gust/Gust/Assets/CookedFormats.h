@@ -0,0 +1,101 @@
+#ifndef COOKED_FORMATS_HDR
+#define COOKED_FORMATS_HDR
+
+#include <cstdint>
+#include <cstddef>
+
+//These are the on disk layouts written by GustCook and read by the engine.
+//This header is shared between the two so it must not pull in anything from
+//the engine, the cooker has no Vulkan or GLFW to link against.
+namespace Gust
+{
+    constexpr uint32_t makeFourCC(char a, char b, char c, char d)
+    {
+        return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) |
+               (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+    }
+
+    constexpr uint32_t COOKED_MESH_MAGIC = makeFourCC('G', 'M', 'S', 'H');
+    constexpr uint32_t COOKED_MESH_VERSION = 1;
+
+    constexpr uint32_t COOKED_TEXTURE_MAGIC = makeFourCC('G', 'T', 'E', 'X');
+    constexpr uint32_t COOKED_TEXTURE_VERSION = 1;
+
+    constexpr const char* COOKED_MESH_EXTENSION = ".gmesh";
+    constexpr const char* COOKED_TEXTURE_EXTENSION = ".gtex";
+
+    //Matches the engine's Vertex struct byte for byte so a cooked vertex
+    //array can be copied straight into a vertex buffer.
+    struct CookedVertex
+    {
+        float pos[3];
+        float colour[3];
+        float texCoord[2];
+    };
+    static_assert(sizeof(CookedVertex) == 32, "CookedVertex must stay tightly packed.");
+
+    //File layout is the header, then vertexCount vertices, then indexCount
+    //32 bit indices. Indices are already in vertex cache order.
+    struct CookedMeshHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    enum class CookedTextureFormat : uint32_t
+    {
+        RGBA8_SRGB = 0,
+        BC1_SRGB = 1,
+        BC3_SRGB = 2
+    };
+
+    //File layout is the header, then mipLevels CookedMipHeaders, then the
+    //mip data. Offsets are from the start of the file.
+    struct CookedTextureHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        CookedTextureFormat format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipLevels;
+    };
+
+    struct CookedMipHeader
+    {
+        uint32_t width;
+        uint32_t height;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    inline bool isBlockCompressed(CookedTextureFormat format)
+    {
+        return format == CookedTextureFormat::BC1_SRGB || format == CookedTextureFormat::BC3_SRGB;
+    }
+
+    //Size in bytes of a single mip for the given format. Block compressed
+    //formats round up to whole 4x4 blocks.
+    inline uint64_t cookedMipSize(CookedTextureFormat format, uint32_t width, uint32_t height)
+    {
+        uint64_t blocksWide = (width + 3) / 4;
+        uint64_t blocksHigh = (height + 3) / 4;
+
+        switch (format)
+        {
+        case CookedTextureFormat::BC1_SRGB:
+            return blocksWide * blocksHigh * 8;
+        case CookedTextureFormat::BC3_SRGB:
+            return blocksWide * blocksHigh * 16;
+        case CookedTextureFormat::RGBA8_SRGB:
+        default:
+            return static_cast<uint64_t>(width) * height * 4;
+        }
+    }
+}
+
+#endif // !COOKED_FORMATS_HDR
@@ -0,0 +1,757 @@
+#include "PreComp.h"
+#include "GltfLoader.h"
+
+#include "Json.h"
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    const uint32_t GLB_MAGIC = 0x46546C67;
+    const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+    const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+    const int32_t COMPONENT_BYTE = 5120;
+    const int32_t COMPONENT_UNSIGNED_BYTE = 5121;
+    const int32_t COMPONENT_SHORT = 5122;
+    const int32_t COMPONENT_UNSIGNED_SHORT = 5123;
+    const int32_t COMPONENT_UNSIGNED_INT = 5125;
+    const int32_t COMPONENT_FLOAT = 5126;
+
+    const int64_t MODE_TRIANGLES = 4;
+
+    struct GlbHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t length;
+    };
+
+    struct GlbChunkHeader
+    {
+        uint32_t length;
+        uint32_t type;
+    };
+
+    //A resolved and bounds checked accessor.
+    struct AccessorView
+    {
+        const uint8_t* data = nullptr;
+        uint32_t count = 0;
+        uint32_t stride = 0;
+        uint32_t componentSize = 0;
+        uint32_t componentCount = 0;
+        int32_t componentType = 0;
+        bool normalised = false;
+        //The view the accessor came from, used to spot interleaved streams.
+        int64_t bufferView = -1;
+        uint32_t offsetInView = 0;
+    };
+
+    uint32_t componentSizeOf(int32_t componentType)
+    {
+        switch (componentType)
+        {
+        case COMPONENT_BYTE:
+        case COMPONENT_UNSIGNED_BYTE:
+            return 1;
+        case COMPONENT_SHORT:
+        case COMPONENT_UNSIGNED_SHORT:
+            return 2;
+        case COMPONENT_UNSIGNED_INT:
+        case COMPONENT_FLOAT:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    uint32_t componentCountOf(const std::string& type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        if (type == "MAT2") return 4;
+        if (type == "MAT3") return 9;
+        if (type == "MAT4") return 16;
+        return 0;
+    }
+
+    bool isAligned(const void* pointer, size_t alignment)
+    {
+        return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+    }
+
+    //Reads one component as a float, applying the glTF rules for normalised
+    //integers.
+    float readComponent(const AccessorView& view, uint32_t element, uint32_t component)
+    {
+        if (view.data == nullptr)
+        {
+            return 0.f;
+        }
+
+        const uint8_t* source = view.data + static_cast<size_t>(element) * view.stride + component * view.componentSize;
+        switch (view.componentType)
+        {
+        case COMPONENT_FLOAT:
+        {
+            float value;
+            memcpy(&value, source, sizeof(value));
+            return value;
+        }
+        case COMPONENT_UNSIGNED_BYTE:
+            return view.normalised ? *source / 255.f : static_cast<float>(*source);
+        case COMPONENT_BYTE:
+        {
+            int8_t value = static_cast<int8_t>(*source);
+            return view.normalised ? std::max(value / 127.f, -1.f) : static_cast<float>(value);
+        }
+        case COMPONENT_UNSIGNED_SHORT:
+        {
+            uint16_t value;
+            memcpy(&value, source, sizeof(value));
+            return view.normalised ? value / 65535.f : static_cast<float>(value);
+        }
+        case COMPONENT_SHORT:
+        {
+            int16_t value;
+            memcpy(&value, source, sizeof(value));
+            return view.normalised ? std::max(value / 32767.f, -1.f) : static_cast<float>(value);
+        }
+        case COMPONENT_UNSIGNED_INT:
+        {
+            uint32_t value;
+            memcpy(&value, source, sizeof(value));
+            return static_cast<float>(value);
+        }
+        default:
+            return 0.f;
+        }
+    }
+
+    uint32_t readIndex(const AccessorView& view, uint32_t element)
+    {
+        const uint8_t* source = view.data + static_cast<size_t>(element) * view.stride;
+        switch (view.componentType)
+        {
+        case COMPONENT_UNSIGNED_BYTE:
+            return *source;
+        case COMPONENT_UNSIGNED_SHORT:
+        {
+            uint16_t value;
+            memcpy(&value, source, sizeof(value));
+            return value;
+        }
+        case COMPONENT_UNSIGNED_INT:
+        {
+            uint32_t value;
+            memcpy(&value, source, sizeof(value));
+            return value;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    //Uses the accessor in place when it is already tightly packed floats of
+    //the right width, otherwise converts into the stream's storage.
+    template<typename T>
+    void fillFloatStream(const AccessorView& view, Gust::ModelStream<T>& stream, uint32_t components)
+    {
+        if (view.data != nullptr && view.componentType == COMPONENT_FLOAT && view.componentCount == components &&
+            view.stride == sizeof(T) && isAligned(view.data, alignof(T)))
+        {
+            stream.data = reinterpret_cast<const T*>(view.data);
+            stream.count = view.count;
+            return;
+        }
+
+        stream.storage.resize(view.count);
+        uint32_t copied = std::min(components, view.componentCount);
+        for (uint32_t i = 0; i < view.count; i++)
+        {
+            float* out = reinterpret_cast<float*>(&stream.storage[i]);
+            for (uint32_t c = 0; c < copied; c++)
+            {
+                out[c] = readComponent(view, i, c);
+            }
+        }
+        stream.useStorage();
+    }
+
+    std::string directoryOf(const std::string& filePath)
+    {
+        size_t slash = filePath.find_last_of("/\\");
+        return slash == std::string::npos ? std::string() : filePath.substr(0, slash + 1);
+    }
+
+    int32_t textureImage(const Gust::JsonValue& document, const Gust::JsonValue& textureInfo)
+    {
+        if (textureInfo.isObject() == false)
+        {
+            return -1;
+        }
+
+        const Gust::JsonValue& texture = document["textures"][static_cast<size_t>(textureInfo["index"].asInt(-1))];
+        return static_cast<int32_t>(texture["source"].asInt(-1));
+    }
+}
+
+namespace Gust
+{
+    bool GltfLoader::load(const std::string& filePath, Model& model)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        auto startTime = std::chrono::steady_clock::now();
+
+        model = Model();
+        MappedFile file;
+        if (file.open(filePath) == false)
+        {
+            GUST_ERROR("Failed to open glTF file {0}", filePath);
+            return false;
+        }
+
+        const uint8_t* bytes = file.getData();
+        size_t size = file.getSize();
+
+        const char* jsonText = reinterpret_cast<const char*>(bytes);
+        size_t jsonSize = size;
+        const uint8_t* binaryChunk = nullptr;
+        size_t binaryChunkSize = 0;
+
+        GlbHeader header{};
+        if (size >= sizeof(header))
+        {
+            memcpy(&header, bytes, sizeof(header));
+        }
+
+        if (header.magic == GLB_MAGIC)
+        {
+            if (header.version != 2 || header.length > size)
+            {
+                GUST_ERROR("{0} is not a valid glTF 2.0 binary.", filePath);
+                return false;
+            }
+
+            //Chunks follow the header, JSON first then an optional BIN.
+            size_t offset = sizeof(header);
+            jsonText = nullptr;
+            while (offset + sizeof(GlbChunkHeader) <= header.length)
+            {
+                GlbChunkHeader chunk;
+                memcpy(&chunk, bytes + offset, sizeof(chunk));
+                offset += sizeof(chunk);
+                if (offset + chunk.length > header.length)
+                {
+                    GUST_ERROR("{0} has a truncated chunk.", filePath);
+                    return false;
+                }
+
+                if (chunk.type == GLB_CHUNK_JSON && jsonText == nullptr)
+                {
+                    jsonText = reinterpret_cast<const char*>(bytes + offset);
+                    jsonSize = chunk.length;
+                }
+                else if (chunk.type == GLB_CHUNK_BIN && binaryChunk == nullptr)
+                {
+                    binaryChunk = bytes + offset;
+                    binaryChunkSize = chunk.length;
+                }
+
+                //Chunks are padded to four bytes.
+                offset += (chunk.length + 3) & ~3u;
+            }
+
+            if (jsonText == nullptr)
+            {
+                GUST_ERROR("{0} has no JSON chunk.", filePath);
+                return false;
+            }
+        }
+
+        JsonValue document;
+        std::string error;
+        if (JsonValue::parse(jsonText, jsonSize, document, error) == false)
+        {
+            GUST_ERROR("Failed to parse {0}: {1}", filePath, error);
+            return false;
+        }
+
+        //The mapping has to outlive every stream pointing into it.
+        model.files.push_back(std::move(file));
+
+        std::vector<Buffer> buffers;
+        if (loadBuffers(document, filePath, binaryChunk, binaryChunkSize, model, buffers) == false ||
+            loadMeshes(document, buffers, model) == false)
+        {
+            model = Model();
+            return false;
+        }
+
+        loadMaterials(document, buffers, model);
+        loadNodes(document, model);
+
+        uint32_t primitiveCount = 0;
+        uint32_t zeroCopyStreams = 0;
+        uint32_t streamCount = 0;
+        for (const auto& mesh : model.meshes)
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                primitiveCount++;
+                streamCount += 2;
+                zeroCopyStreams += primitive.vertices.isZeroCopy() ? 1 : 0;
+                zeroCopyStreams += primitive.indices.isZeroCopy() ? 1 : 0;
+            }
+        }
+
+        float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        GUST_INFO("Loaded {0} in {1:.2f} ms: {2} meshes, {3} primitives, {4} nodes, {5}/{6} streams used in place.",
+                  filePath, milliseconds, model.meshes.size(), primitiveCount, model.nodes.size(), zeroCopyStreams, streamCount);
+        return true;
+    }
+
+    bool GltfLoader::loadBuffers(const JsonValue& document, const std::string& filePath, const uint8_t* binaryChunk, size_t binaryChunkSize,
+                                 Model& model, std::vector<Buffer>& buffers)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        const JsonValue& bufferList = document["buffers"];
+        for (size_t i = 0; i < bufferList.size(); i++)
+        {
+            const JsonValue& buffer = bufferList[i];
+            size_t byteLength = static_cast<size_t>(buffer["byteLength"].asInt());
+            const std::string& uri = buffer["uri"].asString();
+
+            if (uri.empty())
+            {
+                //Only the first buffer of a GLB may omit the uri, it is the
+                //BIN chunk.
+                if (i != 0 || binaryChunk == nullptr || byteLength > binaryChunkSize)
+                {
+                    GUST_ERROR("{0}: buffer {1} has no data.", filePath, i);
+                    return false;
+                }
+                buffers.push_back({ binaryChunk, byteLength });
+            }
+            else if (uri.compare(0, 5, "data:") == 0)
+            {
+                GUST_ERROR("{0}: embedded base64 buffers aren't supported, export as .glb instead.", filePath);
+                return false;
+            }
+            else
+            {
+                MappedFile external;
+                if (external.open(directoryOf(filePath) + uri) == false || external.getSize() < byteLength)
+                {
+                    GUST_ERROR("{0}: failed to map buffer {1}.", filePath, uri);
+                    return false;
+                }
+                buffers.push_back({ external.getData(), byteLength });
+                model.files.push_back(std::move(external));
+            }
+        }
+
+        return true;
+    }
+
+    bool GltfLoader::loadMeshes(const JsonValue& document, const std::vector<Buffer>& buffers, Model& model)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        const JsonValue& bufferViews = document["bufferViews"];
+        const JsonValue& accessors = document["accessors"];
+
+        auto resolveAccessor = [&](int64_t index, AccessorView& view) -> bool
+        {
+            const JsonValue& accessor = accessors[static_cast<size_t>(index)];
+            if (accessor.isObject() == false)
+            {
+                return false;
+            }
+
+            view = AccessorView();
+            view.count = static_cast<uint32_t>(accessor["count"].asInt());
+            view.componentType = static_cast<int32_t>(accessor["componentType"].asInt());
+            view.componentSize = componentSizeOf(view.componentType);
+            view.componentCount = componentCountOf(accessor["type"].asString());
+            view.normalised = accessor["normalized"].asBool();
+            if (view.componentSize == 0 || view.componentCount == 0)
+            {
+                return false;
+            }
+
+            if (accessor.contains("sparse"))
+            {
+                GUST_WARN("Sparse accessors aren't supported, accessor {0} is skipped.", index);
+                return false;
+            }
+
+            uint32_t elementSize = view.componentSize * view.componentCount;
+            view.stride = elementSize;
+
+            //No buffer view means every element is zero.
+            if (accessor.contains("bufferView") == false)
+            {
+                return true;
+            }
+
+            view.bufferView = accessor["bufferView"].asInt();
+            const JsonValue& bufferView = bufferViews[static_cast<size_t>(view.bufferView)];
+            int64_t bufferIndex = bufferView["buffer"].asInt(-1);
+            if (bufferIndex < 0 || static_cast<size_t>(bufferIndex) >= buffers.size())
+            {
+                return false;
+            }
+
+            const Buffer& buffer = buffers[static_cast<size_t>(bufferIndex)];
+            size_t viewOffset = static_cast<size_t>(bufferView["byteOffset"].asInt());
+            size_t viewLength = static_cast<size_t>(bufferView["byteLength"].asInt());
+            view.offsetInView = static_cast<uint32_t>(accessor["byteOffset"].asInt());
+            view.stride = static_cast<uint32_t>(bufferView["byteStride"].asInt(elementSize));
+
+            size_t needed = view.count == 0 ? 0 : static_cast<size_t>(view.offsetInView) + static_cast<size_t>(view.stride) * (view.count - 1) + elementSize;
+            if (viewOffset + viewLength > buffer.size || needed > viewLength || view.stride < elementSize)
+            {
+                GUST_ERROR("Accessor {0} reads outside its buffer view.", index);
+                return false;
+            }
+
+            view.data = buffer.data + viewOffset + view.offsetInView;
+            return true;
+        };
+
+        const JsonValue& meshes = document["meshes"];
+        model.meshes.resize(meshes.size());
+
+        for (size_t m = 0; m < meshes.size(); m++)
+        {
+            const JsonValue& mesh = meshes[m];
+            ModelMesh& modelMesh = model.meshes[m];
+            modelMesh.name = mesh["name"].asString();
+
+            const JsonValue& primitives = mesh["primitives"];
+            for (size_t p = 0; p < primitives.size(); p++)
+            {
+                const JsonValue& primitive = primitives[p];
+                if (primitive["mode"].asInt(MODE_TRIANGLES) != MODE_TRIANGLES)
+                {
+                    GUST_WARN("Mesh {0} primitive {1} isn't a triangle list, skipped.", modelMesh.name, p);
+                    continue;
+                }
+
+                const JsonValue& attributes = primitive["attributes"];
+                AccessorView positions;
+                if (resolveAccessor(attributes["POSITION"].asInt(-1), positions) == false || positions.componentCount != 3)
+                {
+                    GUST_ERROR("Mesh {0} primitive {1} has no usable positions.", modelMesh.name, p);
+                    return false;
+                }
+
+                AccessorView colours;
+                AccessorView texCoords;
+                AccessorView normals;
+                AccessorView tangents;
+                bool hasColours = attributes.contains("COLOR_0") && resolveAccessor(attributes["COLOR_0"].asInt(), colours);
+                bool hasTexCoords = attributes.contains("TEXCOORD_0") && resolveAccessor(attributes["TEXCOORD_0"].asInt(), texCoords);
+                bool hasNormals = attributes.contains("NORMAL") && resolveAccessor(attributes["NORMAL"].asInt(), normals);
+                bool hasTangents = attributes.contains("TANGENT") && resolveAccessor(attributes["TANGENT"].asInt(), tangents);
+
+                ModelPrimitive modelPrimitive;
+                modelPrimitive.material = static_cast<int32_t>(primitive["material"].asInt(-1));
+
+                //The vertex layout matches when position, colour and texture
+                //coordinates are floats interleaved in one view with the
+                //engine's stride and offsets.
+                bool matchesVertex = positions.data != nullptr && positions.componentType == COMPONENT_FLOAT &&
+                                     positions.stride == sizeof(CookedVertex) && isAligned(positions.data, alignof(CookedVertex)) &&
+                                     hasColours && colours.bufferView == positions.bufferView && colours.componentType == COMPONENT_FLOAT &&
+                                     colours.componentCount == 3 && colours.offsetInView == positions.offsetInView + offsetof(CookedVertex, colour) &&
+                                     hasTexCoords && texCoords.bufferView == positions.bufferView && texCoords.componentType == COMPONENT_FLOAT &&
+                                     texCoords.offsetInView == positions.offsetInView + offsetof(CookedVertex, texCoord) &&
+                                     colours.count == positions.count && texCoords.count == positions.count;
+
+                if (matchesVertex)
+                {
+                    modelPrimitive.vertices.data = reinterpret_cast<const CookedVertex*>(positions.data);
+                    modelPrimitive.vertices.count = positions.count;
+                }
+                else
+                {
+                    auto& vertices = modelPrimitive.vertices.storage;
+                    vertices.resize(positions.count);
+                    for (uint32_t i = 0; i < positions.count; i++)
+                    {
+                        CookedVertex& vertex = vertices[i];
+                        for (uint32_t c = 0; c < 3; c++)
+                        {
+                            vertex.pos[c] = readComponent(positions, i, c);
+                            //Untextured colour is white so the texture shows
+                            //through unchanged.
+                            vertex.colour[c] = hasColours && i < colours.count ? readComponent(colours, i, c) : 1.f;
+                        }
+                        for (uint32_t c = 0; c < 2; c++)
+                        {
+                            vertex.texCoord[c] = hasTexCoords && i < texCoords.count ? readComponent(texCoords, i, c) : 0.f;
+                        }
+                    }
+                    modelPrimitive.vertices.useStorage();
+                }
+
+                if (hasNormals && normals.count == positions.count)
+                {
+                    fillFloatStream(normals, modelPrimitive.normals, 3);
+                }
+                if (hasTangents && tangents.count == positions.count && tangents.componentCount == 4)
+                {
+                    fillFloatStream(tangents, modelPrimitive.tangents, 4);
+                }
+
+                if (primitive.contains("indices"))
+                {
+                    AccessorView indices;
+                    if (resolveAccessor(primitive["indices"].asInt(), indices) == false || indices.data == nullptr || indices.componentCount != 1)
+                    {
+                        GUST_ERROR("Mesh {0} primitive {1} has broken indices.", modelMesh.name, p);
+                        return false;
+                    }
+
+                    if (indices.componentType == COMPONENT_UNSIGNED_INT && indices.stride == sizeof(uint32_t) && isAligned(indices.data, alignof(uint32_t)))
+                    {
+                        modelPrimitive.indices.data = reinterpret_cast<const uint32_t*>(indices.data);
+                        modelPrimitive.indices.count = indices.count;
+                    }
+                    else
+                    {
+                        modelPrimitive.indices.storage.resize(indices.count);
+                        for (uint32_t i = 0; i < indices.count; i++)
+                        {
+                            modelPrimitive.indices.storage[i] = readIndex(indices, i);
+                        }
+                        modelPrimitive.indices.useStorage();
+                    }
+                }
+                else
+                {
+                    //Unindexed triangle lists still go through the indexed path.
+                    modelPrimitive.indices.storage.resize(positions.count);
+                    for (uint32_t i = 0; i < positions.count; i++)
+                    {
+                        modelPrimitive.indices.storage[i] = i;
+                    }
+                    modelPrimitive.indices.useStorage();
+                }
+
+                //Positions are required to carry their bounds, fall back to
+                //working them out for exporters that don't bother.
+                const JsonValue& accessor = accessors[static_cast<size_t>(attributes["POSITION"].asInt())];
+                if (accessor["min"].size() == 3 && accessor["max"].size() == 3)
+                {
+                    for (uint32_t c = 0; c < 3; c++)
+                    {
+                        modelPrimitive.boundsMin[c] = static_cast<float>(accessor["min"][c].asNumber());
+                        modelPrimitive.boundsMax[c] = static_cast<float>(accessor["max"][c].asNumber());
+                    }
+                }
+                else if (modelPrimitive.vertices.count > 0)
+                {
+                    modelPrimitive.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+                    modelPrimitive.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+                    for (uint32_t i = 0; i < modelPrimitive.vertices.count; i++)
+                    {
+                        glm::vec3 position = glm::make_vec3(modelPrimitive.vertices.data[i].pos);
+                        modelPrimitive.boundsMin = glm::min(modelPrimitive.boundsMin, position);
+                        modelPrimitive.boundsMax = glm::max(modelPrimitive.boundsMax, position);
+                    }
+                }
+
+                modelMesh.primitives.push_back(std::move(modelPrimitive));
+            }
+        }
+
+        return true;
+    }
+
+    void GltfLoader::loadMaterials(const JsonValue& document, const std::vector<Buffer>& buffers, Model& model)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        const JsonValue& materials = document["materials"];
+        model.materials.resize(materials.size());
+        for (size_t i = 0; i < materials.size(); i++)
+        {
+            const JsonValue& material = materials[i];
+            const JsonValue& pbr = material["pbrMetallicRoughness"];
+            ModelMaterial& modelMaterial = model.materials[i];
+
+            modelMaterial.name = material["name"].asString();
+            if (pbr["baseColorFactor"].size() == 4)
+            {
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    modelMaterial.baseColourFactor[c] = static_cast<float>(pbr["baseColorFactor"][c].asNumber(1.0));
+                }
+            }
+            modelMaterial.metallicFactor = static_cast<float>(pbr["metallicFactor"].asNumber(1.0));
+            modelMaterial.roughnessFactor = static_cast<float>(pbr["roughnessFactor"].asNumber(1.0));
+            modelMaterial.baseColourImage = textureImage(document, pbr["baseColorTexture"]);
+            modelMaterial.metallicRoughnessImage = textureImage(document, pbr["metallicRoughnessTexture"]);
+            modelMaterial.normalImage = textureImage(document, material["normalTexture"]);
+            modelMaterial.doubleSided = material["doubleSided"].asBool();
+        }
+
+        const JsonValue& bufferViews = document["bufferViews"];
+        const JsonValue& images = document["images"];
+        model.images.resize(images.size());
+        for (size_t i = 0; i < images.size(); i++)
+        {
+            const JsonValue& image = images[i];
+            ModelImage& modelImage = model.images[i];
+            modelImage.uri = image["uri"].asString();
+            modelImage.mimeType = image["mimeType"].asString();
+
+            //Images packed into the GLB stay encoded in the mapping until the
+            //texture loader decodes them.
+            if (image.contains("bufferView"))
+            {
+                const JsonValue& bufferView = bufferViews[static_cast<size_t>(image["bufferView"].asInt())];
+                int64_t bufferIndex = bufferView["buffer"].asInt(-1);
+                size_t offset = static_cast<size_t>(bufferView["byteOffset"].asInt());
+                size_t length = static_cast<size_t>(bufferView["byteLength"].asInt());
+                if (bufferIndex >= 0 && static_cast<size_t>(bufferIndex) < buffers.size() && offset + length <= buffers[bufferIndex].size)
+                {
+                    modelImage.data = buffers[bufferIndex].data + offset;
+                    modelImage.size = length;
+                }
+            }
+        }
+    }
+
+    void GltfLoader::loadNodes(const JsonValue& document, Model& model)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        const JsonValue& nodes = document["nodes"];
+        model.nodes.resize(nodes.size());
+
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            const JsonValue& node = nodes[i];
+            ModelNode& modelNode = model.nodes[i];
+            modelNode.name = node["name"].asString();
+            modelNode.mesh = static_cast<int32_t>(node["mesh"].asInt(-1));
+
+            if (node["matrix"].size() == 16)
+            {
+                float matrix[16];
+                for (uint32_t c = 0; c < 16; c++)
+                {
+                    matrix[c] = static_cast<float>(node["matrix"][c].asNumber());
+                }
+                //glTF matrices are column major like glm.
+                modelNode.localTransform = glm::make_mat4(matrix);
+            }
+            else
+            {
+                glm::vec3 translation(0.f);
+                glm::quat rotation(1.f, 0.f, 0.f, 0.f);
+                glm::vec3 scale(1.f);
+                if (node["translation"].size() == 3)
+                {
+                    translation = glm::vec3(node["translation"][0].asNumber(), node["translation"][1].asNumber(), node["translation"][2].asNumber());
+                }
+                if (node["rotation"].size() == 4)
+                {
+                    //glTF stores x, y, z, w but glm's constructor takes w first.
+                    rotation = glm::quat(static_cast<float>(node["rotation"][3].asNumber(1.0)), static_cast<float>(node["rotation"][0].asNumber()),
+                                         static_cast<float>(node["rotation"][1].asNumber()), static_cast<float>(node["rotation"][2].asNumber()));
+                }
+                if (node["scale"].size() == 3)
+                {
+                    scale = glm::vec3(node["scale"][0].asNumber(1.0), node["scale"][1].asNumber(1.0), node["scale"][2].asNumber(1.0));
+                }
+
+                modelNode.localTransform = glm::translate(glm::mat4(1.f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.f), scale);
+            }
+
+            const JsonValue& children = node["children"];
+            for (size_t c = 0; c < children.size(); c++)
+            {
+                int64_t child = children[c].asInt(-1);
+                if (child >= 0 && static_cast<size_t>(child) < nodes.size() && static_cast<size_t>(child) != i)
+                {
+                    modelNode.children.push_back(static_cast<uint32_t>(child));
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < model.nodes.size(); i++)
+        {
+            for (uint32_t child : model.nodes[i].children)
+            {
+                model.nodes[child].parent = static_cast<int32_t>(i);
+            }
+        }
+
+        //Use the default scene's roots when there is one, otherwise every
+        //node without a parent.
+        const JsonValue& scene = document["scenes"][static_cast<size_t>(document["scene"].asInt(0))];
+        if (scene["nodes"].size() > 0)
+        {
+            for (size_t i = 0; i < scene["nodes"].size(); i++)
+            {
+                int64_t root = scene["nodes"][i].asInt(-1);
+                if (root >= 0 && static_cast<size_t>(root) < model.nodes.size())
+                {
+                    model.rootNodes.push_back(static_cast<uint32_t>(root));
+                }
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < model.nodes.size(); i++)
+            {
+                if (model.nodes[i].parent < 0)
+                {
+                    model.rootNodes.push_back(i);
+                }
+            }
+        }
+
+        //Walk down from the roots. The visited list stops a malformed file
+        //with a cycle from looping forever.
+        std::vector<bool> visited(model.nodes.size(), false);
+        std::vector<uint32_t> stack(model.rootNodes.rbegin(), model.rootNodes.rend());
+        for (uint32_t root : model.rootNodes)
+        {
+            model.nodes[root].worldTransform = model.nodes[root].localTransform;
+        }
+
+        while (stack.empty() == false)
+        {
+            uint32_t index = stack.back();
+            stack.pop_back();
+            if (visited[index])
+            {
+                continue;
+            }
+            visited[index] = true;
+
+            for (uint32_t child : model.nodes[index].children)
+            {
+                model.nodes[child].worldTransform = model.nodes[index].worldTransform * model.nodes[child].localTransform;
+                stack.push_back(child);
+            }
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef GLTF_LOADER_HDR
+#define GLTF_LOADER_HDR
+
+#include "PreComp.h"
+
+#include "Model.h"
+
+namespace Gust
+{
+    class JsonValue;
+
+    //Loads glTF 2.0, either a binary .glb or a .gltf with external buffers.
+    //Files are mapped rather than read, and any accessor that already has the
+    //engine's layout is used in place. Only mismatched data gets converted.
+    class GltfLoader
+    {
+    public:
+        static bool load(const std::string& filePath, Model& model);
+    private:
+        struct Buffer
+        {
+            const uint8_t* data;
+            size_t size;
+        };
+
+        static bool loadBuffers(const JsonValue& document, const std::string& filePath, const uint8_t* binaryChunk, size_t binaryChunkSize,
+                                Model& model, std::vector<Buffer>& buffers);
+        static bool loadMeshes(const JsonValue& document, const std::vector<Buffer>& buffers, Model& model);
+        static void loadMaterials(const JsonValue& document, const std::vector<Buffer>& buffers, Model& model);
+        static void loadNodes(const JsonValue& document, Model& model);
+    };
+}
+
+#endif // !GLTF_LOADER_HDR
@@ -0,0 +1,419 @@
+#include "PreComp.h"
+#include "Json.h"
+
+#include <cstdlib>
+
+namespace
+{
+    const Gust::JsonValue NULL_VALUE;
+    const std::string EMPTY_STRING;
+
+    //Deep enough for any sane document while keeping a hostile one from
+    //running the stack out.
+    const uint32_t MAX_DEPTH = 256;
+
+    void appendUtf8(std::string& out, uint32_t codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            out += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+}
+
+namespace Gust
+{
+    //Recursive descent over the raw text. Stops at the first error.
+    class JsonParser
+    {
+    public:
+        JsonParser(const char* text, size_t length) : _cursor(text), _end(text + length)
+        {
+        }
+
+        bool parseDocument(JsonValue& root)
+        {
+            skipWhitespace();
+            if (parseValue(root, 0) == false)
+            {
+                return false;
+            }
+
+            skipWhitespace();
+            if (_cursor != _end)
+            {
+                return fail("trailing characters after the document");
+            }
+            return true;
+        }
+
+        const std::string& getError() const { return _error; }
+    private:
+        bool fail(const char* message)
+        {
+            if (_error.empty())
+            {
+                _error = message;
+            }
+            return false;
+        }
+
+        void skipWhitespace()
+        {
+            while (_cursor < _end && (*_cursor == ' ' || *_cursor == '\t' || *_cursor == '\n' || *_cursor == '\r'))
+            {
+                _cursor++;
+            }
+        }
+
+        bool match(const char* literal)
+        {
+            size_t length = strlen(literal);
+            if (static_cast<size_t>(_end - _cursor) < length || strncmp(_cursor, literal, length) != 0)
+            {
+                return false;
+            }
+            _cursor += length;
+            return true;
+        }
+
+        bool parseValue(JsonValue& value, uint32_t depth)
+        {
+            if (depth > MAX_DEPTH)
+            {
+                return fail("document is nested too deeply");
+            }
+
+            if (_cursor >= _end)
+            {
+                return fail("unexpected end of document");
+            }
+
+            switch (*_cursor)
+            {
+            case '{':
+                return parseObject(value, depth);
+            case '[':
+                return parseArray(value, depth);
+            case '"':
+                value._type = JsonValue::Type::STRING;
+                return parseString(value._string);
+            case 't':
+                value._type = JsonValue::Type::BOOLEAN;
+                value._boolean = true;
+                return match("true") || fail("bad literal");
+            case 'f':
+                value._type = JsonValue::Type::BOOLEAN;
+                value._boolean = false;
+                return match("false") || fail("bad literal");
+            case 'n':
+                value._type = JsonValue::Type::NUL;
+                return match("null") || fail("bad literal");
+            default:
+                return parseNumber(value);
+            }
+        }
+
+        bool parseNumber(JsonValue& value)
+        {
+            //strtod would happily run past the end of an unterminated buffer
+            //so copy the number out first.
+            const char* start = _cursor;
+            while (_cursor < _end && (isdigit(static_cast<unsigned char>(*_cursor)) || *_cursor == '-' || *_cursor == '+' ||
+                                      *_cursor == '.' || *_cursor == 'e' || *_cursor == 'E'))
+            {
+                _cursor++;
+            }
+
+            size_t length = static_cast<size_t>(_cursor - start);
+            if (length == 0 || length > 63)
+            {
+                return fail("bad number");
+            }
+
+            char buffer[64];
+            memcpy(buffer, start, length);
+            buffer[length] = '\0';
+
+            char* parsedEnd = nullptr;
+            value._type = JsonValue::Type::NUMBER;
+            value._number = strtod(buffer, &parsedEnd);
+            return parsedEnd == buffer + length || fail("bad number");
+        }
+
+        bool parseHex4(uint32_t& codeUnit)
+        {
+            if (_end - _cursor < 4)
+            {
+                return fail("truncated unicode escape");
+            }
+
+            codeUnit = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                char c = *_cursor++;
+                codeUnit <<= 4;
+                if (c >= '0' && c <= '9') codeUnit |= c - '0';
+                else if (c >= 'a' && c <= 'f') codeUnit |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F') codeUnit |= c - 'A' + 10;
+                else return fail("bad unicode escape");
+            }
+            return true;
+        }
+
+        bool parseString(std::string& out)
+        {
+            //Skip the opening quote.
+            _cursor++;
+
+            while (_cursor < _end)
+            {
+                char c = *_cursor++;
+                if (c == '"')
+                {
+                    return true;
+                }
+
+                if (c != '\\')
+                {
+                    out += c;
+                    continue;
+                }
+
+                if (_cursor >= _end)
+                {
+                    break;
+                }
+
+                char escape = *_cursor++;
+                switch (escape)
+                {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u':
+                {
+                    uint32_t codePoint = 0;
+                    if (parseHex4(codePoint) == false)
+                    {
+                        return false;
+                    }
+
+                    //Characters outside the BMP come as a surrogate pair.
+                    if (codePoint >= 0xD800 && codePoint <= 0xDBFF && match("\\u"))
+                    {
+                        uint32_t low = 0;
+                        if (parseHex4(low) == false)
+                        {
+                            return false;
+                        }
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, codePoint);
+                    break;
+                }
+                default:
+                    return fail("bad escape in string");
+                }
+            }
+
+            return fail("unterminated string");
+        }
+
+        bool parseArray(JsonValue& value, uint32_t depth)
+        {
+            value._type = JsonValue::Type::ARRAY;
+            _cursor++;
+
+            skipWhitespace();
+            if (_cursor < _end && *_cursor == ']')
+            {
+                _cursor++;
+                return true;
+            }
+
+            while (true)
+            {
+                skipWhitespace();
+                value._array.emplace_back();
+                if (parseValue(value._array.back(), depth + 1) == false)
+                {
+                    return false;
+                }
+
+                skipWhitespace();
+                if (_cursor < _end && *_cursor == ',')
+                {
+                    _cursor++;
+                    continue;
+                }
+                if (_cursor < _end && *_cursor == ']')
+                {
+                    _cursor++;
+                    return true;
+                }
+                return fail("expected , or ] in array");
+            }
+        }
+
+        bool parseObject(JsonValue& value, uint32_t depth)
+        {
+            value._type = JsonValue::Type::OBJECT;
+            _cursor++;
+
+            skipWhitespace();
+            if (_cursor < _end && *_cursor == '}')
+            {
+                _cursor++;
+                return true;
+            }
+
+            while (true)
+            {
+                skipWhitespace();
+                if (_cursor >= _end || *_cursor != '"')
+                {
+                    return fail("expected a member name");
+                }
+
+                value._object.emplace_back();
+                auto& member = value._object.back();
+                if (parseString(member.first) == false)
+                {
+                    return false;
+                }
+
+                skipWhitespace();
+                if (_cursor >= _end || *_cursor != ':')
+                {
+                    return fail("expected : after member name");
+                }
+                _cursor++;
+
+                skipWhitespace();
+                if (parseValue(member.second, depth + 1) == false)
+                {
+                    return false;
+                }
+
+                skipWhitespace();
+                if (_cursor < _end && *_cursor == ',')
+                {
+                    _cursor++;
+                    continue;
+                }
+                if (_cursor < _end && *_cursor == '}')
+                {
+                    _cursor++;
+                    return true;
+                }
+                return fail("expected , or } in object");
+            }
+        }
+    private:
+        const char* _cursor;
+        const char* _end;
+        std::string _error;
+    };
+
+    bool JsonValue::asBool(bool fallback) const
+    {
+        return _type == Type::BOOLEAN ? _boolean : fallback;
+    }
+
+    double JsonValue::asNumber(double fallback) const
+    {
+        return _type == Type::NUMBER ? _number : fallback;
+    }
+
+    int64_t JsonValue::asInt(int64_t fallback) const
+    {
+        return _type == Type::NUMBER ? static_cast<int64_t>(_number) : fallback;
+    }
+
+    const std::string& JsonValue::asString() const
+    {
+        return _type == Type::STRING ? _string : EMPTY_STRING;
+    }
+
+    size_t JsonValue::size() const
+    {
+        if (_type == Type::ARRAY)
+        {
+            return _array.size();
+        }
+        if (_type == Type::OBJECT)
+        {
+            return _object.size();
+        }
+        return 0;
+    }
+
+    const JsonValue& JsonValue::operator[](size_t index) const
+    {
+        if (_type != Type::ARRAY || index >= _array.size())
+        {
+            return NULL_VALUE;
+        }
+        return _array[index];
+    }
+
+    //Objects are kept in document order and glTF objects are small, so a
+    //linear search beats building a map for every one of them.
+    const JsonValue& JsonValue::operator[](const std::string& key) const
+    {
+        if (_type == Type::OBJECT)
+        {
+            for (const auto& member : _object)
+            {
+                if (member.first == key)
+                {
+                    return member.second;
+                }
+            }
+        }
+        return NULL_VALUE;
+    }
+
+    bool JsonValue::contains(const std::string& key) const
+    {
+        return (*this)[key].isNull() == false;
+    }
+
+    bool JsonValue::parse(const char* text, size_t length, JsonValue& root, std::string& error)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        root = JsonValue();
+        JsonParser parser(text, length);
+        if (parser.parseDocument(root) == false)
+        {
+            error = parser.getError();
+            return false;
+        }
+        return true;
+    }
+}
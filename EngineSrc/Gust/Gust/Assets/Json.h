@@ -0,0 +1,57 @@
+#ifndef JSON_HDR
+#define JSON_HDR
+
+#include "PreComp.h"
+
+namespace Gust
+{
+    //A small read only JSON document, enough for glTF and config files.
+    //Looking up something that isn't there gives back a null value rather
+    //than failing, so optional fields can be read without checks everywhere.
+    class JsonValue
+    {
+    public:
+        enum class Type
+        {
+            NUL,
+            BOOLEAN,
+            NUMBER,
+            STRING,
+            ARRAY,
+            OBJECT
+        };
+
+        Type getType() const { return _type; }
+        bool isNull() const { return _type == Type::NUL; }
+        bool isNumber() const { return _type == Type::NUMBER; }
+        bool isString() const { return _type == Type::STRING; }
+        bool isArray() const { return _type == Type::ARRAY; }
+        bool isObject() const { return _type == Type::OBJECT; }
+
+        bool asBool(bool fallback = false) const;
+        double asNumber(double fallback = 0.0) const;
+        int64_t asInt(int64_t fallback = 0) const;
+        const std::string& asString() const;
+
+        //Number of elements in an array or members in an object.
+        size_t size() const;
+        const JsonValue& operator[](size_t index) const;
+        const JsonValue& operator[](const std::string& key) const;
+        bool contains(const std::string& key) const;
+
+        const std::vector<std::pair<std::string, JsonValue>>& getMembers() const { return _object; }
+
+        static bool parse(const char* text, size_t length, JsonValue& root, std::string& error);
+    private:
+        friend class JsonParser;
+
+        Type _type = Type::NUL;
+        bool _boolean = false;
+        double _number = 0.0;
+        std::string _string;
+        std::vector<JsonValue> _array;
+        std::vector<std::pair<std::string, JsonValue>> _object;
+    };
+}
+
+#endif // !JSON_HDR
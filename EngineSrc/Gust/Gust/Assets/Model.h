@@ -0,0 +1,100 @@
+#ifndef MODEL_HDR
+#define MODEL_HDR
+
+#include "PreComp.h"
+
+#include "CookedFormats.h"
+#include "Gust/Core/MappedFile.h"
+
+#include <glm/glm.hpp>
+
+namespace Gust
+{
+    //A run of elements that either points straight into a mapped file or,
+    //when the source layout didn't match, into storage owned by the stream.
+    template<typename T>
+    struct ModelStream
+    {
+        const T* data = nullptr;
+        uint32_t count = 0;
+        std::vector<T> storage;
+
+        bool isEmpty() const { return count == 0; }
+        bool isZeroCopy() const { return data != nullptr && storage.empty(); }
+
+        void useStorage()
+        {
+            data = storage.data();
+            count = static_cast<uint32_t>(storage.size());
+        }
+    };
+
+    struct ModelPrimitive
+    {
+        //Laid out exactly like the renderer's vertex so it can be uploaded
+        //as is.
+        ModelStream<CookedVertex> vertices;
+        ModelStream<uint32_t> indices;
+        //Optional, empty when the source doesn't have them.
+        ModelStream<glm::vec3> normals;
+        ModelStream<glm::vec4> tangents;
+
+        int32_t material = -1;
+        glm::vec3 boundsMin = glm::vec3(0.f);
+        glm::vec3 boundsMax = glm::vec3(0.f);
+    };
+
+    struct ModelMesh
+    {
+        std::string name;
+        std::vector<ModelPrimitive> primitives;
+    };
+
+    struct ModelNode
+    {
+        std::string name;
+        int32_t mesh = -1;
+        int32_t parent = -1;
+        std::vector<uint32_t> children;
+        glm::mat4 localTransform = glm::mat4(1.f);
+        glm::mat4 worldTransform = glm::mat4(1.f);
+    };
+
+    //Texture slots are indices into Model::images, -1 when unused.
+    struct ModelMaterial
+    {
+        std::string name;
+        glm::vec4 baseColourFactor = glm::vec4(1.f);
+        float metallicFactor = 1.f;
+        float roughnessFactor = 1.f;
+        int32_t baseColourImage = -1;
+        int32_t metallicRoughnessImage = -1;
+        int32_t normalImage = -1;
+        bool doubleSided = false;
+    };
+
+    //Either an external file or encoded bytes embedded in a buffer, in which
+    //case data points into the mapping.
+    struct ModelImage
+    {
+        std::string uri;
+        std::string mimeType;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    //A whole scene as the engine sees it. Streams can point into the mapped
+    //files so the model owns them, and it can be moved but not copied.
+    struct Model
+    {
+        std::vector<ModelMesh> meshes;
+        std::vector<ModelNode> nodes;
+        std::vector<uint32_t> rootNodes;
+        std::vector<ModelMaterial> materials;
+        std::vector<ModelImage> images;
+
+        std::vector<MappedFile> files;
+    };
+}
+
+#endif // !MODEL_HDR
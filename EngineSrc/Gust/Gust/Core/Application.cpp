@@ -9,7 +9,10 @@
 #include "Layer.h"
 #include "Input.h"
 
+#include "Gust/Scene/SceneFile.h"
+
 #include <GLFW/glfw3.h>
+#include <chrono>
 
 namespace Gust
 {
@@ -26,6 +29,7 @@ namespace Gust
 
         _window = Window::create(WindowProps(title));
         _window->setCallbackFunction(std::bind(&Application::onEvent, this, std::placeholders::_1));
+        _window->setScene(&_scene);
 
         //Renderer::init();
     }
@@ -146,6 +150,34 @@ namespace Gust
         _layerStack.popOverlay(layer);
     }
 
+    //The level is mapped and used in place, so the only work is checking the
+    //offsets and copying the arrays into the scene.
+    bool Application::loadLevel(const std::string& filePath)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        auto startTime = std::chrono::steady_clock::now();
+
+        SceneFile level;
+        if (level.open(filePath) == false)
+        {
+            return false;
+        }
+
+        auto mappedTime = std::chrono::steady_clock::now();
+        _scene.instantiate(level);
+        auto endTime = std::chrono::steady_clock::now();
+
+        GUST_INFO("Loaded level {0}: {1} objects in {2:.2f} ms (map {3:.2f} ms, instantiate {4:.2f} ms).", filePath, level.getHeader().objects.count,
+                  std::chrono::duration<float, std::milli>(endTime - startTime).count(),
+                  std::chrono::duration<float, std::milli>(mappedTime - startTime).count(),
+                  std::chrono::duration<float, std::milli>(endTime - mappedTime).count());
+
+        //The window rebuilds its streaming cells from the new objects.
+        _window->setScene(&_scene);
+        return true;
+    }
+
     void Application::close()
     {
         _running = false;
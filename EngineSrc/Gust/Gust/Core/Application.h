@@ -8,6 +8,7 @@
 #include "LayerStack.h"
 
 #include "TimeStep.h"
+#include "Gust/Scene/Scene.h"
 
 namespace Gust
 {
@@ -31,6 +32,10 @@ namespace Gust
 
         inline static Application& get() { return *_instance; }
         inline Window& getWindow() const { return *_window;  }
+        inline Scene& getScene() { return _scene; }
+
+        //Adds every object in a cooked level to the scene.
+        bool loadLevel(const std::string& filePath);
 
         void close();
     private:
@@ -42,6 +47,7 @@ namespace Gust
         std::unique_ptr<Window> _window;
         //Used for things like ImGuiLayers that need to be on top of every layer.
         LayerStack _layerStack;
+        Scene _scene;
 
         float _lastFrameTime  = 0.f;
         static Application* _instance;
@@ -0,0 +1,64 @@
+#include "PreComp.h"
+#include "FileWatcher.h"
+
+namespace
+{
+    //Atomic writers, including GustCook, write a temp file then rename it.
+    //Only the final name is interesting.
+    bool isTemporaryFile(const std::string& path)
+    {
+        const std::string suffix = ".tmp";
+        return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+namespace Gust
+{
+    FileWatcher::FileWatcher(const std::string& rootDirectory, float debounceSeconds) :
+        _rootDirectory(rootDirectory), _debounce(debounceSeconds)
+    {
+    }
+
+    void FileWatcher::poll(std::vector<FileChange>& changes)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        auto now = std::chrono::steady_clock::now();
+
+        _events.clear();
+        readEvents(_events);
+
+        for (auto& path : _events)
+        {
+            if (isTemporaryFile(path))
+            {
+                continue;
+            }
+
+            std::replace(path.begin(), path.end(), '\\', '/');
+
+            auto found = _pending.find(path);
+            if (found == _pending.end())
+            {
+                _pending.emplace(path, PendingChange{ now, now });
+            }
+            else
+            {
+                found->second.lastSeen = now;
+            }
+        }
+
+        for (auto it = _pending.begin(); it != _pending.end();)
+        {
+            if (now - it->second.lastSeen >= _debounce)
+            {
+                changes.push_back({ it->first, it->second.firstSeen });
+                it = _pending.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef FILE_WATCHER_HDR
+#define FILE_WATCHER_HDR
+
+#include "PreComp.h"
+
+#include <chrono>
+
+namespace Gust
+{
+    struct FileChange
+    {
+        //Relative to the working directory with forward slashes, so it
+        //matches the paths the engine loads assets with.
+        std::string path;
+        //When the first event of the burst arrived, used to report how long
+        //a reload really took.
+        std::chrono::steady_clock::time_point firstSeen;
+    };
+
+    //Watches a directory tree for files being written. Editors and the cooker
+    //tend to write a file several times in a row so changes are held back
+    //until the file has been quiet for the debounce time.
+    class FileWatcher
+    {
+    public:
+        FileWatcher(const std::string& rootDirectory, float debounceSeconds);
+        virtual ~FileWatcher() = default;
+
+        //Non-blocking, meant to be called once a frame.
+        void poll(std::vector<FileChange>& changes);
+
+        const std::string& getRootDirectory() const { return _rootDirectory; }
+
+        //Implemented by the platform specific watcher.
+        static std::unique_ptr<FileWatcher> create(const std::string& rootDirectory, float debounceSeconds = 0.2f);
+    protected:
+        //Appends the raw paths of anything written since the last call.
+        virtual void readEvents(std::vector<std::string>& paths) = 0;
+    private:
+        struct PendingChange
+        {
+            std::chrono::steady_clock::time_point firstSeen;
+            std::chrono::steady_clock::time_point lastSeen;
+        };
+
+        std::string _rootDirectory;
+        std::chrono::duration<float> _debounce;
+        std::unordered_map<std::string, PendingChange> _pending;
+        std::vector<std::string> _events;
+    };
+}
+
+#endif // !FILE_WATCHER_HDR
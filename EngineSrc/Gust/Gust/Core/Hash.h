@@ -0,0 +1,41 @@
+#ifndef HASH_HDR
+#define HASH_HDR
+
+#include "PreComp.h"
+
+namespace Gust
+{
+    //64 bit FNV-1a, the same as GustCook uses. Fine for cache keys, it isn't
+    //meant to stand up to anyone trying to make collisions.
+    const uint64_t HASH_SEED = 14695981039346656037ull;
+
+    inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = HASH_SEED)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = seed;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    inline uint64_t hashString(const std::string& text, uint64_t seed = HASH_SEED)
+    {
+        //The length goes in too so "ab" + "c" and "a" + "bc" differ.
+        uint64_t size = text.size();
+        return hashBytes(text.data(), text.size(), hashBytes(&size, sizeof(size), seed));
+    }
+
+    //Only for plain types with no padding, or the padding bytes get hashed.
+    template<typename T>
+    uint64_t hashValue(const T& value, uint64_t seed = HASH_SEED)
+    {
+        return hashBytes(&value, sizeof(T), seed);
+    }
+}
+
+#endif // !HASH_HDR
@@ -0,0 +1,32 @@
+#include "PreComp.h"
+#include "MappedFile.h"
+
+namespace Gust
+{
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept :
+        _data(other._data), _size(other._size), _file(other._file), _mapping(other._mapping)
+    {
+        other._data = nullptr;
+        other._size = 0;
+        other._file = nullptr;
+        other._mapping = nullptr;
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            std::swap(_data, other._data);
+            std::swap(_size, other._size);
+            std::swap(_file, other._file);
+            std::swap(_mapping, other._mapping);
+        }
+        return *this;
+    }
+}
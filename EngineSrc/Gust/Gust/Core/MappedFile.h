@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_HDR
+#define MAPPED_FILE_HDR
+
+#include "PreComp.h"
+
+namespace Gust
+{
+    //A read only view of a whole file mapped into memory. Loaders can point
+    //straight into the mapping instead of copying, the OS pages it in on
+    //demand. The open and close functions are implemented per platform.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        bool open(const std::string& filePath);
+        void close();
+
+        bool isOpen() const { return _data != nullptr; }
+        const uint8_t* getData() const { return _data; }
+        size_t getSize() const { return _size; }
+    private:
+        const uint8_t* _data = nullptr;
+        size_t _size = 0;
+        //The platform file and mapping handles.
+        void* _file = nullptr;
+        void* _mapping = nullptr;
+    };
+}
+
+#endif // !MAPPED_FILE_HDR
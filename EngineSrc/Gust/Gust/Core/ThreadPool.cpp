@@ -0,0 +1,73 @@
+#include "PreComp.h"
+#include "ThreadPool.h"
+
+namespace Gust
+{
+    ThreadPool::ThreadPool(uint32_t threadCount)
+    {
+        if (threadCount == 0)
+        {
+            uint32_t cores = std::thread::hardware_concurrency();
+            threadCount = cores > 1 ? cores - 1 : 1;
+        }
+
+        _workers.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            _workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _condition.notify_all();
+
+        for (auto& worker : _workers)
+        {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.push_back(std::move(job));
+        }
+        _condition.notify_one();
+    }
+
+    ThreadPool& ThreadPool::get()
+    {
+        static ThreadPool instance;
+        return instance;
+    }
+
+    //Workers finish whatever is left in the queue before stopping so nothing
+    //that was submitted is silently dropped.
+    void ThreadPool::workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _condition.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+
+                if (_jobs.empty())
+                {
+                    return;
+                }
+
+                job = std::move(_jobs.front());
+                _jobs.pop_front();
+            }
+
+            job();
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef THREAD_POOL_HDR
+#define THREAD_POOL_HDR
+
+#include "PreComp.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Gust
+{
+    //A fixed set of worker threads pulling jobs off a shared queue. Used for
+    //anything that would otherwise stall the frame, like loading assets.
+    class ThreadPool
+    {
+    public:
+        //A thread count of zero leaves one core free for the main thread.
+        ThreadPool(uint32_t threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(std::function<void()> job);
+
+        uint32_t getThreadCount() const { return static_cast<uint32_t>(_workers.size()); }
+
+        //The engine wide pool, created the first time it's asked for.
+        static ThreadPool& get();
+    private:
+        void workerLoop();
+    private:
+        std::vector<std::thread> _workers;
+        std::deque<std::function<void()>> _jobs;
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        bool _stopping = false;
+    };
+}
+
+#endif // !THREAD_POOL_HDR
@@ -4,10 +4,13 @@
 #include "PreComp.h"
 
 #include "Gust/Events/Event.h"
+#include "Gust/Renderer/GpuMemoryStats.h"
 #include "Core.h"
 
 namespace Gust 
 {
+    class Scene;
+
     //This structure holds the window properties of the window 
     struct WindowProps
     {
@@ -45,6 +48,12 @@ namespace Gust
 
         virtual void waitDevice() = 0;
 
+        //The scene the window draws and streams from. Set again whenever the
+        //scene's contents are replaced.
+        virtual void setScene(Scene* scene) = 0;
+
+        virtual GpuMemoryStats getGpuMemoryStats() const = 0;
+
         //As every window need to be create with properties this static
         //function should be implemented on the platform specific class.
         static std::unique_ptr<Window> create(const WindowProps& props = WindowProps());
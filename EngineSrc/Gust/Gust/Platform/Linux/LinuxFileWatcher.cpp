@@ -0,0 +1,148 @@
+#include "PreComp.h"
+
+#ifdef __linux__
+
+#include "LinuxFileWatcher.h"
+
+#include <filesystem>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace
+{
+    const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE_SELF;
+}
+
+namespace Gust
+{
+    std::unique_ptr<FileWatcher> FileWatcher::create(const std::string& rootDirectory, float debounceSeconds)
+    {
+        return std::make_unique<LinuxFileWatcher>(rootDirectory, debounceSeconds);
+    }
+
+    LinuxFileWatcher::LinuxFileWatcher(const std::string& rootDirectory, float debounceSeconds) :
+        FileWatcher(rootDirectory, debounceSeconds)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        _inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (_inotify < 0)
+        {
+            GUST_WARN("inotify_init1 failed ({0}), hot reload is disabled.", errno);
+            return;
+        }
+
+        addWatchRecursive(rootDirectory);
+    }
+
+    LinuxFileWatcher::~LinuxFileWatcher()
+    {
+        if (_inotify >= 0)
+        {
+            //Closing the descriptor drops every watch with it.
+            close(_inotify);
+        }
+    }
+
+    void LinuxFileWatcher::addWatch(const std::string& directory)
+    {
+        int watch = inotify_add_watch(_inotify, directory.c_str(), WATCH_MASK);
+        if (watch < 0)
+        {
+            GUST_WARN("Unable to watch {0} ({1}).", directory, errno);
+            return;
+        }
+
+        _watches[watch] = directory;
+    }
+
+    void LinuxFileWatcher::addWatchRecursive(const std::string& directory)
+    {
+        std::error_code error;
+        if (std::filesystem::is_directory(directory, error) == false)
+        {
+            GUST_WARN("Unable to watch {0}, it is not a directory.", directory);
+            return;
+        }
+
+        addWatch(directory);
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error))
+        {
+            if (entry.is_directory(error))
+            {
+                addWatch(entry.path().generic_string());
+            }
+        }
+    }
+
+    void LinuxFileWatcher::readEvents(std::vector<std::string>& paths)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        if (_inotify < 0)
+        {
+            return;
+        }
+
+        alignas(inotify_event) char buffer[16 * 1024];
+        while (true)
+        {
+            ssize_t length = read(_inotify, buffer, sizeof(buffer));
+            if (length <= 0)
+            {
+                //EAGAIN, the queue is drained.
+                break;
+            }
+
+            for (char* cursor = buffer; cursor < buffer + length;)
+            {
+                auto event = reinterpret_cast<inotify_event*>(cursor);
+                cursor += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_IGNORED)
+                {
+                    _watches.erase(event->wd);
+                    continue;
+                }
+
+                auto watch = _watches.find(event->wd);
+                if (watch == _watches.end() || event->len == 0)
+                {
+                    continue;
+                }
+
+                std::string path = watch->second + "/" + event->name;
+                if (event->mask & IN_ISDIR)
+                {
+                    //A new folder may already have files in it by the time
+                    //the watch lands so report those too.
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    {
+                        addWatchRecursive(path);
+
+                        std::error_code error;
+                        for (const auto& entry : std::filesystem::recursive_directory_iterator(path, error))
+                        {
+                            if (entry.is_regular_file(error))
+                            {
+                                paths.push_back(entry.path().generic_string());
+                            }
+                        }
+                    }
+                    continue;
+                }
+
+                //IN_CREATE on a file fires before anything is written, wait
+                //for the close instead.
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                {
+                    paths.push_back(path);
+                }
+            }
+        }
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,30 @@
+#ifndef LINUX_FILE_WATCHER_HDR
+#define LINUX_FILE_WATCHER_HDR
+
+#ifdef __linux__
+
+#include "Gust/Core/FileWatcher.h"
+
+namespace Gust
+{
+    //inotify only watches a single directory so every sub directory gets its
+    //own watch, including ones created while we're running.
+    class LinuxFileWatcher : public FileWatcher
+    {
+    public:
+        LinuxFileWatcher(const std::string& rootDirectory, float debounceSeconds);
+        virtual ~LinuxFileWatcher();
+    protected:
+        virtual void readEvents(std::vector<std::string>& paths) override;
+    private:
+        void addWatch(const std::string& directory);
+        void addWatchRecursive(const std::string& directory);
+    private:
+        int _inotify = -1;
+        std::unordered_map<int, std::string> _watches;
+    };
+}
+
+#endif // __linux__
+
+#endif // !LINUX_FILE_WATCHER_HDR
@@ -0,0 +1,60 @@
+#include "PreComp.h"
+
+#ifdef __linux__
+
+#include "Gust/Core/MappedFile.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Gust
+{
+    bool MappedFile::open(const std::string& filePath)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        close();
+
+        int file = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0)
+        {
+            return false;
+        }
+
+        struct stat status{};
+        if (fstat(file, &status) != 0 || status.st_size == 0)
+        {
+            ::close(file);
+            return false;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        //The mapping keeps its own reference to the file.
+        ::close(file);
+        if (view == MAP_FAILED)
+        {
+            return false;
+        }
+
+        _data = static_cast<const uint8_t*>(view);
+        _size = static_cast<size_t>(status.st_size);
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (_data != nullptr)
+        {
+            munmap(const_cast<uint8_t*>(_data), _size);
+        }
+
+        _data = nullptr;
+        _size = 0;
+        _file = nullptr;
+        _mapping = nullptr;
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,111 @@
+#include "PreComp.h"
+
+#ifdef _WIN32
+
+#include "WindowsFileWatcher.h"
+
+namespace Gust
+{
+    std::unique_ptr<FileWatcher> FileWatcher::create(const std::string& rootDirectory, float debounceSeconds)
+    {
+        return std::make_unique<WindowsFileWatcher>(rootDirectory, debounceSeconds);
+    }
+
+    WindowsFileWatcher::WindowsFileWatcher(const std::string& rootDirectory, float debounceSeconds) :
+        FileWatcher(rootDirectory, debounceSeconds)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        _directory = CreateFileA(rootDirectory.c_str(), FILE_LIST_DIRECTORY,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                 OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (_directory == INVALID_HANDLE_VALUE)
+        {
+            GUST_WARN("Unable to watch {0} for changes, hot reload is disabled.", rootDirectory);
+            return;
+        }
+
+        _overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        queueRead();
+    }
+
+    WindowsFileWatcher::~WindowsFileWatcher()
+    {
+        if (_directory != INVALID_HANDLE_VALUE)
+        {
+            CancelIoEx(_directory, &_overlapped);
+            if (_readPending)
+            {
+                DWORD bytes = 0;
+                GetOverlappedResult(_directory, &_overlapped, &bytes, TRUE);
+            }
+            CloseHandle(_directory);
+        }
+
+        if (_overlapped.hEvent != nullptr)
+        {
+            CloseHandle(_overlapped.hEvent);
+        }
+    }
+
+    bool WindowsFileWatcher::queueRead()
+    {
+        ResetEvent(_overlapped.hEvent);
+        _readPending = ReadDirectoryChangesW(_directory, _buffer, sizeof(_buffer), TRUE,
+                                             FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+                                             nullptr, &_overlapped, nullptr) != FALSE;
+        return _readPending;
+    }
+
+    void WindowsFileWatcher::readEvents(std::vector<std::string>& paths)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        if (_readPending == false)
+        {
+            return;
+        }
+
+        DWORD bytes = 0;
+        if (GetOverlappedResult(_directory, &_overlapped, &bytes, FALSE) == FALSE)
+        {
+            if (GetLastError() != ERROR_IO_INCOMPLETE)
+            {
+                GUST_WARN("Lost the directory watch on {0}.", getRootDirectory());
+                _readPending = false;
+            }
+            return;
+        }
+
+        //Zero bytes means the buffer overflowed and the events were dropped.
+        //Nothing can be done about that other than carry on watching.
+        if (bytes != 0)
+        {
+            const uint8_t* cursor = _buffer;
+            while (true)
+            {
+                auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cursor);
+                if (info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_ADDED ||
+                    info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+                {
+                    int wideLength = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+                    int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, nullptr, 0, nullptr, nullptr);
+                    std::string name(length, '\0');
+                    WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, name.data(), length, nullptr, nullptr);
+
+                    paths.push_back(getRootDirectory() + "/" + name);
+                }
+
+                if (info->NextEntryOffset == 0)
+                {
+                    break;
+                }
+                cursor += info->NextEntryOffset;
+            }
+        }
+
+        queueRead();
+    }
+}
+
+#endif // _WIN32
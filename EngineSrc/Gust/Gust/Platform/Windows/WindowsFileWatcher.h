@@ -0,0 +1,32 @@
+#ifndef WINDOWS_FILE_WATCHER_HDR
+#define WINDOWS_FILE_WATCHER_HDR
+
+#ifdef _WIN32
+
+#include "Gust/Core/FileWatcher.h"
+
+#include <Windows.h>
+
+namespace Gust
+{
+    //Uses ReadDirectoryChangesW with overlapped IO so polling never blocks.
+    class WindowsFileWatcher : public FileWatcher
+    {
+    public:
+        WindowsFileWatcher(const std::string& rootDirectory, float debounceSeconds);
+        virtual ~WindowsFileWatcher();
+    protected:
+        virtual void readEvents(std::vector<std::string>& paths) override;
+    private:
+        bool queueRead();
+    private:
+        HANDLE _directory = INVALID_HANDLE_VALUE;
+        OVERLAPPED _overlapped{};
+        alignas(DWORD) uint8_t _buffer[64 * 1024];
+        bool _readPending = false;
+    };
+}
+
+#endif // _WIN32
+
+#endif // !WINDOWS_FILE_WATCHER_HDR
@@ -0,0 +1,69 @@
+#include "PreComp.h"
+
+#ifdef _WIN32
+
+#include "Gust/Core/MappedFile.h"
+
+#include <Windows.h>
+
+namespace Gust
+{
+    bool MappedFile::open(const std::string& filePath)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        close();
+
+        HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize{};
+        if (GetFileSizeEx(file, &fileSize) == FALSE || fileSize.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        _data = static_cast<const uint8_t*>(view);
+        _size = static_cast<size_t>(fileSize.QuadPart);
+        _file = file;
+        _mapping = mapping;
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (_data != nullptr)
+        {
+            UnmapViewOfFile(_data);
+            CloseHandle(static_cast<HANDLE>(_mapping));
+            CloseHandle(static_cast<HANDLE>(_file));
+        }
+
+        _data = nullptr;
+        _size = 0;
+        _file = nullptr;
+        _mapping = nullptr;
+    }
+}
+
+#endif // _WIN32
@@ -7,12 +7,33 @@
 #include "Gust/Events/Event.h"
 
 #include "Gust/Core/Core.h"
+#include "Gust/Assets/CookedAssets.h"
+#include "Gust/Assets/AssetReloader.h"
+#include "Gust/Scene/Scene.h"
+#include "Gust/Scene/SceneFormat.h"
+#include "Gust/Scene/WorldStreamer.h"
+#include "Gust/Renderer/StagingRing.h"
+#include "Gust/Renderer/FrameAllocator.h"
+#include "Gust/Renderer/DescriptorAllocator.h"
+#include "Gust/Renderer/BindlessDescriptors.h"
+#include "Gust/Renderer/GeometryArena.h"
+#include "Gust/Renderer/DeletionQueue.h"
+#include "Gust/Renderer/MemoryBudget.h"
+#include "Gust/Renderer/GpuResources.h"
+#include "Gust/Renderer/PipelineCache.h"
+#include "Gust/Renderer/PipelineManager.h"
+#include "Gust/Renderer/ShaderCompiler.h"
+#include "Gust/Renderer/ShaderVariants.h"
+#include "Gust/Renderer/ShaderReflection.h"
+#include "Gust/Renderer/LayoutCache.h"
+#include "Gust/Renderer/RenderPassCache.h"
 
 #include <stb_image.h>
 #include <cstdlib>
 #include <optional>
 #include <limits>
 #include <chrono>
+#include <filesystem>
 
 namespace
 {
@@ -71,29 +92,72 @@ namespace
         }
     }
 
-    const std::string MODEL_PATH = "Assets/Models/viking_room.obj";
-    const std::string TEXTURE_PATH = "Assets/Textures/viking_room.png";
-
+    //Fragmentation is checked every so often rather than every frame, and a
+    //pass only moves a bounded amount so it never shows up as a spike.
+    const uint64_t DEFRAGMENTATION_CHECK_INTERVAL = 120;
+    const float DEFRAGMENTATION_THRESHOLD = 0.3f;
+    const VkDeviceSize DEFRAGMENTATION_MIN_FREE_BYTES = 4 * 1024 * 1024;
+    const VkDeviceSize DEFRAGMENTATION_BYTES_PER_PASS = 8 * 1024 * 1024;
+    const uint32_t DEFRAGMENTATION_ALLOCATIONS_PER_PASS = 64;
+
+    //Enough for a few frames of streamed meshes. Bigger uploads still work,
+    //they just get a buffer of their own.
+    const VkDeviceSize STAGING_RING_SIZE = 32 * 1024 * 1024;
+
+    //Every mesh shares these, 128 MB of vertices and 64 MB of indices.
+    const uint32_t GEOMETRY_VERTEX_CAPACITY = 4 * 1024 * 1024;
+    const uint32_t GEOMETRY_INDEX_CAPACITY = 16 * 1024 * 1024;
+
+    //Per frame uniform data. Thousands of objects' worth at 256 bytes each.
+    const VkDeviceSize FRAME_UNIFORM_SIZE = 1024 * 1024;
+
+    const std::string MODEL_PATH = "Assets/Models/viking_room.gmesh";
+    const std::string TEXTURE_PATH = "Assets/Textures/viking_room.gtex";
+    const std::string DEFAULT_VERTEX_SHADER = "Assets/Shaders/simple_shader.vert.spv";
+    const std::string DEFAULT_FRAGMENT_SHADER = "Assets/Shaders/simple_shader.frag.spv";
+    //Next to the executable rather than with the cooked assets, it belongs
+    //to the machine not the game.
+    const std::string PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+    const std::string SHADER_CACHE_PATH = "shader_cache";
+    //Set GUST_PIPELINE_BENCHMARK to time linking pipeline libraries against
+    //full compiles of the default pipeline at start up.
+    const uint32_t PIPELINE_BENCHMARK_RUNS = 20;
+    //The first descriptor pool of each frame, later ones double.
+    const uint32_t DESCRIPTOR_SETS_PER_POOL = 64;
+    //Upper bounds for the bindless set, lowered to the device's limits.
+    const uint32_t MAX_BINDLESS_TEXTURES = 16384;
+    const uint32_t MAX_BINDLESS_BUFFERS = 4096;
+    //Under the source root, edits in here are reloaded.
+    const std::string SHADER_DIRECTORY = "Assets/Shaders";
+    //Only set in builds made from the source tree. Shaders are compiled from
+    //the GLSL there so editing one doesn't need a cook.
+#ifdef GUST_SHADER_SOURCE_DIR
+    const std::string SHADER_SOURCE_PATH = GUST_SHADER_SOURCE_DIR;
+#else
+    const std::string SHADER_SOURCE_PATH = "";
+#endif
+
+    //The model matrix is pushed per draw so each streamed object can have its
+    //own without touching the uniform buffer.
     struct UniformBufferObject 
     {
-        alignas(16) glm::mat4 model;
         alignas(16) glm::mat4 view;
         alignas(16) glm::mat4 proj;
     };
-}
 
-namespace std
-{
-    template<>
-    struct hash<Vertex>
+    //Pushed per draw. The texture is a slot in the bindless set, so any
+    //object can sample any texture without a descriptor bind.
+    struct DrawConstants
     {
-        size_t operator()(Vertex const& vertex) const
-        {
-            return ((std::hash<glm::vec3>()(vertex.pos) ^ (std::hash<glm::vec3>()(vertex.colour) << 1)) >> 1) ^ (std::hash<glm::vec2>()(vertex.texCoord) << 1);
-        }
+        glm::mat4 model;
+        uint32_t textureIndex;
     };
+    //What the shaders declare, without any padding the struct picks up.
+    const uint32_t DRAW_CONSTANTS_SIZE = offsetof(DrawConstants, textureIndex) + sizeof(uint32_t);
 }
 
+static_assert(sizeof(Vertex) == sizeof(Gust::CookedVertex), "Cooked vertices are copied straight into the vertex buffer.");
+
 namespace Gust
 {
     //Here we are constructing a window with the default properties.
@@ -244,31 +308,36 @@ namespace Gust
     void WindowsWindow::shutdown()
     {
         GUST_PROFILE_FUNCTION();
+        //Reload jobs call back into the window so finish them first.
+        _assetReloader.reset();
+        _shaderReloader.reset();
+        _worldStreamer.reset();
+        _deletionQueue->flush();
+        if (_defragmentationContext != VK_NULL_HANDLE)
+        {
+            vmaEndDefragmentation(_allocator, _defragmentationContext, nullptr);
+        }
+        _stagingRing.reset();
+
         swapChainCleanUp();
 
-        vkDestroyPipeline(_device, _graphicsPipeline, nullptr);
-        vkDestroyPipelineLayout(_device, _pipelineLayout, nullptr);
-        vkDestroyRenderPass(_device, _renderPass, nullptr);
+        _pipelineManager.reset();
+        _shaderVariants.reset();
+        _shaderCompiler.reset();
+        _resources.reset();
+        _pipelineCache->save();
+        _pipelineCache.reset();
+        _renderPassCache.reset();
 
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) 
-        {
-            vkDestroyBuffer(_device, _uniformBuffers[i], nullptr);
-            vkFreeMemory(_device, _uniformBufferMemory[i], nullptr);
-        }
-        vkDestroyDescriptorPool(_device, _descriptorPool, nullptr);
+        _frameUniforms.reset();
+        _frameDescriptors.reset();
+        _bindless.reset();
 
         vkDestroySampler(_device, _textureSampler, nullptr);
-        vkDestroyImageView(_device, _textureImageView, nullptr);
-
-        vkDestroyImage(_device, _textureImage, nullptr);
-        vkFreeMemory(_device, _textureImageMemory, nullptr);
 
-        vkDestroyDescriptorSetLayout(_device, _descriptorSetLayout, nullptr);
+        _layoutCache.reset();
 
-        vkDestroyBuffer(_device, _indexBuffer, nullptr);
-        vkFreeMemory(_device, _indexBufferMemory, nullptr);
-        vkDestroyBuffer(_device, _vertexBuffer, nullptr);
-        vkFreeMemory(_device, _vertexBufferMemory, nullptr);
+        _geometryArena.reset();
 
         for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
         {
@@ -279,6 +348,15 @@ namespace Gust
 
         vkDestroyCommandPool(_device, _commandPool, nullptr);
 
+        GpuMemoryStats memoryStats = getGpuMemoryStats();
+        if (memoryStats.allocationCount > 0)
+        {
+            GUST_WARN("{0} GPU allocations ({1} bytes) were still alive at shutdown.", memoryStats.allocationCount, memoryStats.allocationBytes);
+        }
+        _deletionQueue.reset();
+        _memoryBudget.reset();
+        vmaDestroyAllocator(_allocator);
+
         vkDestroyDevice(_device, nullptr);
 
         if (enableValidationLayers)
@@ -338,7 +416,25 @@ namespace Gust
     {
         GUST_PROFILE_FUNCTION();
         vkWaitForFences(_device, 1, &_inFlightFences[_currentFrame], VK_TRUE, UINT64_MAX);
-        vkResetFences(_device, 1, &_inFlightFences[_currentFrame]);
+
+        _memoryBudget->update(_frameNumber);
+        //This frame's resources are free now so it's the safe point to swap
+        //in anything that was reloaded or moved.
+        defragmentGpuMemory();
+        _assetReloader->update();
+        if (_shaderReloader)
+        {
+            _shaderReloader->update();
+        }
+        _pipelineManager->update(_frameNumber);
+        if (_worldStreamer)
+        {
+            _worldStreamer->update(_scene->getCamera().position);
+        }
+        //This slot's fence covers every frame up to MAX_FRAMES_IN_FLIGHT back.
+        uint64_t completedFrames = _frameNumber + 1 >= MAX_FRAMES_IN_FLIGHT ? _frameNumber + 1 - MAX_FRAMES_IN_FLIGHT : 0;
+        _deletionQueue->collect(completedFrames);
+        allocateFrameDescriptorSet();
 
         uint32_t imageIndex = -1;
         VkResult result = vkAcquireNextImageKHR(_device, _swapChain, UINT64_MAX, _imageAvailableSemaphores[_currentFrame], VK_NULL_HANDLE, &imageIndex);
@@ -352,15 +448,35 @@ namespace Gust
 
         updateUniformBuffer(_currentFrame);
 
+        //Everything uploaded this frame goes in one submit ahead of the draw.
+        _stagingRing->flush();
+
+        //Streamed meshes are only drawn once their upload has landed, so the
+        //frame only waits on uploads it can't be drawn without. On a single
+        //queue submission order already covers everything.
+        _completedUploadValue = _stagingRing->transfersOwnership() ? _stagingRing->getCompletedValue() : UINT64_MAX;
+        _uploadWaitValue = std::max(_completedUploadValue, _requiredUploadValue);
+
         vkResetCommandBuffer(_commandBuffers[_currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
         recordCommandBuffer(_commandBuffers[_currentFrame], imageIndex);
+        _frameUniforms->flush();
 
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         
-        VkSemaphore waitSemaphores[] = { _imageAvailableSemaphores[_currentFrame]};
-        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-        submitInfo.waitSemaphoreCount = 1;
+        VkSemaphore waitSemaphores[] = { _imageAvailableSemaphores[_currentFrame], _stagingRing->getTimelineSemaphore() };
+        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
+        //The value for the binary semaphore is ignored.
+        uint64_t waitValues[] = { 0, _uploadWaitValue };
+        uint32_t waitCount = _waitOnUploads ? 2 : 1;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = waitCount;
+        timelineInfo.pWaitSemaphoreValues = waitValues;
+        submitInfo.pNext = &timelineInfo;
+
+        submitInfo.waitSemaphoreCount = waitCount;
         submitInfo.pWaitSemaphores = waitSemaphores;
         submitInfo.pWaitDstStageMask = waitStages;
 
@@ -371,6 +487,9 @@ namespace Gust
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
+        //Only reset once we know this frame will be submitted, an early
+        //return for a stale swap chain would leave it unsignalled forever.
+        vkResetFences(_device, 1, &_inFlightFences[_currentFrame]);
         result = vkQueueSubmit(_graphicsQueue, 1, &submitInfo, _inFlightFences[_currentFrame]);
         GUST_CORE_ASSERT("Failed to submit draw command buffer.", result != VK_SUCCESS);
 
@@ -387,6 +506,11 @@ namespace Gust
         presentInfo.pImageIndices = &imageIndex;
         result = vkQueuePresentKHR(_presentQueue, &presentInfo);
 
+        //The frame was submitted either way, so it counts even when the swap
+        //chain has to be rebuilt.
+        _currentFrame = (_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        _frameNumber++;
+
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || _framebufferedResized)
         {
             _framebufferedResized = false;
@@ -394,8 +518,6 @@ namespace Gust
             return;
         }
         GUST_CORE_ASSERT("Failed to present swap chain image!", result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR);
-
-        _currentFrame = (_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
     }
 
     void WindowsWindow::waitDevice()
@@ -403,6 +525,64 @@ namespace Gust
         vkDeviceWaitIdle(_device);
     }
 
+    //Large levels are never loaded up front. The streamer brings in the cells
+    //around the camera and the demo model is only drawn for an empty scene.
+    void WindowsWindow::setScene(Scene* scene)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        //Releasing the old cells retires their buffers behind the frames
+        //still in flight.
+        _worldStreamer.reset();
+        _scene = scene;
+        _streamedMeshes.clear();
+        _materialPipelines.clear();
+
+        if (_scene == nullptr || _scene->getObjectCount() == 0)
+        {
+            return;
+        }
+
+        _streamedMeshes.resize(_scene->getMeshPaths().size());
+        _materialPipelines.resize(_scene->getMaterialPaths().size());
+        _worldStreamer = std::make_unique<WorldStreamer>(*_scene, StreamingSettings(),
+            [this](uint32_t mesh, const CookedMesh& data) { uploadStreamedMesh(mesh, data); },
+            [this](uint32_t mesh) { releaseStreamedMesh(mesh); });
+    }
+
+    void WindowsWindow::uploadStreamedMesh(uint32_t mesh, const CookedMesh& data)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        GpuMesh& gpuMesh = _streamedMeshes[mesh];
+        if (uploadMesh(data.vertices.data(), static_cast<uint32_t>(data.vertices.size()), data.indices.data(), static_cast<uint32_t>(data.indices.size()), gpuMesh) == false)
+        {
+            GUST_WARN("The geometry arena is full, mesh {0} won't be drawn.", _scene->getMeshPaths()[mesh]);
+        }
+    }
+
+    void WindowsWindow::releaseStreamedMesh(uint32_t mesh)
+    {
+        GpuMesh gpuMesh = _streamedMeshes[mesh];
+        _streamedMeshes[mesh] = GpuMesh();
+
+        auto freeGeometry = [this, gpuMesh]()
+        {
+            _geometryArena->free(gpuMesh.geometry);
+        };
+
+        //A mesh dropped before its upload landed could still be written by
+        //the transfer queue, so its range waits for the upload as well.
+        if (gpuMesh.uploadValue > _completedUploadValue)
+        {
+            _deletionQueue->retire(_frameNumber, _stagingRing->getTimelineSemaphore(), gpuMesh.uploadValue, std::move(freeGeometry));
+        }
+        else
+        {
+            _deletionQueue->retire(_frameNumber, std::move(freeGeometry));
+        }
+    }
+
     void WindowsWindow::initVulkan() 
     {
         createInstance();
@@ -410,9 +590,12 @@ namespace Gust
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
+        createAllocator();
+        createPipelineCache();
         createSwapChain();
         createImageView();
         createRenderPass();
+        createBindlessDescriptors();
         createDescriptionSetLayout();
         createGraphicsPipeline();
         createCommandPool();
@@ -420,16 +603,134 @@ namespace Gust
         createDepthResources();
         createFramebuffers();
         createTextureImage();
-        createTextureImageView();
         createTextureSampler();
+        createGeometryArena();
         loadModel();
-        createVertexBuffer();
-        createIndexBuffer();
+        createModelGeometry();
         createUniformBuffers();
-        createDescriptorPool();
-        createDescriptorSets();
+        createDescriptorAllocator();
         createCommandBuffers();
         createSyncObjects();
+        initAssetReloading();
+        initShaderReloading();
+
+        _stagingRing->flush();
+        const StagingStats& stagingStats = _stagingRing->getStats();
+        GUST_INFO("Start up uploads: {0} uploads ({1:.2f} MB) in {2} submits.", stagingStats.uploads, stagingStats.bytes / (1024.0 * 1024.0), stagingStats.submits);
+
+        GpuMemoryStats memoryStats = getGpuMemoryStats();
+        GUST_INFO("GPU memory: {0} allocations in {1} blocks, {2:.2f} MB used of {3:.2f} MB allocated.", memoryStats.allocationCount, memoryStats.blockCount,
+                  memoryStats.allocationBytes / (1024.0 * 1024.0), memoryStats.blockBytes / (1024.0 * 1024.0));
+        _memoryBudget->logHeaps();
+        logTransientAttachmentMemory();
+
+        PipelineCacheStats pipelineStats = _pipelineCache->getStats();
+        GUST_INFO("Created {0} pipelines in {1:.2f} ms from a {2} pipeline cache ({3:.2f} KB loaded).", pipelineStats.pipelines, pipelineStats.creationMilliseconds,
+                  pipelineStats.warm ? "warm" : "cold", pipelineStats.loadedBytes / 1024.0);
+
+        PipelineManagerStats managerStats = _pipelineManager->getStats();
+        GUST_INFO("Pipelines: {0} libraries ({1:.2f} ms), {2} optimised links ({3:.2f} ms), {4} full compiles ({5:.2f} ms).",
+                  managerStats.libraries, managerStats.libraryMilliseconds, managerStats.optimisedLinks, managerStats.optimisedLinkMilliseconds,
+                  managerStats.fullCompiles, managerStats.fullCompileMilliseconds);
+
+        ShaderVariantStats variantStats = _shaderVariants->getStats();
+        GUST_INFO("Shader variants: {0} live across {1} shaders from {2} modules.", variantStats.liveVariants, variantStats.shaders, variantStats.modules);
+
+        const LayoutCacheStats& layoutStats = _layoutCache->getStats();
+        const RenderPassCacheStats& renderPassStats = _renderPassCache->getStats();
+        GUST_INFO("Layouts: {0} set layouts, {1} pipeline layouts, {2} render passes, {3} requests shared an existing one.", layoutStats.setLayouts,
+                  layoutStats.pipelineLayouts, renderPassStats.renderPasses, layoutStats.hits + renderPassStats.hits);
+    }
+
+    //Cooked assets are watched where the game loads them from, so re-running
+    //GustCook while the game is open swaps the new versions in.
+    void WindowsWindow::initAssetReloading()
+    {
+        GUST_PROFILE_FUNCTION();
+
+        _assetReloader = std::make_unique<AssetReloader>("Assets");
+
+        _assetReloader->watch(TEXTURE_PATH, [this](const std::string& filePath) -> std::function<void()>
+        {
+            auto texture = std::make_shared<CookedTexture>();
+            if (loadTextureData(filePath, *texture) == false)
+            {
+                return {};
+            }
+
+            return [this, texture]()
+            {
+                _bindless->removeTexture(_frameNumber, _resources->get(_texture).bindlessIndex);
+                _resources->release(_frameNumber, _texture);
+                createTextureImage(*texture);
+            };
+        });
+
+        _assetReloader->watch(MODEL_PATH, [this](const std::string& filePath) -> std::function<void()>
+        {
+            auto mesh = std::make_shared<CookedMesh>();
+            if (CookedAssets::loadMesh(filePath, *mesh) == false)
+            {
+                return {};
+            }
+
+            return [this, mesh]()
+            {
+                GeometryAllocation geometry = _demoMesh.geometry;
+                _deletionQueue->retire(_frameNumber, [this, geometry]()
+                {
+                    _geometryArena->free(geometry);
+                });
+
+                _vertices.resize(mesh->vertices.size());
+                memcpy(_vertices.data(), mesh->vertices.data(), sizeof(Vertex) * mesh->vertices.size());
+                _indices = std::move(mesh->indices);
+
+                createModelGeometry();
+            };
+        });
+    }
+
+    //Editing a shader rebuilds the pipelines using it while the game runs.
+    //The old pipelines keep drawing until the new ones are swapped in at a
+    //frame boundary. A change that alters the shader's bindings still needs
+    //a restart, the pipeline layout isn't rebuilt.
+    void WindowsWindow::initShaderReloading()
+    {
+        GUST_PROFILE_FUNCTION();
+
+        if (_shaderCompiler->canCompile() == false)
+        {
+            return;
+        }
+
+        _shaderReloader = std::make_unique<AssetReloader>(SHADER_SOURCE_PATH);
+        _shaderReloader->watchDirectory(SHADER_SOURCE_PATH + "/" + SHADER_DIRECTORY, [this](const std::string& filePath) -> std::function<void()>
+        {
+            //Compiled here so the rebuilt pipelines find them in the cache. A
+            //broken edit keeps the old pipelines rather than rebuilding them
+            //from the cooked SPIR-V.
+            std::vector<std::string> shaders;
+            for (const auto& request : _shaderCompiler->findDependents(filePath))
+            {
+                std::vector<uint32_t> spirv;
+                if (_shaderCompiler->compile(request, spirv) == false)
+                {
+                    return {};
+                }
+                //Pipelines name their shaders by the cooked path.
+                shaders.push_back(request.sourcePath + ".spv");
+            }
+
+            return [this, shaders]()
+            {
+                for (const auto& shader : shaders)
+                {
+                    _shaderVariants->invalidate(shader);
+                    _pipelineManager->reload(shader);
+                }
+            };
+        });
     }
 
     void WindowsWindow::createInstance() 
@@ -536,7 +837,7 @@ namespace Gust
         QueueFamilyIndices indices = findQueueFamilies(_physicalDevice);
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value(), indices.transferFamily.value() };
         float queuePriority = 1.f;
         for (uint32_t queueFamily : uniqueQueueFamilies) 
         {
@@ -548,19 +849,94 @@ namespace Gust
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures{};
+        vkGetPhysicalDeviceFeatures(_physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures{};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        //Cooked textures are BC compressed, without this they get expanded
+        //back to RGBA8 on load.
+        deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+        _textureCompressionBC = supportedFeatures.textureCompressionBC == VK_TRUE;
+
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT supportedLibraryFeatures{};
+        supportedLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+        VkPhysicalDeviceVulkan12Features supportedVulkan12Features{};
+        supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 supportedFeatures2{};
+        supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures2.pNext = &supportedVulkan12Features;
+        _graphicsPipelineLibrary = isDeviceExtensionSupported(_physicalDevice, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+                                   isDeviceExtensionSupported(_physicalDevice, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+        if (_graphicsPipelineLibrary)
+        {
+            supportedVulkan12Features.pNext = &supportedLibraryFeatures;
+        }
+        vkGetPhysicalDeviceFeatures2(_physicalDevice, &supportedFeatures2);
+        _graphicsPipelineLibrary = _graphicsPipelineLibrary && supportedLibraryFeatures.graphicsPipelineLibrary == VK_TRUE;
+        GUST_CORE_ASSERT("The GPU doesn't support timeline semaphores.", supportedVulkan12Features.timelineSemaphore != VK_TRUE);
+        GUST_CORE_ASSERT("The GPU doesn't support bindless descriptors.", supportedVulkan12Features.runtimeDescriptorArray != VK_TRUE ||
+                         supportedVulkan12Features.descriptorBindingPartiallyBound != VK_TRUE ||
+                         supportedVulkan12Features.descriptorBindingSampledImageUpdateAfterBind != VK_TRUE ||
+                         supportedVulkan12Features.descriptorBindingStorageBufferUpdateAfterBind != VK_TRUE ||
+                         supportedVulkan12Features.descriptorBindingUpdateUnusedWhilePending != VK_TRUE);
+
+        //Upload batches signal a timeline the frame waits on.
+        VkPhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12Features.timelineSemaphore = VK_TRUE;
+        //Descriptor indexing, for the bindless set.
+        vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+        vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+        vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        vulkan12Features.shaderSampledImageArrayNonUniformIndexing = supportedVulkan12Features.shaderSampledImageArrayNonUniformIndexing;
+        vulkan12Features.shaderStorageBufferArrayNonUniformIndexing = supportedVulkan12Features.shaderStorageBufferArrayNonUniformIndexing;
+
+        //New pipelines are linked from prebuilt parts instead of compiled
+        //whole, see PipelineManager.
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT libraryFeatures{};
+        libraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+        libraryFeatures.graphicsPipelineLibrary = VK_TRUE;
+        if (_graphicsPipelineLibrary)
+        {
+            vulkan12Features.pNext = &libraryFeatures;
+        }
 
         VkDeviceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = &vulkan12Features;
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
 
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        //Without the budget extension VMA can only guess the budget from the
+        //heap sizes, and can't see what other processes are using.
+        std::vector<const char*> enabledExtensions = deviceExtensions;
+        _memoryBudgetSupported = isDeviceExtensionSupported(_physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (_memoryBudgetSupported)
+        {
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+        if (_graphicsPipelineLibrary)
+        {
+            enabledExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+            enabledExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+
+            VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT libraryProperties{};
+            libraryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+            VkPhysicalDeviceProperties2 properties2{};
+            properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            properties2.pNext = &libraryProperties;
+            vkGetPhysicalDeviceProperties2(_physicalDevice, &properties2);
+            GUST_INFO("Graphics pipeline libraries supported, fast linking is {0}.", libraryProperties.graphicsPipelineLibraryFastLinking == VK_TRUE ? "fast" : "not guaranteed to be fast");
+        }
+
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         if (enableValidationLayers) 
         {
@@ -578,6 +954,128 @@ namespace Gust
 
         vkGetDeviceQueue(_device,indices.graphicsFamily.value(), 0, &_graphicsQueue);
         vkGetDeviceQueue(_device, indices.presentFamily.value(), 0, &_presentQueue);
+        vkGetDeviceQueue(_device, indices.transferFamily.value(), 0, &_transferQueue);
+
+        if (indices.transferFamily != indices.graphicsFamily)
+        {
+            GUST_INFO("Uploading on the dedicated transfer queue family {0}.", indices.transferFamily.value());
+        }
+        else
+        {
+            GUST_INFO("No dedicated transfer queue, uploading on the graphics queue.");
+        }
+    }
+
+    void WindowsWindow::createAllocator()
+    {
+        GUST_PROFILE_FUNCTION();
+
+        VmaAllocatorCreateInfo allocatorInfo{};
+        allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_3;
+        allocatorInfo.instance = _instance;
+        allocatorInfo.physicalDevice = _physicalDevice;
+        allocatorInfo.device = _device;
+        if (_memoryBudgetSupported)
+        {
+            allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+        }
+
+        VkResult result = vmaCreateAllocator(&allocatorInfo, &_allocator);
+        GUST_CORE_ASSERT("Failed to create the GPU memory allocator.", result != VK_SUCCESS);
+
+        const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+        vmaGetMemoryProperties(_allocator, &memoryProperties);
+        for (uint32_t i = 0; i < memoryProperties->memoryTypeCount; i++)
+        {
+            if ((memoryProperties->memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0)
+            {
+                _lazilyAllocatedMemory = true;
+            }
+        }
+
+        _deletionQueue = std::make_unique<DeletionQueue>(_device, _allocator);
+        _resources = std::make_unique<GpuResources>(_device, _allocator, *_deletionQueue);
+        _memoryBudget = std::make_unique<MemoryBudget>(_allocator, _memoryBudgetSupported, MAX_FRAMES_IN_FLIGHT);
+
+        //Compacting is the one thing that hands whole blocks back to the
+        //driver, the free space inside them is what it could give back.
+        _memoryBudget->addEvictionCallback([this](uint64_t bytes) -> uint64_t
+        {
+            GpuMemoryStats stats = getGpuMemoryStats();
+            uint64_t freeBytes = stats.blockBytes - stats.allocationBytes;
+            if (_defragmentationContext != VK_NULL_HANDLE || freeBytes < DEFRAGMENTATION_MIN_FREE_BYTES)
+            {
+                return 0;
+            }
+
+            _defragmentationRequested = true;
+            return std::min(bytes, freeBytes);
+        });
+    }
+
+    void WindowsWindow::createPipelineCache()
+    {
+        GUST_PROFILE_FUNCTION();
+
+        _pipelineCache = std::make_unique<PipelineCache>(_device, _physicalDevice, PIPELINE_CACHE_PATH);
+        _shaderCompiler = std::make_unique<ShaderCompiler>(SHADER_SOURCE_PATH, SHADER_CACHE_PATH);
+        _shaderVariants = std::make_unique<ShaderVariants>(*_shaderCompiler);
+        _layoutCache = std::make_unique<LayoutCache>(_device);
+        _renderPassCache = std::make_unique<RenderPassCache>(_device);
+        _pipelineManager = std::make_unique<PipelineManager>(_device, *_resources, *_pipelineCache, *_shaderVariants, _graphicsPipelineLibrary);
+
+        //Specialisation constant ids every shader agrees on.
+        _shaderVariants->registerSpecialisation("ALPHA_TEST", 0);
+
+        //Get every shader compiled in parallel up front rather than one at a
+        //time as the pipelines ask for them.
+        if (_shaderCompiler->canCompile())
+        {
+            uint32_t failures = _shaderCompiler->compileAll(_shaderCompiler->findSources());
+            ShaderCompilerStats shaderStats = _shaderCompiler->getStats();
+            GUST_INFO("Shaders: {0} compiled in {1:.2f} ms, {2} from the cache, {3} failed.", shaderStats.compiles, shaderStats.compileMilliseconds,
+                      shaderStats.diskHits + shaderStats.memoryHits, failures);
+        }
+    }
+
+    GpuMemoryStats WindowsWindow::getGpuMemoryStats() const
+    {
+        VmaTotalStatistics totals{};
+        vmaCalculateStatistics(_allocator, &totals);
+
+        GpuMemoryStats stats;
+        stats.blockCount = totals.total.statistics.blockCount;
+        stats.allocationCount = totals.total.statistics.allocationCount;
+        stats.unusedRangeCount = totals.total.unusedRangeCount;
+        stats.blockBytes = totals.total.statistics.blockBytes;
+        stats.allocationBytes = totals.total.statistics.allocationBytes;
+
+        VkDeviceSize freeBytes = stats.blockBytes - stats.allocationBytes;
+        if (freeBytes > 0 && totals.total.unusedRangeCount > 0)
+        {
+            stats.fragmentation = 1.f - static_cast<float>(totals.total.unusedRangeSizeMax) / static_cast<float>(freeBytes);
+        }
+        stats.defragmentedBytes = _defragmentedBytes;
+        stats.totalDefragmentedBytes = _totalDefragmentedBytes;
+        stats.driverBudget = _memoryBudget->isDriverBudget();
+        stats.pressure = _memoryBudget->getPressure();
+        stats.evictedBytes = _memoryBudget->getEvictedBytes();
+
+        const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+        vmaGetMemoryProperties(_allocator, &memoryProperties);
+
+        std::vector<VmaBudget> budgets(memoryProperties->memoryHeapCount);
+        vmaGetHeapBudgets(_allocator, budgets.data());
+        for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++)
+        {
+            GpuMemoryHeap heap;
+            heap.usage = budgets[i].usage;
+            heap.budget = budgets[i].budget;
+            heap.deviceLocal = (memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+            stats.heaps.push_back(heap);
+        }
+
+        return stats;
     }
 
     void WindowsWindow::createSwapChain()
@@ -624,6 +1122,8 @@ namespace Gust
         createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         createInfo.presentMode = presentMode;
         createInfo.clipped = VK_TRUE;
+        //Lets the driver hand resources over from the one being replaced.
+        createInfo.oldSwapchain = _swapChain;
 
         VkResult result = vkCreateSwapchainKHR(_device, &createInfo, nullptr, &_swapChain);
         GUST_CORE_ASSERT("Failed to create swap chain.", result != VK_SUCCESS);
@@ -650,229 +1150,74 @@ namespace Gust
     void WindowsWindow::createRenderPass() 
     {
         GUST_PROFILE_FUNCTION();
-        VkAttachmentDescription colourAttachment{};
-        colourAttachment.format = _swapChainImageFormat;
-        colourAttachment.samples = _msaaSamples;
-        colourAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        colourAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        colourAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        colourAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        colourAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colourAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-        VkAttachmentDescription depthAttachment{};
-        depthAttachment.format = findDepthFormat();
-        depthAttachment.samples = _msaaSamples;
-        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-        VkAttachmentDescription colourAttachmentResolve{};
-        colourAttachmentResolve.format = _swapChainImageFormat;
-        colourAttachmentResolve.samples = VK_SAMPLE_COUNT_1_BIT;
-        colourAttachmentResolve.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        colourAttachmentResolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        colourAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        colourAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        colourAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colourAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-        VkAttachmentReference colourAttachmentRef{};
-        colourAttachmentRef.attachment = 0;
-        colourAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-        VkAttachmentReference depthAttachmentRef{};
-        depthAttachmentRef.attachment = 1;
-        depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-        VkAttachmentReference colourAttachmentResolveRef{};
-        colourAttachmentResolveRef.attachment = 2;
-        colourAttachmentResolveRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-        VkSubpassDescription subpass{};
-        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        subpass.colorAttachmentCount = 1;
-        subpass.pColorAttachments = &colourAttachmentRef;
-        subpass.pDepthStencilAttachment = &depthAttachmentRef;
-        subpass.pResolveAttachments = &colourAttachmentResolveRef;
-
-        VkSubpassDependency dependency{};
-        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-        dependency.dstSubpass = 0;
-        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        dependency.srcAccessMask = 0;
-        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-        std::array<VkAttachmentDescription, 3> attachments = { colourAttachment, depthAttachment, colourAttachmentResolve };
-        VkRenderPassCreateInfo renderPassInfo{};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-        renderPassInfo.pAttachments = attachments.data();
-        renderPassInfo.subpassCount = 1;
-        renderPassInfo.pSubpasses = &subpass;
-        renderPassInfo.dependencyCount = 1;
-        renderPassInfo.pDependencies = &dependency;
-
-        VkResult result = vkCreateRenderPass(_device, &renderPassInfo, nullptr, &_renderPass);
-        GUST_CORE_ASSERT("Failed to create render pass!", result != VK_SUCCESS);
-    }
 
-    void WindowsWindow::createDescriptionSetLayout()
-    {
-        VkDescriptorSetLayoutBinding uniformBufferLayoutBinding{};
-        uniformBufferLayoutBinding.binding = 0;
-        uniformBufferLayoutBinding.descriptorCount = 1;
-        uniformBufferLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        uniformBufferLayoutBinding.pImmutableSamplers = nullptr;
-        uniformBufferLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        RenderPassDescription description;
+        description.colourFormats = { _swapChainImageFormat };
+        description.depthFormat = findDepthFormat();
+        description.samples = _msaaSamples;
+        description.colourFinalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
-        VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-        samplerLayoutBinding.binding = 1;
-        samplerLayoutBinding.descriptorCount = 1;
-        samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        samplerLayoutBinding.pImmutableSamplers = nullptr;
-        samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        _renderPass = _renderPassCache->getRenderPass(description);
+        GUST_CORE_ASSERT("Failed to create render pass!", _renderPass == VK_NULL_HANDLE);
+    }
 
-        std::array<VkDescriptorSetLayoutBinding, 2> binding = { uniformBufferLayoutBinding, samplerLayoutBinding };
-        VkDescriptorSetLayoutCreateInfo layoutInfo{};
-        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        layoutInfo.bindingCount = static_cast<uint32_t>(binding.size());
-        layoutInfo.pBindings = binding.data();
+    //Before anything that makes textures or pipeline layouts.
+    void WindowsWindow::createBindlessDescriptors()
+    {
+        GUST_PROFILE_FUNCTION();
 
-        VkResult result = vkCreateDescriptorSetLayout(_device, &layoutInfo, nullptr, &_descriptorSetLayout);
-        GUST_CORE_ASSERT("Failed to create descriptor", result != VK_SUCCESS);
+        _bindless = std::make_unique<BindlessDescriptors>(_device, _physicalDevice, *_deletionQueue, MAX_BINDLESS_TEXTURES, MAX_BINDLESS_BUFFERS);
+        const BindlessStats& bindlessStats = _bindless->getStats();
+        GUST_INFO("Bindless set holds {0} textures and {1} storage buffers.", bindlessStats.textureCapacity, bindlessStats.bufferCapacity);
     }
 
-    void WindowsWindow::createGraphicsPipeline()
+    //The layouts come from the default shaders themselves, so changing what
+    //a shader binds doesn't mean changing the code to match.
+    void WindowsWindow::createDescriptionSetLayout()
     {
         GUST_PROFILE_FUNCTION();
-        auto vertexShaderCode = readFile("Assets/Shaders/simple_shader.vert.spv");
-        auto fragmentShaderCode = readFile("Assets/Shaders/simple_shader.frag.spv");
 
-        VkShaderModule vertexShaderModule = createShaderModule(vertexShaderCode);
-        VkShaderModule fragmentShaderModule = createShaderModule(fragmentShaderCode);
+        std::vector<ShaderReflection> stages(2);
+        std::vector<uint32_t> spirv;
+        bool reflected = _shaderCompiler->load(DEFAULT_VERTEX_SHADER, {}, spirv) && ShaderReflector::reflect(spirv, stages[0]) &&
+                         _shaderCompiler->load(DEFAULT_FRAGMENT_SHADER, {}, spirv) && ShaderReflector::reflect(spirv, stages[1]) &&
+                         ShaderReflector::merge(stages, _shaderLayout);
+        GUST_CORE_ASSERT("Failed to reflect the default shaders.", reflected == false);
+        GUST_CORE_ASSERT("The default shaders should use set 0 and the bindless set.", _shaderLayout.sets.size() != BINDLESS_SET + 1);
+        GUST_CORE_ASSERT("The default shaders' bindless set doesn't match.", _bindless->isCompatible(_shaderLayout.sets[BINDLESS_SET]) == false);
+        GUST_CORE_ASSERT("The vertex shader's inputs don't match the Vertex struct.", _shaderLayout.vertexStride != sizeof(Vertex));
 
-        VkPipelineShaderStageCreateInfo vertexShaderStageInfo{};
-        vertexShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        vertexShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-        vertexShaderStageInfo.module = vertexShaderModule;
-        vertexShaderStageInfo.pName = "main";
+        _descriptorSetLayout = _layoutCache->getSetLayout(_shaderLayout.sets[0]);
+        GUST_CORE_ASSERT("Failed to create descriptor", _descriptorSetLayout == VK_NULL_HANDLE);
+    }
 
-        VkPipelineShaderStageCreateInfo fragmentShaderStageInfo{};
-        fragmentShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        fragmentShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        fragmentShaderStageInfo.module = fragmentShaderModule;
-        fragmentShaderStageInfo.pName = "main";
+    void WindowsWindow::createGraphicsPipeline()
+    {
+        GUST_PROFILE_FUNCTION();
 
-        VkPipelineShaderStageCreateInfo shaderStages[] =
+        _pipelineLayout = _layoutCache->getPipelineLayout({ _descriptorSetLayout, _bindless->getLayout() }, _shaderLayout.pushConstants);
+        GUST_CORE_ASSERT("Failed to create pipeline layout.", _pipelineLayout == VK_NULL_HANDLE);
+
+        _pipelineDescription = PipelineDescription();
+        _pipelineDescription.vertexShader = DEFAULT_VERTEX_SHADER;
+        _pipelineDescription.fragmentShader = DEFAULT_FRAGMENT_SHADER;
+        _pipelineDescription.vertexStride = _shaderLayout.vertexStride;
+        _pipelineDescription.vertexAttributes = _shaderLayout.vertexAttributes;
+        _pipelineDescription.colourFormat = _swapChainImageFormat;
+        _pipelineDescription.depthFormat = findDepthFormat();
+        _pipelineDescription.samples = _msaaSamples;
+        _pipelineDescription.renderPass = _renderPass;
+        _pipelineDescription.layout = _pipelineLayout;
+
+        //Built up front as anything whose own pipeline is still compiling
+        //is drawn with it.
+        _graphicsPipeline = _pipelineManager->getOrCreate(_pipelineDescription);
+        GUST_CORE_ASSERT("Failed to create graphics pipeline.", _graphicsPipeline.isNull());
+
+        if (std::getenv("GUST_PIPELINE_BENCHMARK") != nullptr)
         {
-            vertexShaderStageInfo,
-            fragmentShaderStageInfo
-        };
-
-        auto bindingDescription = Vertex::getBindindDescription();
-        auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = 1;
-        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-        vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-        VkPipelineViewportStateCreateInfo viewportState{};
-        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        viewportState.viewportCount = 1;
-        viewportState.scissorCount = 1;
-
-        VkPipelineRasterizationStateCreateInfo rasterizer{};
-        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        rasterizer.depthClampEnable = VK_FALSE;
-        rasterizer.rasterizerDiscardEnable = VK_FALSE;
-        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-        rasterizer.lineWidth = 1.f;
-        rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-        rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-        rasterizer.depthBiasEnable = VK_FALSE;
-
-        VkPipelineMultisampleStateCreateInfo multisampling{};
-        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-        multisampling.sampleShadingEnable = VK_FALSE;
-        multisampling.rasterizationSamples = _msaaSamples;
-
-        VkPipelineDepthStencilStateCreateInfo depthStencil{};
-        depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-        depthStencil.depthTestEnable = VK_TRUE;
-        depthStencil.depthWriteEnable = VK_TRUE;
-        depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
-        depthStencil.depthBoundsTestEnable = VK_FALSE;
-        depthStencil.stencilTestEnable = VK_FALSE;
-
-        VkPipelineColorBlendAttachmentState colourBlendAttachment{};
-        colourBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-        colourBlendAttachment.blendEnable = VK_FALSE;
-
-        VkPipelineColorBlendStateCreateInfo colourBlending{};
-        colourBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        colourBlending.logicOpEnable = VK_FALSE;
-        colourBlending.logicOp = VK_LOGIC_OP_COPY;
-        colourBlending.attachmentCount = 1;
-        colourBlending.pAttachments = &colourBlendAttachment;
-        colourBlending.blendConstants[0] = 0.f;
-        colourBlending.blendConstants[1] = 0.f;
-        colourBlending.blendConstants[2] = 0.f;
-        colourBlending.blendConstants[3] = 0.f;
-
-        std::vector<VkDynamicState> dynamicStates = 
-        {
-            VK_DYNAMIC_STATE_VIEWPORT,
-            VK_DYNAMIC_STATE_SCISSOR
-        };
-
-        VkPipelineDynamicStateCreateInfo dynamicState{};
-        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-        dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-        dynamicState.pDynamicStates = dynamicStates.data();
-
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = 1;
-        pipelineLayoutInfo.pSetLayouts = &_descriptorSetLayout;
-
-        VkResult result = vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &_pipelineLayout);
-        GUST_CORE_ASSERT("Failed to create pipeline layout.", result != VK_SUCCESS);
-
-        VkGraphicsPipelineCreateInfo pipelineInfo{};
-        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = 2;
-        pipelineInfo.pStages = shaderStages;
-        pipelineInfo.pVertexInputState = &vertexInputInfo;
-        pipelineInfo.pInputAssemblyState = &inputAssembly;
-        pipelineInfo.pViewportState = &viewportState;
-        pipelineInfo.pRasterizationState = &rasterizer;
-        pipelineInfo.pDepthStencilState = &depthStencil;
-        pipelineInfo.pMultisampleState = &multisampling;
-        pipelineInfo.pColorBlendState = &colourBlending;
-        pipelineInfo.pDynamicState = &dynamicState;
-        pipelineInfo.layout = _pipelineLayout;
-        pipelineInfo.renderPass = _renderPass;
-        pipelineInfo.subpass = 0;
-        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-
-        result = vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_graphicsPipeline);
-        GUST_CORE_ASSERT("Failed to create graphics pipeline.", result != VK_SUCCESS);
-
-        vkDestroyShaderModule(_device, fragmentShaderModule, nullptr);
-        vkDestroyShaderModule(_device, vertexShaderModule, nullptr);
+            _pipelineManager->benchmark(_pipelineDescription, PIPELINE_BENCHMARK_RUNS);
+        }
     }
 
     void WindowsWindow::createCommandPool() 
@@ -887,13 +1232,15 @@ namespace Gust
 
         VkResult result = vkCreateCommandPool(_device, &poolInfo, nullptr, &_commandPool);
         GUST_CORE_ASSERT("Failed to create command pool", result != VK_SUCCESS);
+
+        _stagingRing = std::make_unique<StagingRing>(_device, _allocator, _transferQueue, queueFamilyIndices.transferFamily.value(), queueFamilyIndices.graphicsFamily.value(), STAGING_RING_SIZE);
     }
 
     void WindowsWindow::createColourResources()
     {
         VkFormat colourFormat = _swapChainImageFormat;
 
-        createImage(_swapChainExtent.width, _swapChainExtent.height, 1, _msaaSamples, colourFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _colourImage, _colourImageMemory);
+        createTransientAttachment(colourFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, _colourImage, _colourImageAllocation);
         _colourImageView = createImageView(_colourImage, colourFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
     }
 
@@ -928,46 +1275,131 @@ namespace Gust
     {
         VkFormat depthFormat = findDepthFormat();
 
-        createImage(_swapChainExtent.width, _swapChainExtent.height, 1, _msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _depthImage, _depthImageMemory);
+        createTransientAttachment(depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, _depthImage, _depthImageAllocation);
         _depthImageView = createImageView(_depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
     }
 
+    //The multisampled colour and depth are cleared on load and dropped at
+    //the end of the pass, so they never need to be backed by real memory on
+    //hardware that can keep them in tile memory.
+    void WindowsWindow::createTransientAttachment(VkFormat format, VkImageUsageFlags usage, VkImage& image, VmaAllocation& allocation)
+    {
+        VmaMemoryUsage memoryUsage = _lazilyAllocatedMemory ? VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED : VMA_MEMORY_USAGE_AUTO;
+        createImage(_swapChainExtent.width, _swapChainExtent.height, 1, _msaaSamples, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | usage,
+                    VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT, image, allocation, memoryUsage);
+    }
+
+    void WindowsWindow::logTransientAttachmentMemory()
+    {
+        VkDeviceSize reserved = 0;
+        VkDeviceSize committed = 0;
+        for (VmaAllocation allocation : { _colourImageAllocation, _depthImageAllocation })
+        {
+            VmaAllocationInfo allocationInfo{};
+            vmaGetAllocationInfo(_allocator, allocation, &allocationInfo);
+            reserved += allocationInfo.size;
+
+            if (_lazilyAllocatedMemory)
+            {
+                VkDeviceSize memoryCommitment = 0;
+                vkGetDeviceMemoryCommitment(_device, allocationInfo.deviceMemory, &memoryCommitment);
+                committed += memoryCommitment;
+            }
+            else
+            {
+                committed += allocationInfo.size;
+            }
+        }
+
+        if (_lazilyAllocatedMemory)
+        {
+            GUST_INFO("{0}x MSAA attachments are lazily allocated, {1:.2f} MB committed of {2:.2f} MB, saving {3:.2f} MB.", static_cast<uint32_t>(_msaaSamples),
+                      committed / (1024.0 * 1024.0), reserved / (1024.0 * 1024.0), (reserved - committed) / (1024.0 * 1024.0));
+        }
+        else
+        {
+            GUST_INFO("No lazily allocated memory, {0}x MSAA attachments take {1:.2f} MB.", static_cast<uint32_t>(_msaaSamples), reserved / (1024.0 * 1024.0));
+        }
+    }
+
     void WindowsWindow::createTextureImage()
     {
         GUST_PROFILE_FUNCTION();
 
-        int texWidth = -1, texHeight = -1, textChannels = -1;
-        stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &textChannels, STBI_rgb_alpha);
-        VkDeviceSize imageSize = texWidth * texHeight * 4;
-        _mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
-        GUST_CORE_ASSERT("Failed to load texture image", pixels != nullptr);
+        CookedTexture texture;
+        bool loaded = loadTextureData(TEXTURE_PATH, texture);
+        GUST_CORE_ASSERT("Failed to load texture image", loaded == false);
+
+        createTextureImage(texture);
+    }
+
+    //Only touches the CPU so it is safe to call from the thread pool.
+    bool WindowsWindow::loadTextureData(const std::string& filePath, CookedTexture& texture)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        if (CookedAssets::loadTexture(filePath, texture) == false)
+        {
+            return false;
+        }
+
+        if (isBlockCompressed(texture.format) && _textureCompressionBC == false)
+        {
+            GUST_WARN("Device can't sample BC textures, decompressing {0}", filePath);
+            CookedAssets::decompressTexture(texture);
+        }
 
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+        return true;
+    }
 
-        void* data = nullptr;
-        vkMapMemory(_device, stagingBufferMemory, 0, imageSize, 0, &data);
-        memcpy(data, pixels, static_cast<size_t>(imageSize));
-        vkUnmapMemory(_device, stagingBufferMemory);
+    void WindowsWindow::createTextureImage(const CookedTexture& texture)
+    {
+        GUST_PROFILE_FUNCTION();
 
-        stbi_image_free(pixels);
+        GpuTexture gpuTexture;
+        switch (texture.format)
+        {
+        case CookedTextureFormat::BC1_SRGB:
+            gpuTexture.format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+            break;
+        case CookedTextureFormat::BC3_SRGB:
+            gpuTexture.format = VK_FORMAT_BC3_SRGB_BLOCK;
+            break;
+        case CookedTextureFormat::RGBA8_SRGB:
+        default:
+            gpuTexture.format = VK_FORMAT_R8G8B8A8_SRGB;
+            break;
+        }
 
-        createImage(texWidth, texHeight, _mipLevels, VK_SAMPLE_COUNT_1_BIT,  VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _textureImage, _textureImageMemory);
+        gpuTexture.mipLevels = static_cast<uint32_t>(texture.mips.size());
+        gpuTexture.extent = { texture.width, texture.height };
+        VkDeviceSize imageSize = texture.data.size();
 
-        transitionImageLayout(_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, _mipLevels);
-        copyBufferToImage(stagingBuffer, _textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-        //transitionImageLayout(_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        createImage(texture.width, texture.height, gpuTexture.mipLevels, VK_SAMPLE_COUNT_1_BIT, gpuTexture.format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 0, gpuTexture.image, gpuTexture.allocation);
+        createTextureImageView(gpuTexture);
+        gpuTexture.bindlessIndex = _bindless->addTexture(gpuTexture.view);
+        _texture = _resources->addTexture(gpuTexture);
+        tagAllocation(gpuTexture.allocation, GpuResourceKind::TEXTURE, _texture.getValue());
 
-        vkDestroyBuffer(_device, stagingBuffer, nullptr);
-        vkFreeMemory(_device, stagingBufferMemory, nullptr);
+        //The mip chain was built by the cooker so every level is just a copy.
+        std::vector<VkBufferImageCopy> regions(texture.mips.size());
+        for (uint32_t i = 0; i < gpuTexture.mipLevels; i++)
+        {
+            regions[i].bufferOffset = texture.mips[i].offset;
+            regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            regions[i].imageSubresource.mipLevel = i;
+            regions[i].imageSubresource.baseArrayLayer = 0;
+            regions[i].imageSubresource.layerCount = 1;
+            regions[i].imageExtent = { texture.mips[i].width, texture.mips[i].height, 1 };
+        }
 
-        generateMipmaps(_textureImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, _mipLevels);
+        _stagingRing->uploadImage(gpuTexture.image, gpuTexture.mipLevels, texture.data.data(), imageSize, std::move(regions));
+        _requiredUploadValue = _stagingRing->getRecordingValue();
     }
 
-    void WindowsWindow::createTextureImageView() 
+    void WindowsWindow::createTextureImageView(GpuTexture& texture)
     {
-        _textureImageView = createImageView(_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, _mipLevels);
+        texture.view = createImageView(texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, texture.mipLevels);
     }
 
     void WindowsWindow::createTextureSampler() 
@@ -990,189 +1422,117 @@ namespace Gust
         samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
         samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
         samplerInfo.minLod = 0.f;
-        samplerInfo.maxLod = static_cast<float>(_mipLevels);
+        //Left unclamped so a reloaded texture with more mips still uses them.
+        samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
         samplerInfo.mipLodBias = 0.f;
 
         VkResult result = vkCreateSampler(_device, &samplerInfo, nullptr, &_textureSampler);
         GUST_CORE_ASSERT("Failed to create texture sampler.", result != VK_SUCCESS);
+        _bindless->setSampler(_textureSampler);
     }
 
     void WindowsWindow::loadModel()
     {
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warning, error;
+        GUST_PROFILE_FUNCTION();
 
-        bool result = tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, MODEL_PATH.c_str());
-        if (result == false)
+        //Welding and cache ordering were done by the cooker.
+        CookedMesh mesh;
+        if (CookedAssets::loadMesh(MODEL_PATH, mesh) == false)
         {
-            GUST_ERROR("Error : {0} Warning : {1}", warning, error);
+            GUST_ERROR("Failed to load model {0}", MODEL_PATH);
+            return;
         }
 
-        std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-        
-        for (const auto& shape : shapes) 
-        {
-            for (const auto& index : shape.mesh.indices) 
-            {
-                Vertex vertex{};
-
-                vertex.pos =
-                {
-                    attrib.vertices[3 * index.vertex_index + 0],
-                    attrib.vertices[3 * index.vertex_index + 1],
-                    attrib.vertices[3 * index.vertex_index + 2]
-                };
-
-                vertex.texCoord =
-                {
-                    attrib.texcoords[2 * index.texcoord_index + 0],
-                    1.f - attrib.texcoords[2 * index.texcoord_index + 1]
-                };
-
-                vertex.colour = { 1.f, 1.f, 1.f };
-
-                if (uniqueVertices.count(vertex) == 0) 
-                {
-                    uniqueVertices[vertex] = static_cast<uint32_t>(_vertices.size());
-                    _vertices.push_back(vertex);
-                }
-
-                _indices.push_back(uniqueVertices[vertex]);
-            }
-        }
+        _vertices.resize(mesh.vertices.size());
+        memcpy(_vertices.data(), mesh.vertices.data(), sizeof(Vertex) * mesh.vertices.size());
+        _indices = std::move(mesh.indices);
     }
 
-    void WindowsWindow::createVertexBuffer()
+    void WindowsWindow::createGeometryArena()
     {
-        GUST_PROFILE_FUNCTION();
-
-        VkDeviceSize bufferSize = sizeof(_vertices[0]) * _vertices.size();
-
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-        void* data = nullptr;
-        vkMapMemory(_device, stagingBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, _vertices.data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(_device, stagingBufferMemory);
+        QueueFamilyIndices queueFamilyIndices = findQueueFamilies(_physicalDevice);
 
-        createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _vertexBuffer, _vertexBufferMemory);
-        copyBuffer(stagingBuffer, _vertexBuffer, bufferSize);
+        std::vector<uint32_t> queueFamilies = { queueFamilyIndices.graphicsFamily.value() };
+        if (queueFamilyIndices.transferFamily != queueFamilyIndices.graphicsFamily)
+        {
+            queueFamilies.push_back(queueFamilyIndices.transferFamily.value());
+        }
 
-        vkDestroyBuffer(_device, stagingBuffer, nullptr);
-        vkFreeMemory(_device, stagingBufferMemory, nullptr);
+        _geometryArena = std::make_unique<GeometryArena>(_allocator, *_memoryBudget, sizeof(Vertex), GEOMETRY_VERTEX_CAPACITY, GEOMETRY_INDEX_CAPACITY, queueFamilies);
     }
 
-    void WindowsWindow::createIndexBuffer()
+    void WindowsWindow::createModelGeometry()
     {
         GUST_PROFILE_FUNCTION();
 
-        VkDeviceSize bufferSize = sizeof(_indices[0]) * _indices.size();
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+        bool uploaded = uploadMesh(_vertices.data(), static_cast<uint32_t>(_vertices.size()), _indices.data(), static_cast<uint32_t>(_indices.size()), _demoMesh);
+        GUST_CORE_ASSERT("The demo model doesn't fit the geometry arena.", uploaded == false);
+        _requiredUploadValue = _demoMesh.uploadValue;
+    }
 
-        void* data = nullptr;
-        vkMapMemory(_device, stagingBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, _indices.data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(_device, stagingBufferMemory);
+    //Places a mesh in the geometry arena and queues its contents on the
+    //staging ring. Returns false when the arena has no room for it.
+    bool WindowsWindow::uploadMesh(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, GpuMesh& gpuMesh)
+    {
+        if (_geometryArena->allocate(vertexCount, indexCount, gpuMesh.geometry) == false)
+        {
+            gpuMesh = GpuMesh();
+            return false;
+        }
 
-        createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _indexBuffer, _indexBufferMemory);
-        copyBuffer(stagingBuffer, _indexBuffer, bufferSize);
+        VkDeviceSize stride = _geometryArena->getVertexStride();
+        bool concurrent = _geometryArena->isConcurrent();
+        _stagingRing->uploadBuffer(_geometryArena->getVertexBuffer(), vertices, stride * vertexCount, stride * gpuMesh.geometry.firstVertex, concurrent);
+        _stagingRing->uploadBuffer(_geometryArena->getIndexBuffer(), indices, sizeof(uint32_t) * static_cast<VkDeviceSize>(indexCount),
+                                   sizeof(uint32_t) * static_cast<VkDeviceSize>(gpuMesh.geometry.firstIndex), concurrent);
 
-        vkDestroyBuffer(_device, stagingBuffer, nullptr);
-        vkFreeMemory(_device, stagingBufferMemory, nullptr);
+        //Read after both uploads, the ring may have flushed in between.
+        gpuMesh.uploadValue = _stagingRing->getRecordingValue();
+        return true;
     }
 
     void WindowsWindow::createUniformBuffers() 
     {
-        VkDeviceSize bufferSize = sizeof(UniformBufferObject);
+        VkPhysicalDeviceProperties properties{};
+        vkGetPhysicalDeviceProperties(_physicalDevice, &properties);
 
-        _uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-        _uniformBufferMemory.resize(MAX_FRAMES_IN_FLIGHT);
-        _uniformBufferMapped.resize(MAX_FRAMES_IN_FLIGHT);
+        _frameUniforms = std::make_unique<FrameAllocator>(_allocator, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, properties.limits.minUniformBufferOffsetAlignment,
+                                                          FRAME_UNIFORM_SIZE, MAX_FRAMES_IN_FLIGHT);
+    }
 
-        for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) 
-        {
-            createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _uniformBuffers[i], _uniformBufferMemory[i]);
+    void WindowsWindow::createDescriptorAllocator() 
+    {
+        //Sized from what the reflected set layout holds, pools past the
+        //first only appear if a frame ever needs more sets.
+        std::vector<VkDescriptorPoolSize> sizesPerSet = DescriptorAllocator::poolSizesFor(_shaderLayout.sets[0]);
+        _frameDescriptors = std::make_unique<DescriptorAllocator>(_device, sizesPerSet, DESCRIPTOR_SETS_PER_POOL, MAX_FRAMES_IN_FLIGHT);
 
-            vkMapMemory(_device, _uniformBufferMemory[i], 0, bufferSize, 0, &_uniformBufferMapped[i]);
-        }
+        _descriptorUpdateTemplate = _layoutCache->getUpdateTemplate(_shaderLayout.sets[0]);
+        GUST_CORE_ASSERT("Failed to create the descriptor update template.", _descriptorUpdateTemplate == VK_NULL_HANDLE);
     }
 
-    void WindowsWindow::createDescriptorPool() 
+    //Sets are written fresh every frame out of that frame's pools, which
+    //were reset once its fence signalled. Nothing is ever rewritten while
+    //the GPU may be reading it.
+    void WindowsWindow::allocateFrameDescriptorSet()
     {
-        std::array<VkDescriptorPoolSize, 2> poolSizes{};
-        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        poolSizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-        poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+        _frameDescriptors->beginFrame(_currentFrame);
 
-        VkDescriptorPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-        poolInfo.pPoolSizes = poolSizes.data();
-        poolInfo.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+        //In binding order, see LayoutCache::getUpdateTemplate. Textures are
+        //in the bindless set.
+        std::array<DescriptorInfo, 1> descriptors{};
+        descriptors[0].buffer.buffer = _frameUniforms->getBuffer();
+        descriptors[0].buffer.offset = 0;
+        descriptors[0].buffer.range = sizeof(UniformBufferObject);
 
-        VkResult result = vkCreateDescriptorPool(_device, &poolInfo, nullptr, &_descriptorPool);
-        GUST_CORE_ASSERT("Failed to create descriptor pool.", result != VK_SUCCESS);
+        _frameDescriptorSet = _frameDescriptors->allocate(_descriptorSetLayout, _descriptorUpdateTemplate, descriptors.data());
+        GUST_CORE_ASSERT("Failed to allocate the frame's descriptor set.", _frameDescriptorSet == VK_NULL_HANDLE);
     }
 
-    void WindowsWindow::createDescriptorSets() 
+    void WindowsWindow::createCommandBuffers() 
     {
-        std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, _descriptorSetLayout);
-
-        VkDescriptorSetAllocateInfo allocateInfo{};
-        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocateInfo.descriptorPool = _descriptorPool;
-        allocateInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-        allocateInfo.pSetLayouts = layouts.data();
-
-        _descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
-        VkResult result = vkAllocateDescriptorSets(_device, &allocateInfo, _descriptorSets.data());
-        GUST_CORE_ASSERT("Failed to allocate descriptor sets.", result != VK_SUCCESS);
-
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) 
-        {
-            VkDescriptorBufferInfo  bufferInfo{};
-            bufferInfo.buffer = _uniformBuffers[i];
-            bufferInfo.offset = 0;
-            bufferInfo.range = sizeof(UniformBufferObject);
-
-            VkDescriptorImageInfo imageInfo{};
-            imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            imageInfo.imageView = _textureImageView;
-            imageInfo.sampler = _textureSampler;
-
-            std::array<VkWriteDescriptorSet, 2> writeDescriptorSets{};
-
-            writeDescriptorSets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writeDescriptorSets[0].dstSet = _descriptorSets[i];
-            writeDescriptorSets[0].dstBinding = 0;
-            writeDescriptorSets[0].dstArrayElement = 0;
-            writeDescriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            writeDescriptorSets[0].descriptorCount = 1;
-            writeDescriptorSets[0].pBufferInfo = &bufferInfo;
-
-            writeDescriptorSets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            writeDescriptorSets[1].dstSet = _descriptorSets[i];
-            writeDescriptorSets[1].dstBinding = 1;
-            writeDescriptorSets[1].dstArrayElement = 0;
-            writeDescriptorSets[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            writeDescriptorSets[1].descriptorCount = 1;
-            writeDescriptorSets[1].pImageInfo = &imageInfo;
-
-            vkUpdateDescriptorSets(_device, static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
-        }
-    }
-
-    void WindowsWindow::createCommandBuffers() 
-    {
-        GUST_PROFILE_FUNCTION();
-        _commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+        GUST_PROFILE_FUNCTION();
+        _commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
 
         VkCommandBufferAllocateInfo allocateInfo{};
         allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -1198,21 +1558,6 @@ namespace Gust
         createInfo.pfnUserCallback = debugCallback;
     }
 
-    VkShaderModule WindowsWindow::createShaderModule(const std::vector<char>& code)
-    {
-        GUST_PROFILE_FUNCTION();
-        VkShaderModuleCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-        VkShaderModule shaderModule;
-        VkResult result = vkCreateShaderModule(_device, &createInfo, nullptr, &shaderModule);
-        GUST_CORE_ASSERT("Failed to create shader module!", result != VK_SUCCESS);
-
-        return shaderModule;
-    }
-
     VkSurfaceFormatKHR WindowsWindow::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) 
     {
         GUST_PROFILE_FUNCTION();
@@ -1350,6 +1695,25 @@ namespace Gust
             i++;
         }
 
+        //A family that can copy but not draw runs uploads alongside the
+        //frame. One without compute either is the dedicated copy engine.
+        for (uint32_t family = 0; family < queueFamilyCount; family++)
+        {
+            VkQueueFlags flags = queueFamilies[family].queueFlags;
+            if ((flags & VK_QUEUE_TRANSFER_BIT) && (flags & VK_QUEUE_GRAPHICS_BIT) == 0)
+            {
+                if (indices.transferFamily.has_value() == false || (flags & VK_QUEUE_COMPUTE_BIT) == 0)
+                {
+                    indices.transferFamily = family;
+                }
+            }
+        }
+
+        if (indices.transferFamily.has_value() == false)
+        {
+            indices.transferFamily = indices.graphicsFamily;
+        }
+
         return indices;
     }
 
@@ -1403,98 +1767,7 @@ namespace Gust
         return true;
     }
 
-    void WindowsWindow::generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
-    {
-        VkFormatProperties formatProperties;
-        vkGetPhysicalDeviceFormatProperties(_physicalDevice, imageFormat, &formatProperties);
-        bool propertyImageFormatResult = !(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
-        GUST_CORE_ASSERT("Texture image format does not support linear blitting", propertyImageFormatResult != true);
-
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-        VkImageMemoryBarrier barrier{};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.image = image;
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
-        barrier.subresourceRange.levelCount = 1;
-
-        int32_t mipWidth = texWidth;
-        int32_t mipHeight = texHeight;
-
-        for (uint32_t i = 1; i < mipLevels; i++)
-        {
-            barrier.subresourceRange.baseMipLevel = i - 1;
-            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-            vkCmdPipelineBarrier(commandBuffer,
-                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-                0, nullptr,
-                0, nullptr,
-                1, &barrier);
-
-            VkImageBlit blit{};
-            blit.srcOffsets[0] = { 0, 0, 0 };
-            blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
-            blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            blit.srcSubresource.mipLevel = i - 1;
-            blit.srcSubresource.baseArrayLayer = 0;
-            blit.srcSubresource.layerCount = 1;
-
-            blit.dstOffsets[0] = { 0, 0, 0 };
-            blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
-            blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            blit.dstSubresource.mipLevel = i;
-            blit.dstSubresource.baseArrayLayer = 0;
-            blit.dstSubresource.layerCount = 1;
-
-            vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 
-                                          image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
-                                          1, &blit, VK_FILTER_LINEAR);
-
-            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-            vkCmdPipelineBarrier(commandBuffer, 
-                                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-                                 0, nullptr,
-                                 0, nullptr,
-                                 1, &barrier);
-
-            if (mipWidth > 1)
-            {
-                mipWidth /= 2;
-            }
-            if (mipHeight > 1) 
-            {
-                mipHeight /= 2;
-            }
-        }
-
-        barrier.subresourceRange.baseMipLevel = mipLevels - 1;
-        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        vkCmdPipelineBarrier(commandBuffer, 
-                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-                             0, nullptr,
-                             0, nullptr,
-                             1, &barrier);
-
-        endSingleTimeCommand(commandBuffer);
-    }
-
-    void WindowsWindow::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+    void WindowsWindow::createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VmaAllocationCreateFlags allocationFlags, VkImage& image, VmaAllocation& allocation, VmaMemoryUsage memoryUsage)
     {
         VkImageCreateInfo imageInfo{};
         imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -1511,96 +1784,12 @@ namespace Gust
         imageInfo.samples = numSamples;
         imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        VkResult result = vkCreateImage(_device, &imageInfo, nullptr, &image);
-        GUST_CORE_ASSERT("Failed to create image.", result != VK_SUCCESS);
-
-        VkMemoryRequirements memRequirements;
-        vkGetImageMemoryRequirements(_device, image, &memRequirements);
-
-        VkMemoryAllocateInfo allocateInfo{};
-        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocateInfo.allocationSize = memRequirements.size;
-        allocateInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        result = vkAllocateMemory(_device, &allocateInfo, nullptr, &imageMemory);
-        GUST_CORE_ASSERT("Failed to allocate image memory.", result != VK_SUCCESS);
+        VmaAllocationCreateInfo allocationInfo{};
+        allocationInfo.usage = memoryUsage;
+        allocationInfo.flags = allocationFlags;
 
-        vkBindImageMemory(_device, image, imageMemory, 0);
-    }
-
-    void WindowsWindow::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels)
-    {
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-        VkImageMemoryBarrier barrier{};
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.oldLayout = oldLayout;
-        barrier.newLayout = newLayout;
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.image = image;
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = mipLevels;
-        barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
-
-        VkPipelineStageFlags sourceStage;
-        VkPipelineStageFlags destinationStage;
-
-        if(oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-        {
-            barrier.srcAccessMask = 0;
-            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-            sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        }
-        else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-        {
-            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-            sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-            destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-        }
-        else 
-        {
-            GUST_CORE_ASSERT("Unsupported layout trasitional.", true);
-        }
-
-        vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 
-            0, 
-            0, nullptr, 
-            0, nullptr, 
-            1, &barrier);
-
-        endSingleTimeCommand(commandBuffer);
-    }
-
-    void WindowsWindow::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) 
-    {
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-        VkBufferImageCopy region{};
-        region.bufferOffset = 0;
-        region.bufferRowLength = 0;
-        region.bufferImageHeight = 0;
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = 1;
-        region.imageOffset = {0, 0, 0};
-        region.imageExtent = 
-        {
-            width, 
-            height,
-            1
-        };
-
-        vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-        endSingleTimeCommand(commandBuffer);
+        VkResult result = vmaCreateImage(_allocator, &imageInfo, &allocationInfo, &image, &allocation, nullptr);
+        GUST_CORE_ASSERT("Failed to create image.", result != VK_SUCCESS);
     }
 
     VkImageView WindowsWindow::createImageView(VkImage image, VkFormat format, VkImageAspectFlagBits aspectsFlags, uint32_t mipLevels)
@@ -1674,7 +1863,9 @@ namespace Gust
         return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
     }
 
-    void WindowsWindow::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+    //VMA packs buffers into large blocks and picks the memory type from the
+    //usage, so only resources that prefer it get their own vkAllocateMemory.
+    void WindowsWindow::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaAllocationCreateFlags allocationFlags, VkBuffer& buffer, VmaAllocation& allocation, void** mapped)
     {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -1682,67 +1873,18 @@ namespace Gust
         bufferInfo.usage = usage;
         bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        VkResult result = vkCreateBuffer(_device, &bufferInfo, nullptr, &buffer);
-        GUST_CORE_ASSERT("Failed to create vertex buffer.", result != VK_SUCCESS);
+        VmaAllocationCreateInfo allocationCreateInfo{};
+        allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        allocationCreateInfo.flags = allocationFlags;
 
-        VkMemoryRequirements memRequirements;
-        vkGetBufferMemoryRequirements(_device, buffer, &memRequirements);
+        VmaAllocationInfo allocationInfo{};
+        VkResult result = vmaCreateBuffer(_allocator, &bufferInfo, &allocationCreateInfo, &buffer, &allocation, &allocationInfo);
+        GUST_CORE_ASSERT("Failed to create buffer.", result != VK_SUCCESS);
 
-        VkMemoryAllocateInfo allocateInfo{};
-        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocateInfo.allocationSize = memRequirements.size;
-        allocateInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        result = vkAllocateMemory(_device, &allocateInfo, nullptr, &bufferMemory);
-        GUST_CORE_ASSERT("Failed to allocate vertex buffer memory.", result != VK_SUCCESS);
-
-        vkBindBufferMemory(_device, buffer, bufferMemory, 0);
-    }
-
-    VkCommandBuffer WindowsWindow::beginSingleTimeCommands()
-    {
-        VkCommandBufferAllocateInfo allocateInfo{};
-        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocateInfo.commandPool = _commandPool;
-        allocateInfo.commandBufferCount = 1;
-
-        VkCommandBuffer commandBuffer;
-        vkAllocateCommandBuffers(_device, &allocateInfo, &commandBuffer);
-
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-        vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-        return commandBuffer;
-    }
-
-    void WindowsWindow::endSingleTimeCommand(VkCommandBuffer commandBuffer)
-    {
-        vkEndCommandBuffer(commandBuffer);
-
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &commandBuffer;
-
-        vkQueueSubmit(_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(_graphicsQueue);
-
-        vkFreeCommandBuffers(_device, _commandPool, 1, &commandBuffer);
-    }
-
-    void WindowsWindow::copyBuffer(VkBuffer sourceBuffer, VkBuffer destBuffer, VkDeviceSize size)
-    {
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-
-        VkBufferCopy copyRegion{};
-        copyRegion.size = size;
-        vkCmdCopyBuffer(commandBuffer, sourceBuffer, destBuffer, 1, &copyRegion);
-
-        endSingleTimeCommand(commandBuffer);
+        if (mapped != nullptr)
+        {
+            *mapped = allocationInfo.pMappedData;
+        }
     }
 
     bool WindowsWindow::checkDeviceExtensionSupport(VkPhysicalDevice device) 
@@ -1764,6 +1906,24 @@ namespace Gust
         return requiredExtension.empty();
     }
 
+    bool WindowsWindow::isDeviceExtensionSupported(VkPhysicalDevice device, const char* extensionName)
+    {
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto& extension : availableExtensions)
+        {
+            if (strcmp(extension.extensionName, extensionName) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void WindowsWindow::updateUniformBuffer(uint32_t currentImage)
     {
         static auto startTime = std::chrono::high_resolution_clock::now();
@@ -1771,29 +1931,17 @@ namespace Gust
         auto currentTime = std::chrono::high_resolution_clock::now();
         float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
-        UniformBufferObject uniformBufferObj;
-        uniformBufferObj.model = glm::rotate(glm::mat4(1.f), time * glm::radians(90.f), glm::vec3(0.f, 0.f, 1.f));
-        uniformBufferObj.view = glm::lookAt(glm::vec3(2.f, 2.f, 2.f), glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.f, 0.f, 1.f));
-        uniformBufferObj.proj = glm::perspective(glm::radians(45.f), static_cast<float>(_swapChainExtent.width) / static_cast<float>(_swapChainExtent.height), 0.1f, 10.f);
-        uniformBufferObj.proj[1][1] *= -1;
+        _demoModelTransform = glm::rotate(glm::mat4(1.f), time * glm::radians(90.f), glm::vec3(0.f, 0.f, 1.f));
 
-        memcpy(_uniformBufferMapped[currentImage], &uniformBufferObj, sizeof(uniformBufferObj));
-    }
-
-    uint32_t WindowsWindow::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) 
-    {
-        VkPhysicalDeviceMemoryProperties memProperties;
-        vkGetPhysicalDeviceMemoryProperties(_physicalDevice, &memProperties);
+        Camera camera = _scene ? _scene->getCamera() : Camera();
 
-        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) 
-        {
-            if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
-            {
-                return i;
-            }
-        }
+        UniformBufferObject uniformBufferObj;
+        uniformBufferObj.view = glm::lookAt(camera.position, camera.target, camera.up);
+        uniformBufferObj.proj = glm::perspective(glm::radians(camera.fieldOfView), static_cast<float>(_swapChainExtent.width) / static_cast<float>(_swapChainExtent.height), camera.nearPlane, camera.farPlane);
+        uniformBufferObj.proj[1][1] *= -1;
 
-        GUST_CORE_ASSERT("Failed to find suitable memory type.", true);
+        _frameUniforms->beginFrame(currentImage);
+        _cameraUniformOffset = _frameUniforms->push(uniformBufferObj);
     }
 
     void WindowsWindow::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) 
@@ -1805,6 +1953,12 @@ namespace Gust
         VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
         GUST_CORE_ASSERT("Failed to begin recording command buffer!", result != VK_SUCCESS);
 
+        //Take ownership of anything the transfer queue has finished with.
+        //The submit then has to wait on the upload timeline, which is also
+        //what makes writes to the concurrent geometry arena visible.
+        _stagingRing->recordAcquires(commandBuffer, _uploadWaitValue);
+        _waitOnUploads = _stagingRing->transfersOwnership() && _uploadWaitValue > 0;
+
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassInfo.renderPass = _renderPass;
@@ -1820,7 +1974,8 @@ namespace Gust
         renderPassInfo.pClearValues = clearValues.data();
 
         vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _graphicsPipeline);
+        const GpuPipeline& pipeline = _resources->get(_graphicsPipeline);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
         
         VkViewport viewport{};
         viewport.x = 0.f;
@@ -1837,21 +1992,90 @@ namespace Gust
         scissor.extent = _swapChainExtent;
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-        VkBuffer vertexBuffers[] = { _vertexBuffer };
-        VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-
-        vkCmdBindIndexBuffer(commandBuffer, _indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+        //The only descriptor bind of the frame, every draw after indexes
+        //into the bindless set.
+        std::array<VkDescriptorSet, 2> sets = { _frameDescriptorSet, _bindless->getSet() };
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, 0, static_cast<uint32_t>(sets.size()), sets.data(), 1, &_cameraUniformOffset);
 
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_descriptorSets[_currentFrame], 0, nullptr);
+        //Every mesh lives in the arena so the buffers are bound once and
+        //draws only differ by their offsets.
+        _geometryArena->bind(commandBuffer);
 
-        vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(_indices.size()), 1, 0, 0, 0);
+        if (_worldStreamer)
+        {
+            recordStreamedObjects(commandBuffer);
+        }
+        else
+        {
+            const GeometryAllocation& geometry = _demoMesh.geometry;
+            pushDrawConstants(commandBuffer, _demoModelTransform, _resources->get(_texture).bindlessIndex);
+            vkCmdDrawIndexed(commandBuffer, geometry.indexCount, 1, geometry.firstIndex, static_cast<int32_t>(geometry.firstVertex), 0);
+        }
         vkCmdEndRenderPass(commandBuffer);
 
         result = vkEndCommandBuffer(commandBuffer);
         GUST_CORE_ASSERT("Failed to end recording command buffer.", result != VK_SUCCESS);
     }
 
+    void WindowsWindow::recordStreamedObjects(VkCommandBuffer commandBuffer)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        const auto& objectMeshes = _scene->getMeshes();
+        const auto& objectMaterials = _scene->getMaterials();
+        const auto& transforms = _scene->getTransforms();
+
+        //Materials new to the session start compiling here and are drawn
+        //with the default pipeline until they are ready. Until materials
+        //have a format of their own, each one is the fragment shader cooked
+        //next to it, so stone.gmat is drawn with stone.frag.spv.
+        const auto& materialPaths = _scene->getMaterialPaths();
+        for (size_t i = 0; i < _materialPipelines.size(); i++)
+        {
+            if (_materialPipelines[i].isNull())
+            {
+                PipelineDescription description = _pipelineDescription;
+                description.fragmentShader = std::filesystem::path(materialPaths[i]).replace_extension(".frag.spv").string();
+                _materialPipelines[i] = _pipelineManager->request(description);
+            }
+        }
+
+        _visibleObjects.clear();
+        _worldStreamer->gatherVisibleObjects(_visibleObjects);
+
+        //Until materials name their own textures they all share the one.
+        uint32_t textureIndex = _resources->get(_texture).bindlessIndex;
+        PipelineHandle boundPipeline = _graphicsPipeline;
+        for (uint32_t object : _visibleObjects)
+        {
+            const GpuMesh& gpuMesh = _streamedMeshes[objectMeshes[object]];
+            if (gpuMesh.geometry.isValid() == false || gpuMesh.uploadValue > _completedUploadValue)
+            {
+                continue;
+            }
+
+            uint32_t material = objectMaterials[object];
+            PipelineHandle pipeline = material == SCENE_NO_MATERIAL || _materialPipelines[material].isNull() ? _graphicsPipeline : _materialPipelines[material];
+            if (pipeline != boundPipeline)
+            {
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _resources->get(pipeline).pipeline);
+                boundPipeline = pipeline;
+            }
+
+            const GeometryAllocation& geometry = gpuMesh.geometry;
+            pushDrawConstants(commandBuffer, transforms[object], textureIndex);
+            vkCmdDrawIndexed(commandBuffer, geometry.indexCount, 1, geometry.firstIndex, static_cast<int32_t>(geometry.firstVertex), 0);
+        }
+    }
+
+    void WindowsWindow::pushDrawConstants(VkCommandBuffer commandBuffer, const glm::mat4& model, uint32_t textureIndex)
+    {
+        DrawConstants constants;
+        constants.model = model;
+        constants.textureIndex = textureIndex;
+        vkCmdPushConstants(commandBuffer, _pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, DRAW_CONSTANTS_SIZE, &constants);
+    }
+
     void WindowsWindow::createSyncObjects()
     {
         _imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
@@ -1878,15 +2102,232 @@ namespace Gust
         }
     }
 
+    void WindowsWindow::tagAllocation(VmaAllocation allocation, GpuResourceKind kind, uint32_t index)
+    {
+        uintptr_t tag = (static_cast<uintptr_t>(kind) << 32) | index;
+        vmaSetAllocationUserData(_allocator, allocation, reinterpret_cast<void*>(tag));
+    }
+
+    //Streaming in and out leaves holes in the device local blocks. When
+    //enough of the free space is scattered, VMA plans moves into fewer
+    //blocks and each frame does one bounded pass of them. The copies go on
+    //the queue ahead of this frame's draw and the handles are swapped
+    //straight away. The old resources and the memory they came from are
+    //released once every frame that could have used them has finished.
+    void WindowsWindow::defragmentGpuMemory()
+    {
+        GUST_PROFILE_FUNCTION();
+
+        _defragmentedBytes = 0;
+
+        //A pass can only start when nothing is waiting to be destroyed, so
+        //no allocation in it can be freed before the pass is ended, and
+        //nothing is still owned by the transfer queue.
+        if (_defragmentationPassPending || _deletionQueue->empty() == false || _stagingRing->hasPendingAcquires())
+        {
+            return;
+        }
+
+        if (_defragmentationContext == VK_NULL_HANDLE)
+        {
+            if (_defragmentationRequested == false && _frameNumber % DEFRAGMENTATION_CHECK_INTERVAL != 0)
+            {
+                return;
+            }
+
+            GpuMemoryStats stats = getGpuMemoryStats();
+            bool fragmented = stats.fragmentation >= DEFRAGMENTATION_THRESHOLD || _defragmentationRequested;
+            _defragmentationRequested = false;
+            if (fragmented == false || stats.blockBytes - stats.allocationBytes < DEFRAGMENTATION_MIN_FREE_BYTES)
+            {
+                return;
+            }
+
+            VmaDefragmentationInfo defragmentationInfo{};
+            defragmentationInfo.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+            defragmentationInfo.maxBytesPerPass = DEFRAGMENTATION_BYTES_PER_PASS;
+            defragmentationInfo.maxAllocationsPerPass = DEFRAGMENTATION_ALLOCATIONS_PER_PASS;
+
+            VkResult result = vmaBeginDefragmentation(_allocator, &defragmentationInfo, &_defragmentationContext);
+            GUST_CORE_ASSERT("Failed to start GPU memory defragmentation.", result != VK_SUCCESS);
+
+            GUST_INFO("Defragmenting GPU memory, {0:.0f}% of {1:.2f} MB free is fragmented.", stats.fragmentation * 100.f,
+                      (stats.blockBytes - stats.allocationBytes) / (1024.0 * 1024.0));
+        }
+
+        VmaDefragmentationPassMoveInfo pass{};
+        if (vmaBeginDefragmentationPass(_allocator, _defragmentationContext, &pass) == VK_SUCCESS)
+        {
+            finishDefragmentation();
+            return;
+        }
+
+        VkCommandBufferAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandPool = _commandPool;
+        allocateInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        vkAllocateCommandBuffers(_device, &allocateInfo, &commandBuffer);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+        std::vector<std::pair<VkImage, VkImageView>> oldImages;
+        for (uint32_t i = 0; i < pass.moveCount; i++)
+        {
+            _defragmentedBytes += moveAllocation(commandBuffer, pass.pMoves[i], oldImages);
+        }
+
+        vkEndCommandBuffer(commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        VkResult result = vkQueueSubmit(_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+        GUST_CORE_ASSERT("Failed to submit the defragmentation copies.", result != VK_SUCCESS);
+
+        _totalDefragmentedBytes += _defragmentedBytes;
+        _defragmentationPassPending = true;
+
+        //Frame fences cover every earlier submit, so by the time this runs
+        //the copies and any frame reading the old resources are done.
+        _deletionQueue->retire(_frameNumber, [this, commandBuffer, pass, oldImages]() mutable
+        {
+            for (const auto& [image, imageView] : oldImages)
+            {
+                vkDestroyImageView(_device, imageView, nullptr);
+                vkDestroyImage(_device, image, nullptr);
+            }
+            vkFreeCommandBuffers(_device, _commandPool, 1, &commandBuffer);
+
+            _defragmentationPassPending = false;
+            if (vmaEndDefragmentationPass(_allocator, _defragmentationContext, &pass) == VK_SUCCESS)
+            {
+                finishDefragmentation();
+            }
+        });
+    }
+
+    VkDeviceSize WindowsWindow::moveAllocation(VkCommandBuffer commandBuffer, VmaDefragmentationMove& move, std::vector<std::pair<VkImage, VkImageView>>& oldImages)
+    {
+        VmaAllocationInfo allocationInfo{};
+        vmaGetAllocationInfo(_allocator, move.srcAllocation, &allocationInfo);
+
+        uintptr_t tag = reinterpret_cast<uintptr_t>(allocationInfo.pUserData);
+        GpuResourceKind kind = static_cast<GpuResourceKind>(tag >> 32);
+        //The tag holds the handle, which is stale if the texture was released
+        //since the pass was planned.
+        TextureHandle texture = TextureHandle::fromValue(static_cast<uint32_t>(tag));
+        if (kind == GpuResourceKind::TEXTURE && _resources->isValid(texture))
+        {
+            return moveTexture(commandBuffer, texture, move, oldImages);
+        }
+
+        //Meshes live in the geometry arena, which is dedicated memory VMA
+        //never moves. Uniforms and anything else untagged stay put too.
+        move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+        return 0;
+    }
+
+    VkDeviceSize WindowsWindow::moveTexture(VkCommandBuffer commandBuffer, TextureHandle handle, VmaDefragmentationMove& move, std::vector<std::pair<VkImage, VkImageView>>& oldImages)
+    {
+        GpuTexture& texture = _resources->get(handle);
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = { texture.extent.width, texture.extent.height, 1 };
+        imageInfo.mipLevels = texture.mipLevels;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = texture.format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkImage newImage;
+        VkResult result = vkCreateImage(_device, &imageInfo, nullptr, &newImage);
+        GUST_CORE_ASSERT("Failed to create an image to defragment into.", result != VK_SUCCESS);
+        result = vmaBindImageMemory(_allocator, move.dstTmpAllocation, newImage);
+        GUST_CORE_ASSERT("Failed to bind a defragmented image.", result != VK_SUCCESS);
+
+        std::array<VkImageMemoryBarrier, 2> barriers{};
+        for (auto& barrier : barriers)
+        {
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.mipLevels, 0, 1 };
+        }
+        barriers[0].image = texture.image;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barriers[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barriers[1].image = newImage;
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barriers[1].srcAccessMask = 0;
+        barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                             static_cast<uint32_t>(barriers.size()), barriers.data());
+
+        std::vector<VkImageCopy> regions(texture.mipLevels);
+        for (uint32_t i = 0; i < texture.mipLevels; i++)
+        {
+            regions[i].srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1 };
+            regions[i].dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1 };
+            regions[i].extent = { std::max(texture.extent.width >> i, 1u), std::max(texture.extent.height >> i, 1u), 1 };
+        }
+        vkCmdCopyImage(commandBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, newImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       static_cast<uint32_t>(regions.size()), regions.data());
+
+        VkImageMemoryBarrier readBarrier = barriers[1];
+        readBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        readBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        readBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        readBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &readBarrier);
+
+        //Same as a reload, the view goes in a new bindless slot so frames in
+        //flight keep reading the old one.
+        oldImages.push_back({ texture.image, texture.view });
+        texture.image = newImage;
+        createTextureImageView(texture);
+        _bindless->removeTexture(_frameNumber, texture.bindlessIndex);
+        texture.bindlessIndex = _bindless->addTexture(texture.view);
+
+        VmaAllocationInfo allocationInfo{};
+        vmaGetAllocationInfo(_allocator, move.srcAllocation, &allocationInfo);
+        return allocationInfo.size;
+    }
+
+    void WindowsWindow::finishDefragmentation()
+    {
+        VmaDefragmentationStats stats{};
+        vmaEndDefragmentation(_allocator, _defragmentationContext, &stats);
+        _defragmentationContext = VK_NULL_HANDLE;
+
+        GpuMemoryStats memoryStats = getGpuMemoryStats();
+        GUST_INFO("GPU memory defragmented: moved {0} allocations ({1:.2f} MB), freed {2} blocks ({3:.2f} MB), fragmentation now {4:.0f}%.",
+                  stats.allocationsMoved, stats.bytesMoved / (1024.0 * 1024.0), stats.deviceMemoryBlocksFreed, stats.bytesFreed / (1024.0 * 1024.0),
+                  memoryStats.fragmentation * 100.f);
+    }
+
     void WindowsWindow::swapChainCleanUp()
     {
         vkDestroyImageView(_device, _depthImageView, nullptr);
-        vkDestroyImage(_device, _depthImage, nullptr);
-        vkFreeMemory(_device, _depthImageMemory, nullptr);
+        vmaDestroyImage(_allocator, _depthImage, _depthImageAllocation);
 
         vkDestroyImageView(_device, _colourImageView, nullptr);
-        vkDestroyImage(_device, _colourImage, nullptr);
-        vkFreeMemory(_device, _colourImageMemory, nullptr);
+        vmaDestroyImage(_allocator, _colourImage, _colourImageAllocation);
 
         for (auto framebuffer : _swapChainFramebuffers)
         {
@@ -1901,6 +2342,25 @@ namespace Gust
         vkDestroySwapchainKHR(_device, _swapChain, nullptr);
     }
 
+    void WindowsWindow::retireSwapChainResources()
+    {
+        _deletionQueue->retireImageView(_frameNumber, _depthImageView);
+        _deletionQueue->retireImage(_frameNumber, _depthImage, _depthImageAllocation);
+
+        _deletionQueue->retireImageView(_frameNumber, _colourImageView);
+        _deletionQueue->retireImage(_frameNumber, _colourImage, _colourImageAllocation);
+
+        for (auto framebuffer : _swapChainFramebuffers)
+        {
+            _deletionQueue->retireFramebuffer(_frameNumber, framebuffer);
+        }
+
+        for (auto imageView : _swapChainImageViews)
+        {
+            _deletionQueue->retireImageView(_frameNumber, imageView);
+        }
+    }
+
     void WindowsWindow::recreateSwapChain()
     {
         int width = 0, height = 0;
@@ -1912,36 +2372,19 @@ namespace Gust
             glfwWaitEvents();
         }
 
-        vkDeviceWaitIdle(_device);
-
-        swapChainCleanUp();
+        //Frames still in flight may be drawing into the old swap chain, so it
+        //is retired behind them rather than waiting for the device to idle.
+        VkSwapchainKHR oldSwapChain = _swapChain;
+        retireSwapChainResources();
 
         createSwapChain();
+        _deletionQueue->retireSwapchain(_frameNumber, oldSwapChain);
         createImageView();
         createColourResources();
         createDepthResources();
         createFramebuffers();
     }
 
-    std::vector<char> WindowsWindow::readFile(const std::string& filename) 
-    {
-        std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-        if (!file.is_open())
-        {
-            GUST_CRITICAL("Shader file failed to open {0}", filename);
-        }
-
-        size_t fileSize = static_cast<size_t>(file.tellg());
-        std::vector<char> fileBuffer(fileSize);
-
-        file.seekg(0);
-        file.read(fileBuffer.data(), fileSize);
-
-        file.close();
-        return fileBuffer;
-    }
-
     void WindowsWindow::framebufferResizeCallback(GLFWwindow* window, int width, int height)
     {
         auto app = reinterpret_cast<WindowsWindow*>(glfwGetWindowUserPointer(window));
@@ -6,8 +6,14 @@
 //Needed to make the GLEW linking is linking to the static version.
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#include <vma/vk_mem_alloc.h>
 
 #include "Gust/Core/Window.h"
+#include "Gust/Assets/CookedAssets.h"
+#include "Gust/Renderer/GeometryArena.h"
+#include "Gust/Renderer/Handle.h"
+#include "Gust/Renderer/PipelineManager.h"
+#include "Gust/Renderer/ShaderReflection.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZEOR_TO_ONE
@@ -22,6 +28,8 @@ namespace
     {
         std::optional<uint32_t> graphicsFamily;
         std::optional<uint32_t> presentFamily;
+        //A copy only family when there is one, otherwise graphics.
+        std::optional<uint32_t> transferFamily;
 
         bool isComplete()
         {
@@ -42,38 +50,6 @@ namespace
         glm::vec3 colour;
         glm::vec2 texCoord;
 
-        static VkVertexInputBindingDescription getBindindDescription()
-        {
-            VkVertexInputBindingDescription bindingDescription{};
-            bindingDescription.binding = 0;
-            bindingDescription.stride = sizeof(Vertex);
-            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-            return bindingDescription;
-        }
-
-        static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions()
-        {
-            std::array<VkVertexInputAttributeDescription, 3> attributeDescription{};
-            attributeDescription[0].binding = 0;
-
-            attributeDescription[0].location = 0;
-            attributeDescription[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-            attributeDescription[0].offset = offsetof(Vertex, pos);
-
-            attributeDescription[1].binding = 0;
-            attributeDescription[1].location = 1;
-            attributeDescription[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-            attributeDescription[1].offset = offsetof(Vertex, colour);
-
-            attributeDescription[2].binding = 0;
-            attributeDescription[2].location = 2;
-            attributeDescription[2].format = VK_FORMAT_R32G32_SFLOAT;
-            attributeDescription[2].offset = offsetof(Vertex, texCoord);
-
-            return attributeDescription;
-        }
-
         bool operator==(const Vertex& other) const
         {
             return pos == other.pos && colour == other.colour && texCoord == other.texCoord;
@@ -85,6 +61,20 @@ namespace
 namespace Gust 
 {
     class GraphicsContext;
+    class AssetReloader;
+    class WorldStreamer;
+    class StagingRing;
+    class FrameAllocator;
+    class DescriptorAllocator;
+    class BindlessDescriptors;
+    class DeletionQueue;
+    class GpuResources;
+    class PipelineCache;
+    class ShaderCompiler;
+    class ShaderVariants;
+    class LayoutCache;
+    class RenderPassCache;
+    struct GpuTexture;
 
     //This is the Windows OS windo versoin.
     class WindowsWindow : public Window
@@ -107,8 +97,17 @@ namespace Gust
 
         void drawFrame();
         virtual void waitDevice() override;
+        virtual void setScene(Scene* scene) override;
+        virtual GpuMemoryStats getGpuMemoryStats() const override;
 
     private:
+        struct GpuMesh
+        {
+            GeometryAllocation geometry;
+            //Not drawn until the upload timeline reaches this.
+            uint64_t uploadValue = 0;
+        };
+
         virtual void init(const WindowProps& props);
         virtual void shutdown();
 
@@ -120,9 +119,12 @@ namespace Gust
         void createSurface();
         void pickPhysicalDevice();
         void createLogicalDevice();
+        void createAllocator();
+        void createPipelineCache();
         void createSwapChain();
         void createImageView();
         void createRenderPass();
+        void createBindlessDescriptors();
         void createDescriptionSetLayout();
         void createGraphicsPipeline();
         void createCommandPool();
@@ -130,23 +132,44 @@ namespace Gust
         void createDepthResources();
         void createFramebuffers();
         void createTextureImage();
-        void createTextureImageView();
+        void createTextureImage(const CookedTexture& texture);
+        bool loadTextureData(const std::string& filePath, CookedTexture& texture);
+        void createTextureImageView(GpuTexture& texture);
         void createTextureSampler();
         void loadModel();
-        void createVertexBuffer();
-        void createIndexBuffer();
+        void createGeometryArena();
+        void createModelGeometry();
+        bool uploadMesh(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, GpuMesh& gpuMesh);
+        void uploadStreamedMesh(uint32_t mesh, const CookedMesh& data);
+        void releaseStreamedMesh(uint32_t mesh);
         void createUniformBuffers();
-        void createDescriptorPool();
-        void createDescriptorSets();
+        void createDescriptorAllocator();
+        void allocateFrameDescriptorSet();
         void createCommandBuffers();
         void createSyncObjects();
+        void initAssetReloading();
+        void initShaderReloading();
+
+        //Which resource owns an allocation, stored in its VMA user data so
+        //the defragmenter can find the handle to swap.
+        enum class GpuResourceKind : uint32_t
+        {
+            NONE = 0,
+            TEXTURE
+        };
+        void tagAllocation(VmaAllocation allocation, GpuResourceKind kind, uint32_t index = 0);
+        void defragmentGpuMemory();
+        VkDeviceSize moveAllocation(VkCommandBuffer commandBuffer, VmaDefragmentationMove& move, std::vector<std::pair<VkImage, VkImageView>>& oldImages);
+        VkDeviceSize moveTexture(VkCommandBuffer commandBuffer, TextureHandle handle, VmaDefragmentationMove& move, std::vector<std::pair<VkImage, VkImageView>>& oldImages);
+        void finishDefragmentation();
+
 
         void swapChainCleanUp();
+        void retireSwapChainResources();
         void recreateSwapChain();
 
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
 
-        VkShaderModule createShaderModule(const std::vector<char>& code);
         VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
         VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
         VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
@@ -157,10 +180,9 @@ namespace Gust
         std::vector<const char*> getRequiredExtensions();
         bool checkValidationLayerSupport();
 
-        void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
-        void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
-        void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
-        void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+        void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VmaAllocationCreateFlags allocationFlags, VkImage& image, VmaAllocation& allocation, VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_AUTO);
+        void createTransientAttachment(VkFormat format, VkImageUsageFlags usage, VkImage& image, VmaAllocation& allocation);
+        void logTransientAttachmentMemory();
         VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlagBits aspectsFlags, uint32_t mipLevels);
 
         VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling  tiling, VkFormatFeatureFlags features);
@@ -168,16 +190,14 @@ namespace Gust
         VkFormat findDepthFormat();
         bool hadStencilComponent(VkFormat format);
 
-        void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
-        VkCommandBuffer beginSingleTimeCommands();
-        void endSingleTimeCommand(VkCommandBuffer commandBuffer);
-        void copyBuffer(VkBuffer sourceBuffer, VkBuffer destBuffer, VkDeviceSize size);
+        void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaAllocationCreateFlags allocationFlags, VkBuffer& buffer, VmaAllocation& allocation, void** mapped = nullptr);
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool isDeviceExtensionSupported(VkPhysicalDevice device, const char* extensionName);
         void updateUniformBuffer(uint32_t currentImage);
-        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
         void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+        void recordStreamedObjects(VkCommandBuffer commandBuffer);
+        void pushDrawConstants(VkCommandBuffer commandBuffer, const glm::mat4& model, uint32_t textureIndex);
 
-        static std::vector<char> readFile(const std::string& filename);
 
         static void framebufferResizeCallback(GLFWwindow* window, int width, int height);
 
@@ -194,12 +214,22 @@ namespace Gust
 
         VkPhysicalDevice _physicalDevice = VK_NULL_HANDLE;
         VkSampleCountFlagBits _msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+        bool _textureCompressionBC = false;
+        bool _memoryBudgetSupported = false;
+        bool _graphicsPipelineLibrary = false;
+        //Tilers can back transient attachments with on chip memory only.
+        bool _lazilyAllocatedMemory = false;
         VkDevice _device;
+        VmaAllocator _allocator;
+        std::unique_ptr<MemoryBudget> _memoryBudget;
 
         VkQueue _graphicsQueue;
         VkQueue _presentQueue;
+        //Uploads go here. Same as the graphics queue on hardware without a
+        //separate copy engine.
+        VkQueue _transferQueue;
 
-        VkSwapchainKHR _swapChain;
+        VkSwapchainKHR _swapChain = VK_NULL_HANDLE;
         std::vector<VkImage> _swapChainImages;
         VkFormat _swapChainImageFormat;
         VkExtent2D _swapChainExtent;
@@ -208,44 +238,82 @@ namespace Gust
 
         VkRenderPass _renderPass;
         VkDescriptorSetLayout _descriptorSetLayout;
+        std::unique_ptr<PipelineCache> _pipelineCache;
+        std::unique_ptr<ShaderCompiler> _shaderCompiler;
+        std::unique_ptr<ShaderVariants> _shaderVariants;
+        std::unique_ptr<LayoutCache> _layoutCache;
+        std::unique_ptr<RenderPassCache> _renderPassCache;
+        std::unique_ptr<BindlessDescriptors> _bindless;
+        std::unique_ptr<PipelineManager> _pipelineManager;
         VkPipelineLayout _pipelineLayout;
-        VkPipeline _graphicsPipeline;
+        //The default pipeline. Materials are variations on it.
+        PipelineDescription _pipelineDescription;
+        //Reflected from the default shaders.
+        ShaderLayout _shaderLayout;
+        PipelineHandle _graphicsPipeline;
 
         VkCommandPool _commandPool;
+        std::unique_ptr<StagingRing> _stagingRing;
+        //Upload timeline value the next frame can't be drawn without, for
+        //resources that are swapped in straight away.
+        uint64_t _requiredUploadValue = 0;
+        uint64_t _completedUploadValue = 0;
+        uint64_t _uploadWaitValue = 0;
+        bool _waitOnUploads = false;
 
         VkImage _colourImage;
-        VkDeviceMemory _colourImageMemory;
+        VmaAllocation _colourImageAllocation;
         VkImageView _colourImageView;
 
         VkImage _depthImage;
-        VkDeviceMemory _depthImageMemory;
+        VmaAllocation _depthImageAllocation;
         VkImageView _depthImageView;
 
-        uint32_t _mipLevels;
-        VkImage _textureImage;
-        VkDeviceMemory _textureImageMemory;
-        VkImageView _textureImageView;
+        TextureHandle _texture;
         VkSampler _textureSampler;
 
         std::vector<Vertex> _vertices;
         std::vector<uint32_t> _indices;
-        VkBuffer _vertexBuffer;
-        VkDeviceMemory _vertexBufferMemory;
-        VkBuffer _indexBuffer;
-        VkDeviceMemory _indexBufferMemory;
-
-        std::vector<VkBuffer> _uniformBuffers;
-        std::vector<VkDeviceMemory> _uniformBufferMemory;
-        std::vector<void*> _uniformBufferMapped;
+        std::unique_ptr<GeometryArena> _geometryArena;
+        GpuMesh _demoMesh;
+        //Spins the demo model when there is no level loaded.
+        glm::mat4 _demoModelTransform = glm::mat4(1.f);
+
+        Scene* _scene = nullptr;
+        std::unique_ptr<WorldStreamer> _worldStreamer;
+        //Indexed by the scene's mesh index, empty until streamed in.
+        std::vector<GpuMesh> _streamedMeshes;
+        //Indexed by the scene's material index, null until compiled.
+        std::vector<PipelineHandle> _materialPipelines;
+        std::vector<uint32_t> _visibleObjects;
+
+        std::unique_ptr<FrameAllocator> _frameUniforms;
+        uint32_t _cameraUniformOffset = 0;
         std::vector<VkCommandBuffer> _commandBuffers;
 
-        VkDescriptorPool _descriptorPool;
-        std::vector<VkDescriptorSet> _descriptorSets;
+        std::unique_ptr<DescriptorAllocator> _frameDescriptors;
+        VkDescriptorUpdateTemplate _descriptorUpdateTemplate;
+        VkDescriptorSet _frameDescriptorSet = VK_NULL_HANDLE;
 
         std::vector<VkSemaphore> _imageAvailableSemaphores;
         std::vector<VkSemaphore> _renderFinishedSemaphores;
         std::vector<VkFence> _inFlightFences;
         uint32_t _currentFrame = 0;
+        uint64_t _frameNumber = 0;
+
+        std::unique_ptr<DeletionQueue> _deletionQueue;
+        std::unique_ptr<GpuResources> _resources;
+
+        VmaDefragmentationContext _defragmentationContext = VK_NULL_HANDLE;
+        bool _defragmentationPassPending = false;
+        //Set by the memory budget to start a pass without waiting for the
+        //next check or the fragmentation threshold.
+        bool _defragmentationRequested = false;
+        uint64_t _defragmentedBytes = 0;
+        uint64_t _totalDefragmentedBytes = 0;
+        std::unique_ptr<AssetReloader> _assetReloader;
+        //Watches the GLSL, only when it can be compiled here.
+        std::unique_ptr<AssetReloader> _shaderReloader;
 
         //This structure allow use to pass in the window data to GLFW
         //without the need to pass in the WindowsWindow class meaning we can
@@ -0,0 +1,205 @@
+#include "PreComp.h"
+#include "BindlessDescriptors.h"
+#include "DeletionQueue.h"
+
+#include "Gust/Core/Core.h"
+
+namespace Gust
+{
+    BindlessDescriptors::BindlessDescriptors(VkDevice device, VkPhysicalDevice physicalDevice, DeletionQueue& deletionQueue, uint32_t maxTextures, uint32_t maxBuffers) :
+        _device(device), _deletionQueue(deletionQueue)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        VkPhysicalDeviceVulkan12Properties vulkan12Properties{};
+        vulkan12Properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+        VkPhysicalDeviceProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &vulkan12Properties;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+        _stats.textureCapacity = std::min({ maxTextures, vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages,
+                                            vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages });
+        _stats.bufferCapacity = std::min({ maxBuffers, vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                                           vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+
+        std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+        bindings[BINDLESS_TEXTURE_BINDING] = { BINDLESS_TEXTURE_BINDING, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, _stats.textureCapacity, VK_SHADER_STAGE_ALL, nullptr };
+        bindings[BINDLESS_BUFFER_BINDING] = { BINDLESS_BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _stats.bufferCapacity, VK_SHADER_STAGE_ALL, nullptr };
+        bindings[BINDLESS_SAMPLER_BINDING] = { BINDLESS_SAMPLER_BINDING, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_ALL, nullptr };
+
+        //Partially bound so unused slots never need a dummy descriptor.
+        VkDescriptorBindingFlags arrayFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                              VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        std::array<VkDescriptorBindingFlags, 3> bindingFlags = { arrayFlags, arrayFlags, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT };
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.pNext = &bindingFlagsInfo;
+        layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        VkResult result = vkCreateDescriptorSetLayout(_device, &layoutInfo, nullptr, &_layout);
+        GUST_CORE_ASSERT("Failed to create the bindless set layout.", result != VK_SUCCESS);
+
+        std::array<VkDescriptorPoolSize, 3> poolSizes =
+        {{
+            { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, _stats.textureCapacity },
+            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, _stats.bufferCapacity },
+            { VK_DESCRIPTOR_TYPE_SAMPLER, 1 }
+        }};
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = 1;
+
+        result = vkCreateDescriptorPool(_device, &poolInfo, nullptr, &_pool);
+        GUST_CORE_ASSERT("Failed to create the bindless descriptor pool.", result != VK_SUCCESS);
+
+        VkDescriptorSetAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = _pool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &_layout;
+
+        result = vkAllocateDescriptorSets(_device, &allocateInfo, &_set);
+        GUST_CORE_ASSERT("Failed to allocate the bindless descriptor set.", result != VK_SUCCESS);
+    }
+
+    BindlessDescriptors::~BindlessDescriptors()
+    {
+        vkDestroyDescriptorPool(_device, _pool, nullptr);
+        vkDestroyDescriptorSetLayout(_device, _layout, nullptr);
+    }
+
+    uint32_t BindlessDescriptors::addTexture(VkImageView view)
+    {
+        uint32_t index = allocateIndex(_freeTextures, _nextTexture, _stats.textureCapacity);
+        if (index == BINDLESS_INVALID_INDEX)
+        {
+            GUST_ERROR("Out of bindless texture slots ({0}).", _stats.textureCapacity);
+            return BINDLESS_INVALID_INDEX;
+        }
+
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.imageView = view;
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        write(BINDLESS_TEXTURE_BINDING, index, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, &imageInfo, nullptr);
+        _stats.textures++;
+        return index;
+    }
+
+    uint32_t BindlessDescriptors::addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+    {
+        uint32_t index = allocateIndex(_freeBuffers, _nextBuffer, _stats.bufferCapacity);
+        if (index == BINDLESS_INVALID_INDEX)
+        {
+            GUST_ERROR("Out of bindless buffer slots ({0}).", _stats.bufferCapacity);
+            return BINDLESS_INVALID_INDEX;
+        }
+
+        VkDescriptorBufferInfo bufferInfo{};
+        bufferInfo.buffer = buffer;
+        bufferInfo.offset = offset;
+        bufferInfo.range = range;
+        write(BINDLESS_BUFFER_BINDING, index, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &bufferInfo);
+        _stats.buffers++;
+        return index;
+    }
+
+    //The descriptor is left as it is. Frames still in flight may read it,
+    //and nothing recorded later will.
+    void BindlessDescriptors::removeTexture(uint64_t frame, uint32_t index)
+    {
+        if (index == BINDLESS_INVALID_INDEX)
+        {
+            return;
+        }
+
+        _stats.textures--;
+        _deletionQueue.retire(frame, [this, index]() { _freeTextures.push_back(index); });
+    }
+
+    void BindlessDescriptors::removeBuffer(uint64_t frame, uint32_t index)
+    {
+        if (index == BINDLESS_INVALID_INDEX)
+        {
+            return;
+        }
+
+        _stats.buffers--;
+        _deletionQueue.retire(frame, [this, index]() { _freeBuffers.push_back(index); });
+    }
+
+    void BindlessDescriptors::setSampler(VkSampler sampler)
+    {
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.sampler = sampler;
+        write(BINDLESS_SAMPLER_BINDING, 0, VK_DESCRIPTOR_TYPE_SAMPLER, &imageInfo, nullptr);
+    }
+
+    bool BindlessDescriptors::isCompatible(const std::vector<VkDescriptorSetLayoutBinding>& bindings) const
+    {
+        for (const auto& binding : bindings)
+        {
+            bool matches = false;
+            switch (binding.binding)
+            {
+            case BINDLESS_TEXTURE_BINDING:
+                matches = binding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+                break;
+            case BINDLESS_BUFFER_BINDING:
+                matches = binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                break;
+            case BINDLESS_SAMPLER_BINDING:
+                matches = binding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER && binding.descriptorCount == 1;
+                break;
+            default:
+                break;
+            }
+
+            if (matches == false)
+            {
+                GUST_ERROR("Binding {0} of the bindless set doesn't match what the engine provides.", binding.binding);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t BindlessDescriptors::allocateIndex(std::vector<uint32_t>& freeIndices, uint32_t& nextIndex, uint32_t capacity)
+    {
+        if (freeIndices.empty() == false)
+        {
+            uint32_t index = freeIndices.back();
+            freeIndices.pop_back();
+            return index;
+        }
+
+        return nextIndex < capacity ? nextIndex++ : BINDLESS_INVALID_INDEX;
+    }
+
+    void BindlessDescriptors::write(uint32_t binding, uint32_t index, VkDescriptorType type, const VkDescriptorImageInfo* imageInfo, const VkDescriptorBufferInfo* bufferInfo)
+    {
+        VkWriteDescriptorSet writeDescriptorSet{};
+        writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writeDescriptorSet.dstSet = _set;
+        writeDescriptorSet.dstBinding = binding;
+        writeDescriptorSet.dstArrayElement = index;
+        writeDescriptorSet.descriptorType = type;
+        writeDescriptorSet.descriptorCount = 1;
+        writeDescriptorSet.pImageInfo = imageInfo;
+        writeDescriptorSet.pBufferInfo = bufferInfo;
+
+        vkUpdateDescriptorSets(_device, 1, &writeDescriptorSet, 0, nullptr);
+    }
+}
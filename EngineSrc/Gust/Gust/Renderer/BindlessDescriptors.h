@@ -0,0 +1,83 @@
+#ifndef BINDLESS_DESCRIPTORS_HDR
+#define BINDLESS_DESCRIPTORS_HDR
+
+#include "PreComp.h"
+
+#include <vulkan/vulkan.h>
+
+namespace Gust
+{
+    class DeletionQueue;
+
+    //The set number shaders declare the bindless arrays in.
+    const uint32_t BINDLESS_SET = 1;
+    //Binding numbers in the bindless set, shaders declare them as
+    //  layout(set = 1, binding = 0) uniform texture2D bindlessTextures[];
+    //  layout(set = 1, binding = 1) readonly buffer Buffer { ... } bindlessBuffers[];
+    //  layout(set = 1, binding = 2) uniform sampler bindlessSampler;
+    const uint32_t BINDLESS_TEXTURE_BINDING = 0;
+    const uint32_t BINDLESS_BUFFER_BINDING = 1;
+    const uint32_t BINDLESS_SAMPLER_BINDING = 2;
+    //Never handed out, an index that was never given a slot.
+    const uint32_t BINDLESS_INVALID_INDEX = UINT32_MAX;
+
+    struct BindlessStats
+    {
+        uint32_t textures = 0;
+        uint32_t buffers = 0;
+        uint32_t textureCapacity = 0;
+        uint32_t bufferCapacity = 0;
+    };
+
+    //One descriptor set holding every texture and storage buffer, bound
+    //once per command buffer. Shaders pick what they read with a 32 bit
+    //index, so draws never rebind descriptors and can be batched whatever
+    //they sample. Uses descriptor indexing: the arrays are partially bound
+    //so empty slots are fine, and slots can be written while the set is
+    //bound as long as nothing in flight reads them. A removed slot is only
+    //handed out again once its frame has finished. Main thread only.
+    class BindlessDescriptors
+    {
+    public:
+        //Capacities are clamped to what the device allows.
+        BindlessDescriptors(VkDevice device, VkPhysicalDevice physicalDevice, DeletionQueue& deletionQueue, uint32_t maxTextures, uint32_t maxBuffers);
+        ~BindlessDescriptors();
+
+        BindlessDescriptors(const BindlessDescriptors&) = delete;
+        BindlessDescriptors& operator=(const BindlessDescriptors&) = delete;
+
+        //The view must be in SHADER_READ_ONLY_OPTIMAL when it is sampled.
+        uint32_t addTexture(VkImageView view);
+        uint32_t addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+        //The slot stays valid for frames already recorded.
+        void removeTexture(uint64_t frame, uint32_t index);
+        void removeBuffer(uint64_t frame, uint32_t index);
+        void setSampler(VkSampler sampler);
+
+        //Whether reflected bindings for BINDLESS_SET fit the set's layout.
+        bool isCompatible(const std::vector<VkDescriptorSetLayoutBinding>& bindings) const;
+
+        VkDescriptorSetLayout getLayout() const { return _layout; }
+        VkDescriptorSet getSet() const { return _set; }
+        const BindlessStats& getStats() const { return _stats; }
+    private:
+        uint32_t allocateIndex(std::vector<uint32_t>& freeIndices, uint32_t& nextIndex, uint32_t capacity);
+        void write(uint32_t binding, uint32_t index, VkDescriptorType type, const VkDescriptorImageInfo* imageInfo, const VkDescriptorBufferInfo* bufferInfo);
+    private:
+        VkDevice _device;
+        DeletionQueue& _deletionQueue;
+
+        VkDescriptorSetLayout _layout = VK_NULL_HANDLE;
+        VkDescriptorPool _pool = VK_NULL_HANDLE;
+        VkDescriptorSet _set = VK_NULL_HANDLE;
+
+        std::vector<uint32_t> _freeTextures;
+        std::vector<uint32_t> _freeBuffers;
+        uint32_t _nextTexture = 0;
+        uint32_t _nextBuffer = 0;
+
+        BindlessStats _stats;
+    };
+}
+
+#endif // !BINDLESS_DESCRIPTORS_HDR
@@ -0,0 +1,154 @@
+#include "PreComp.h"
+#include "DeletionQueue.h"
+
+namespace Gust
+{
+    DeletionQueue::DeletionQueue(VkDevice device, VmaAllocator allocator) : _device(device), _allocator(allocator)
+    {
+    }
+
+    DeletionQueue::~DeletionQueue()
+    {
+        if (empty() == false)
+        {
+            GUST_WARN("{0} retired GPU resources were never destroyed.", size());
+        }
+    }
+
+    void DeletionQueue::retireBuffer(uint64_t frame, VkBuffer buffer, VmaAllocation allocation)
+    {
+        push(frame, Kind::BUFFER, buffer, allocation);
+    }
+
+    void DeletionQueue::retireImage(uint64_t frame, VkImage image, VmaAllocation allocation)
+    {
+        push(frame, Kind::IMAGE, image, allocation);
+    }
+
+    void DeletionQueue::retireImageView(uint64_t frame, VkImageView imageView)
+    {
+        push(frame, Kind::IMAGE_VIEW, imageView);
+    }
+
+    void DeletionQueue::retireSampler(uint64_t frame, VkSampler sampler)
+    {
+        push(frame, Kind::SAMPLER, sampler);
+    }
+
+    void DeletionQueue::retirePipeline(uint64_t frame, VkPipeline pipeline)
+    {
+        push(frame, Kind::PIPELINE, pipeline);
+    }
+
+    void DeletionQueue::retireFramebuffer(uint64_t frame, VkFramebuffer framebuffer)
+    {
+        push(frame, Kind::FRAMEBUFFER, framebuffer);
+    }
+
+    void DeletionQueue::retireSwapchain(uint64_t frame, VkSwapchainKHR swapchain)
+    {
+        push(frame, Kind::SWAPCHAIN, swapchain);
+    }
+
+    void DeletionQueue::retire(uint64_t frame, std::function<void()> destroy)
+    {
+        Entry entry;
+        entry.frame = frame;
+        entry.destroy = std::move(destroy);
+        _entries.push_back(std::move(entry));
+    }
+
+    void DeletionQueue::retire(uint64_t frame, VkSemaphore timeline, uint64_t value, std::function<void()> destroy)
+    {
+        Entry entry;
+        entry.frame = frame;
+        entry.destroy = std::move(destroy);
+        entry.timeline = timeline;
+        entry.value = value;
+        _timelineEntries.push_back(std::move(entry));
+    }
+
+    void DeletionQueue::collect(uint64_t completedFrames)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        while (_entries.empty() == false && _entries.front().frame < completedFrames)
+        {
+            destroy(_entries.front());
+            _entries.pop_front();
+        }
+
+        for (size_t i = 0; i < _timelineEntries.size();)
+        {
+            Entry& entry = _timelineEntries[i];
+            uint64_t value = 0;
+            if (entry.frame < completedFrames && vkGetSemaphoreCounterValue(_device, entry.timeline, &value) == VK_SUCCESS && value >= entry.value)
+            {
+                destroy(entry);
+                std::swap(entry, _timelineEntries.back());
+                _timelineEntries.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+
+    void DeletionQueue::flush()
+    {
+        GUST_PROFILE_FUNCTION();
+
+        for (auto& entry : _entries)
+        {
+            destroy(entry);
+        }
+        _entries.clear();
+
+        for (auto& entry : _timelineEntries)
+        {
+            destroy(entry);
+        }
+        _timelineEntries.clear();
+    }
+
+    void DeletionQueue::destroy(Entry& entry)
+    {
+        switch (entry.kind)
+        {
+        case Kind::CALLBACK:
+            entry.destroy();
+            break;
+        case Kind::BUFFER:
+            vmaDestroyBuffer(_allocator, reinterpret_cast<VkBuffer>(entry.handle), entry.allocation);
+            break;
+        case Kind::IMAGE:
+            if (entry.allocation != VK_NULL_HANDLE)
+            {
+                vmaDestroyImage(_allocator, reinterpret_cast<VkImage>(entry.handle), entry.allocation);
+            }
+            else
+            {
+                vkDestroyImage(_device, reinterpret_cast<VkImage>(entry.handle), nullptr);
+            }
+            break;
+        case Kind::IMAGE_VIEW:
+            vkDestroyImageView(_device, reinterpret_cast<VkImageView>(entry.handle), nullptr);
+            break;
+        case Kind::SAMPLER:
+            vkDestroySampler(_device, reinterpret_cast<VkSampler>(entry.handle), nullptr);
+            break;
+        case Kind::PIPELINE:
+            vkDestroyPipeline(_device, reinterpret_cast<VkPipeline>(entry.handle), nullptr);
+            break;
+        case Kind::FRAMEBUFFER:
+            vkDestroyFramebuffer(_device, reinterpret_cast<VkFramebuffer>(entry.handle), nullptr);
+            break;
+        case Kind::SWAPCHAIN:
+            vkDestroySwapchainKHR(_device, reinterpret_cast<VkSwapchainKHR>(entry.handle), nullptr);
+            break;
+        }
+
+        _destroyed++;
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef DELETION_QUEUE_HDR
+#define DELETION_QUEUE_HDR
+
+#include "PreComp.h"
+
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+namespace Gust
+{
+    //Holds on to released GPU resources until nothing can still be using
+    //them. Each one is tagged with the last frame that used it and goes once
+    //that frame has passed its fence, so releasing never waits on the device.
+    //Resources written by another queue can also wait on a timeline value.
+    class DeletionQueue
+    {
+    public:
+        DeletionQueue(VkDevice device, VmaAllocator allocator);
+        ~DeletionQueue();
+
+        DeletionQueue(const DeletionQueue&) = delete;
+        DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+        void retireBuffer(uint64_t frame, VkBuffer buffer, VmaAllocation allocation);
+        //Allocation can be null for an image bound to memory owned elsewhere.
+        void retireImage(uint64_t frame, VkImage image, VmaAllocation allocation);
+        void retireImageView(uint64_t frame, VkImageView imageView);
+        void retireSampler(uint64_t frame, VkSampler sampler);
+        void retirePipeline(uint64_t frame, VkPipeline pipeline);
+        void retireFramebuffer(uint64_t frame, VkFramebuffer framebuffer);
+        void retireSwapchain(uint64_t frame, VkSwapchainKHR swapchain);
+        //Anything that isn't a plain handle, like handing a range back to a
+        //sub allocator.
+        void retire(uint64_t frame, std::function<void()> destroy);
+        //Also waits for timeline to reach value, for resources another queue
+        //may still be writing.
+        void retire(uint64_t frame, VkSemaphore timeline, uint64_t value, std::function<void()> destroy);
+
+        //Every frame before completedFrames has finished on the GPU.
+        void collect(uint64_t completedFrames);
+        //Destroys everything. Only once the device is idle.
+        void flush();
+
+        bool empty() const { return _entries.empty() && _timelineEntries.empty(); }
+        size_t size() const { return _entries.size() + _timelineEntries.size(); }
+        uint64_t getDestroyedCount() const { return _destroyed; }
+    private:
+        enum class Kind
+        {
+            CALLBACK,
+            BUFFER,
+            IMAGE,
+            IMAGE_VIEW,
+            SAMPLER,
+            PIPELINE,
+            FRAMEBUFFER,
+            SWAPCHAIN
+        };
+
+        struct Entry
+        {
+            uint64_t frame = 0;
+            Kind kind = Kind::CALLBACK;
+            uint64_t handle = 0;
+            VmaAllocation allocation = VK_NULL_HANDLE;
+            std::function<void()> destroy;
+
+            VkSemaphore timeline = VK_NULL_HANDLE;
+            uint64_t value = 0;
+        };
+
+        template<typename Handle>
+        void push(uint64_t frame, Kind kind, Handle handle, VmaAllocation allocation = VK_NULL_HANDLE)
+        {
+            Entry entry;
+            entry.frame = frame;
+            entry.kind = kind;
+            entry.handle = reinterpret_cast<uint64_t>(handle);
+            entry.allocation = allocation;
+            _entries.push_back(std::move(entry));
+        }
+
+        void destroy(Entry& entry);
+    private:
+        VkDevice _device;
+        VmaAllocator _allocator;
+
+        //Frames only go up so these are destroyed strictly in order.
+        std::deque<Entry> _entries;
+        //Could be waiting on any value, checked one by one.
+        std::vector<Entry> _timelineEntries;
+        uint64_t _destroyed = 0;
+    };
+}
+
+#endif // !DELETION_QUEUE_HDR
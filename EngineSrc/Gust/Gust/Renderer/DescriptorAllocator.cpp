@@ -0,0 +1,136 @@
+#include "PreComp.h"
+#include "DescriptorAllocator.h"
+
+#include "Gust/Core/Core.h"
+
+namespace
+{
+    //Past this a bigger pool saves nothing, it's just more to reset.
+    const uint32_t MAX_SETS_PER_POOL = 4096;
+}
+
+namespace Gust
+{
+    DescriptorAllocator::DescriptorAllocator(VkDevice device, const std::vector<VkDescriptorPoolSize>& sizesPerSet, uint32_t setsPerPool, uint32_t frameCount) :
+        _device(device), _sizesPerSet(sizesPerSet), _setsPerPool(std::max(setsPerPool, 1u)), _frames(frameCount)
+    {
+    }
+
+    DescriptorAllocator::~DescriptorAllocator()
+    {
+        for (FramePools& frame : _frames)
+        {
+            for (VkDescriptorPool pool : frame.used)
+            {
+                vkDestroyDescriptorPool(_device, pool, nullptr);
+            }
+            for (VkDescriptorPool pool : frame.free)
+            {
+                vkDestroyDescriptorPool(_device, pool, nullptr);
+            }
+        }
+    }
+
+    void DescriptorAllocator::beginFrame(uint32_t frame)
+    {
+        _frame = frame;
+
+        FramePools& pools = _frames[frame];
+        for (VkDescriptorPool pool : pools.used)
+        {
+            vkResetDescriptorPool(_device, pool, 0);
+            pools.free.push_back(pool);
+        }
+        pools.used.clear();
+        pools.sets = 0;
+    }
+
+    VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+    {
+        FramePools& frame = _frames[_frame];
+
+        VkDescriptorSetAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &layout;
+
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        allocateInfo.descriptorPool = frame.used.empty() ? nextPool(frame) : frame.used.back();
+        VkResult result = vkAllocateDescriptorSets(_device, &allocateInfo, &set);
+        if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+        {
+            allocateInfo.descriptorPool = nextPool(frame);
+            result = vkAllocateDescriptorSets(_device, &allocateInfo, &set);
+        }
+
+        //Out of a brand new pool means the layout needs descriptors the
+        //pool sizes never included.
+        if (result != VK_SUCCESS)
+        {
+            GUST_ERROR("Failed to allocate a descriptor set ({0}).", static_cast<int32_t>(result));
+            return VK_NULL_HANDLE;
+        }
+
+        frame.sets++;
+        _stats.sets++;
+        _stats.peakSets = std::max(_stats.peakSets, frame.sets);
+        return set;
+    }
+
+    VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout, VkDescriptorUpdateTemplate updateTemplate, const DescriptorInfo* data)
+    {
+        VkDescriptorSet set = allocate(layout);
+        if (set != VK_NULL_HANDLE)
+        {
+            vkUpdateDescriptorSetWithTemplate(_device, set, updateTemplate, data);
+        }
+        return set;
+    }
+
+    std::vector<VkDescriptorPoolSize> DescriptorAllocator::poolSizesFor(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+    {
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for (const auto& binding : bindings)
+        {
+            auto existing = std::find_if(poolSizes.begin(), poolSizes.end(), [&binding](const VkDescriptorPoolSize& size) { return size.type == binding.descriptorType; });
+            if (existing == poolSizes.end())
+            {
+                poolSizes.push_back({ binding.descriptorType, 0 });
+                existing = poolSizes.end() - 1;
+            }
+            existing->descriptorCount += binding.descriptorCount;
+        }
+        return poolSizes;
+    }
+
+    VkDescriptorPool DescriptorAllocator::nextPool(FramePools& frame)
+    {
+        if (frame.free.empty() == false)
+        {
+            frame.used.push_back(frame.free.back());
+            frame.free.pop_back();
+            return frame.used.back();
+        }
+
+        std::vector<VkDescriptorPoolSize> poolSizes = _sizesPerSet;
+        for (auto& size : poolSizes)
+        {
+            size.descriptorCount *= _setsPerPool;
+        }
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolInfo.pPoolSizes = poolSizes.data();
+        poolInfo.maxSets = _setsPerPool;
+
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        VkResult result = vkCreateDescriptorPool(_device, &poolInfo, nullptr, &pool);
+        GUST_CORE_ASSERT("Failed to create a descriptor pool.", result != VK_SUCCESS);
+
+        frame.used.push_back(pool);
+        _stats.pools++;
+        _setsPerPool = std::min(_setsPerPool * 2, MAX_SETS_PER_POOL);
+        return pool;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef DESCRIPTOR_ALLOCATOR_HDR
+#define DESCRIPTOR_ALLOCATOR_HDR
+
+#include "PreComp.h"
+
+#include <vulkan/vulkan.h>
+
+namespace Gust
+{
+    //One descriptor's worth of update data. Update templates read an array
+    //of these, one per descriptor in binding order, see
+    //LayoutCache::getUpdateTemplate.
+    union DescriptorInfo
+    {
+        VkDescriptorBufferInfo buffer;
+        VkDescriptorImageInfo image;
+        VkBufferView texelBuffer;
+    };
+
+    struct DescriptorAllocatorStats
+    {
+        uint32_t pools = 0;
+        //Sets handed out since the start, across every reset.
+        uint64_t sets = 0;
+        //Most sets any one frame needed.
+        uint32_t peakSets = 0;
+    };
+
+    //Descriptor pools chained per frame in flight. When a frame's pool runs
+    //out another is made, twice the size, so running out is never an error.
+    //Sets aren't freed one at a time, beginning a frame resets all of that
+    //frame's pools at once. A single frame that is never begun again is a
+    //plain growable allocator for sets that live for good. Main thread only.
+    class DescriptorAllocator
+    {
+    public:
+        //sizesPerSet are the descriptors one set needs, see poolSizesFor.
+        DescriptorAllocator(VkDevice device, const std::vector<VkDescriptorPoolSize>& sizesPerSet, uint32_t setsPerPool, uint32_t frameCount);
+        ~DescriptorAllocator();
+
+        DescriptorAllocator(const DescriptorAllocator&) = delete;
+        DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+        //Only call once the frame's fence has signalled.
+        void beginFrame(uint32_t frame);
+        VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+        //Allocates and writes the set in one go. data is one DescriptorInfo
+        //per descriptor in the layout the template was made for.
+        VkDescriptorSet allocate(VkDescriptorSetLayout layout, VkDescriptorUpdateTemplate updateTemplate, const DescriptorInfo* data);
+
+        //Sums the descriptors of each type a set with these bindings uses.
+        static std::vector<VkDescriptorPoolSize> poolSizesFor(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+        const DescriptorAllocatorStats& getStats() const { return _stats; }
+    private:
+        struct FramePools
+        {
+            //The last one is the one being allocated from.
+            std::vector<VkDescriptorPool> used;
+            //Reset and waiting to be used again.
+            std::vector<VkDescriptorPool> free;
+            uint32_t sets = 0;
+        };
+
+        VkDescriptorPool nextPool(FramePools& frame);
+    private:
+        VkDevice _device;
+        std::vector<VkDescriptorPoolSize> _sizesPerSet;
+        uint32_t _setsPerPool;
+
+        std::vector<FramePools> _frames;
+        uint32_t _frame = 0;
+
+        DescriptorAllocatorStats _stats;
+    };
+}
+
+#endif // !DESCRIPTOR_ALLOCATOR_HDR
@@ -0,0 +1,62 @@
+#include "PreComp.h"
+#include "FrameAllocator.h"
+
+#include "Gust/Core/Core.h"
+
+namespace Gust
+{
+    FrameAllocator::FrameAllocator(VmaAllocator allocator, VkBufferUsageFlags usage, VkDeviceSize alignment, VkDeviceSize capacityPerFrame, uint32_t frameCount) :
+        _allocator(allocator), _alignment(alignment), _capacityPerFrame((capacityPerFrame + alignment - 1) / alignment * alignment)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = _capacityPerFrame * frameCount;
+        bufferInfo.usage = usage;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VmaAllocationCreateInfo allocationCreateInfo{};
+        allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+        VmaAllocationInfo allocationInfo{};
+        VkResult result = vmaCreateBuffer(_allocator, &bufferInfo, &allocationCreateInfo, &_buffer, &_allocation, &allocationInfo);
+        GUST_CORE_ASSERT("Failed to create the frame allocator.", result != VK_SUCCESS);
+        GUST_CORE_ASSERT("Dynamic offsets are 32 bit, the frame allocator is too big.", bufferInfo.size > UINT32_MAX);
+        _mapped = static_cast<uint8_t*>(allocationInfo.pMappedData);
+    }
+
+    FrameAllocator::~FrameAllocator()
+    {
+        vmaDestroyBuffer(_allocator, _buffer, _allocation);
+    }
+
+    void FrameAllocator::beginFrame(uint32_t frame)
+    {
+        _frameStart = _capacityPerFrame * frame;
+        _frameOffset = 0;
+    }
+
+    FrameAllocation FrameAllocator::allocate(VkDeviceSize size)
+    {
+        VkDeviceSize offset = (_frameOffset + _alignment - 1) / _alignment * _alignment;
+        GUST_CORE_ASSERT("Out of per frame memory, raise the frame allocator's capacity.", offset + size > _capacityPerFrame);
+
+        _frameOffset = offset + size;
+        _peakBytes = std::max(_peakBytes, _frameOffset);
+
+        FrameAllocation allocation;
+        allocation.data = _mapped + _frameStart + offset;
+        allocation.offset = static_cast<uint32_t>(_frameStart + offset);
+        return allocation;
+    }
+
+    void FrameAllocator::flush()
+    {
+        if (_frameOffset > 0)
+        {
+            vmaFlushAllocation(_allocator, _allocation, _frameStart, _frameOffset);
+        }
+    }
+}
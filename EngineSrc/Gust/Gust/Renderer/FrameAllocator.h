@@ -0,0 +1,60 @@
+#ifndef FRAME_ALLOCATOR_HDR
+#define FRAME_ALLOCATOR_HDR
+
+#include "PreComp.h"
+
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+namespace Gust
+{
+    struct FrameAllocation
+    {
+        void* data = nullptr;
+        //Offset into the shared buffer, passed as the dynamic offset.
+        uint32_t offset = 0;
+    };
+
+    //A persistently mapped buffer split into one region per frame in flight.
+    //Each frame rewinds its own region and hands out aligned sub ranges from
+    //it, so per object data costs a bump of an offset and a memcpy. Ranges
+    //are bound through dynamic offsets so one descriptor set covers them all.
+    class FrameAllocator
+    {
+    public:
+        FrameAllocator(VmaAllocator allocator, VkBufferUsageFlags usage, VkDeviceSize alignment, VkDeviceSize capacityPerFrame, uint32_t frameCount);
+        ~FrameAllocator();
+
+        FrameAllocator(const FrameAllocator&) = delete;
+        FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+        //Only call once the frame's fence has signalled.
+        void beginFrame(uint32_t frame);
+        FrameAllocation allocate(VkDeviceSize size);
+        template<typename T>
+        uint32_t push(const T& value)
+        {
+            FrameAllocation allocation = allocate(sizeof(T));
+            memcpy(allocation.data, &value, sizeof(T));
+            return allocation.offset;
+        }
+        //Makes everything written this frame visible to the GPU.
+        void flush();
+
+        VkBuffer getBuffer() const { return _buffer; }
+        VkDeviceSize getPeakBytes() const { return _peakBytes; }
+    private:
+        VmaAllocator _allocator;
+        VkBuffer _buffer;
+        VmaAllocation _allocation;
+        uint8_t* _mapped;
+
+        VkDeviceSize _alignment;
+        VkDeviceSize _capacityPerFrame;
+        VkDeviceSize _frameStart = 0;
+        VkDeviceSize _frameOffset = 0;
+        VkDeviceSize _peakBytes = 0;
+    };
+}
+
+#endif // !FRAME_ALLOCATOR_HDR
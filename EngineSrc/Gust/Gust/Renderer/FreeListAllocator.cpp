@@ -0,0 +1,94 @@
+#include "PreComp.h"
+#include "FreeListAllocator.h"
+
+#include "Gust/Core/Core.h"
+
+namespace Gust
+{
+    FreeListAllocator::FreeListAllocator(uint64_t capacity) : _capacity(capacity)
+    {
+        if (_capacity > 0)
+        {
+            addFreeRange(0, _capacity);
+        }
+    }
+
+    uint64_t FreeListAllocator::allocate(uint64_t size)
+    {
+        if (size == 0)
+        {
+            return INVALID_OFFSET;
+        }
+
+        auto bestFit = _freeBySize.lower_bound(size);
+        if (bestFit == _freeBySize.end())
+        {
+            return INVALID_OFFSET;
+        }
+
+        uint64_t rangeSize = bestFit->first;
+        uint64_t offset = bestFit->second;
+        removeFreeRange(offset, rangeSize);
+        if (rangeSize > size)
+        {
+            addFreeRange(offset + size, rangeSize - size);
+        }
+
+        _used += size;
+        return offset;
+    }
+
+    void FreeListAllocator::free(uint64_t offset, uint64_t size)
+    {
+        GUST_CORE_ASSERT("Freed a range outside the allocator.", size == 0 || offset + size > _capacity || size > _used);
+
+        _used -= size;
+
+        auto next = _freeByOffset.find(offset + size);
+        if (next != _freeByOffset.end())
+        {
+            size += next->second;
+            removeFreeRange(next->first, next->second);
+        }
+
+        auto previous = _freeByOffset.lower_bound(offset);
+        if (previous != _freeByOffset.begin())
+        {
+            --previous;
+            if (previous->first + previous->second == offset)
+            {
+                offset = previous->first;
+                size += previous->second;
+                removeFreeRange(previous->first, previous->second);
+            }
+        }
+
+        addFreeRange(offset, size);
+    }
+
+    uint64_t FreeListAllocator::getLargestFreeRange() const
+    {
+        return _freeBySize.empty() ? 0 : _freeBySize.rbegin()->first;
+    }
+
+    void FreeListAllocator::addFreeRange(uint64_t offset, uint64_t size)
+    {
+        _freeByOffset[offset] = size;
+        _freeBySize.insert({ size, offset });
+    }
+
+    void FreeListAllocator::removeFreeRange(uint64_t offset, uint64_t size)
+    {
+        _freeByOffset.erase(offset);
+
+        auto [first, last] = _freeBySize.equal_range(size);
+        for (auto it = first; it != last; ++it)
+        {
+            if (it->second == offset)
+            {
+                _freeBySize.erase(it);
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef FREE_LIST_ALLOCATOR_HDR
+#define FREE_LIST_ALLOCATOR_HDR
+
+#include "PreComp.h"
+
+namespace Gust
+{
+    //Hands out ranges of an abstract space, bytes or elements, it doesn't
+    //own any memory itself. Free ranges are kept both by offset, so freed
+    //neighbours merge back together, and by size so allocation is best fit.
+    class FreeListAllocator
+    {
+    public:
+        static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+        explicit FreeListAllocator(uint64_t capacity);
+
+        //Returns INVALID_OFFSET when no free range is big enough.
+        uint64_t allocate(uint64_t size);
+        void free(uint64_t offset, uint64_t size);
+
+        uint64_t getCapacity() const { return _capacity; }
+        uint64_t getUsed() const { return _used; }
+        uint64_t getFreeRangeCount() const { return _freeByOffset.size(); }
+        uint64_t getLargestFreeRange() const;
+    private:
+        void addFreeRange(uint64_t offset, uint64_t size);
+        void removeFreeRange(uint64_t offset, uint64_t size);
+    private:
+        uint64_t _capacity;
+        uint64_t _used = 0;
+        std::map<uint64_t, uint64_t> _freeByOffset;
+        std::multimap<uint64_t, uint64_t> _freeBySize;
+    };
+}
+
+#endif // !FREE_LIST_ALLOCATOR_HDR
@@ -0,0 +1,115 @@
+#include "PreComp.h"
+#include "GeometryArena.h"
+
+#include "Gust/Core/Core.h"
+
+namespace Gust
+{
+    GeometryArena::GeometryArena(VmaAllocator allocator, const MemoryBudget& budget, VkDeviceSize vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity, const std::vector<uint32_t>& queueFamilies) :
+        _allocator(allocator), _vertexStride(vertexStride), _concurrent(queueFamilies.size() > 1), _vertices(vertexCapacity), _indices(indexCapacity)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        _vertexBuffer = createBuffer(budget, _vertexStride * vertexCapacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, queueFamilies, _vertexAllocation);
+        _indexBuffer = createBuffer(budget, sizeof(uint32_t) * static_cast<VkDeviceSize>(indexCapacity), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, queueFamilies, _indexAllocation);
+    }
+
+    GeometryArena::~GeometryArena()
+    {
+        vmaDestroyBuffer(_allocator, _indexBuffer, _indexAllocation);
+        vmaDestroyBuffer(_allocator, _vertexBuffer, _vertexAllocation);
+    }
+
+    bool GeometryArena::allocate(uint32_t vertexCount, uint32_t indexCount, GeometryAllocation& allocation)
+    {
+        uint64_t firstVertex = _vertices.allocate(vertexCount);
+        if (firstVertex == FreeListAllocator::INVALID_OFFSET)
+        {
+            return false;
+        }
+
+        uint64_t firstIndex = _indices.allocate(indexCount);
+        if (firstIndex == FreeListAllocator::INVALID_OFFSET)
+        {
+            _vertices.free(firstVertex, vertexCount);
+            return false;
+        }
+
+        allocation.firstVertex = static_cast<uint32_t>(firstVertex);
+        allocation.vertexCount = vertexCount;
+        allocation.firstIndex = static_cast<uint32_t>(firstIndex);
+        allocation.indexCount = indexCount;
+        _meshes++;
+        return true;
+    }
+
+    void GeometryArena::free(const GeometryAllocation& allocation)
+    {
+        if (allocation.isValid() == false)
+        {
+            return;
+        }
+
+        _vertices.free(allocation.firstVertex, allocation.vertexCount);
+        _indices.free(allocation.firstIndex, allocation.indexCount);
+        _meshes--;
+    }
+
+    void GeometryArena::bind(VkCommandBuffer commandBuffer) const
+    {
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &_vertexBuffer, &offset);
+        vkCmdBindIndexBuffer(commandBuffer, _indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+
+    GeometryStats GeometryArena::getStats() const
+    {
+        GeometryStats stats;
+        stats.meshes = _meshes;
+        stats.vertices = _vertices.getUsed();
+        stats.vertexCapacity = _vertices.getCapacity();
+        stats.indices = _indices.getUsed();
+        stats.indexCapacity = _indices.getCapacity();
+        stats.freeRanges = _vertices.getFreeRangeCount() + _indices.getFreeRangeCount();
+        stats.hostResident = _hostResident;
+        return stats;
+    }
+
+    VkBuffer GeometryArena::createBuffer(const MemoryBudget& budget, VkDeviceSize size, VkBufferUsageFlags usage, const std::vector<uint32_t>& queueFamilies, VmaAllocation& allocation)
+    {
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage;
+        if (_concurrent)
+        {
+            bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+            bufferInfo.pQueueFamilyIndices = queueFamilies.data();
+        }
+        else
+        {
+            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        }
+
+        VmaAllocationCreateInfo allocationCreateInfo{};
+        allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        budget.prepareNonCritical(allocationCreateInfo, size);
+
+        VkBuffer buffer;
+        VkResult result = vmaCreateBuffer(_allocator, &bufferInfo, &allocationCreateInfo, &buffer, &allocation, nullptr);
+        if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY && allocationCreateInfo.usage != VMA_MEMORY_USAGE_AUTO_PREFER_HOST)
+        {
+            allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+            allocationCreateInfo.flags &= ~VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+            result = vmaCreateBuffer(_allocator, &bufferInfo, &allocationCreateInfo, &buffer, &allocation, nullptr);
+        }
+        if (allocationCreateInfo.usage == VMA_MEMORY_USAGE_AUTO_PREFER_HOST && _hostResident == false)
+        {
+            GUST_WARN("VRAM is over budget, the geometry arena is going in host memory.");
+            _hostResident = true;
+        }
+        GUST_CORE_ASSERT("Failed to create the geometry arena.", result != VK_SUCCESS);
+        return buffer;
+    }
+}
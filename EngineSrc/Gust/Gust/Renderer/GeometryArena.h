@@ -0,0 +1,86 @@
+#ifndef GEOMETRY_ARENA_HDR
+#define GEOMETRY_ARENA_HDR
+
+#include "PreComp.h"
+#include "FreeListAllocator.h"
+#include "MemoryBudget.h"
+
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+namespace Gust
+{
+    //Where a mesh lives in the arena, in vertices and indices rather than
+    //bytes so it goes straight into vkCmdDrawIndexed.
+    struct GeometryAllocation
+    {
+        uint32_t firstVertex = 0;
+        uint32_t vertexCount = 0;
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+
+        bool isValid() const { return indexCount > 0; }
+    };
+
+    struct GeometryStats
+    {
+        uint32_t meshes = 0;
+        uint64_t vertices = 0;
+        uint64_t vertexCapacity = 0;
+        uint64_t indices = 0;
+        uint64_t indexCapacity = 0;
+        uint64_t freeRanges = 0;
+        //Pushed into host memory because VRAM was over budget.
+        bool hostResident = false;
+    };
+
+    //One vertex and one index buffer shared by every mesh. Meshes are sub
+    //allocated out of them, so the buffers are bound once a frame and each
+    //draw only differs by its offsets. The buffers are dedicated allocations
+    //so the defragmenter leaves them alone.
+    class GeometryArena
+    {
+    public:
+        //More than one queue family makes the buffers concurrent so uploads
+        //can land next to meshes being drawn without ownership transfers.
+        //Geometry is non critical so the buffers go to host memory when the
+        //budget says VRAM is tight.
+        GeometryArena(VmaAllocator allocator, const MemoryBudget& budget, VkDeviceSize vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity, const std::vector<uint32_t>& queueFamilies);
+        ~GeometryArena();
+
+        GeometryArena(const GeometryArena&) = delete;
+        GeometryArena& operator=(const GeometryArena&) = delete;
+
+        //False when either buffer has no free range big enough.
+        bool allocate(uint32_t vertexCount, uint32_t indexCount, GeometryAllocation& allocation);
+        //Only once no frame in flight can still be drawing it.
+        void free(const GeometryAllocation& allocation);
+
+        void bind(VkCommandBuffer commandBuffer) const;
+
+        VkBuffer getVertexBuffer() const { return _vertexBuffer; }
+        VkBuffer getIndexBuffer() const { return _indexBuffer; }
+        VkDeviceSize getVertexStride() const { return _vertexStride; }
+        bool isConcurrent() const { return _concurrent; }
+        bool isHostResident() const { return _hostResident; }
+        GeometryStats getStats() const;
+    private:
+        VkBuffer createBuffer(const MemoryBudget& budget, VkDeviceSize size, VkBufferUsageFlags usage, const std::vector<uint32_t>& queueFamilies, VmaAllocation& allocation);
+    private:
+        VmaAllocator _allocator;
+        VkDeviceSize _vertexStride;
+        bool _concurrent;
+        bool _hostResident = false;
+
+        VkBuffer _vertexBuffer;
+        VmaAllocation _vertexAllocation;
+        VkBuffer _indexBuffer;
+        VmaAllocation _indexAllocation;
+
+        FreeListAllocator _vertices;
+        FreeListAllocator _indices;
+        uint32_t _meshes = 0;
+    };
+}
+
+#endif // !GEOMETRY_ARENA_HDR
@@ -0,0 +1,48 @@
+#ifndef GPU_MEMORY_STATS_HDR
+#define GPU_MEMORY_STATS_HDR
+
+#include "PreComp.h"
+
+namespace Gust
+{
+    //How close the fullest device local heap is to its budget.
+    enum class MemoryPressure
+    {
+        NORMAL,
+        HIGH,
+        CRITICAL
+    };
+
+    struct GpuMemoryHeap
+    {
+        uint64_t usage = 0;
+        uint64_t budget = 0;
+        bool deviceLocal = false;
+    };
+
+    //A snapshot of what the GPU allocator holds. Blocks are the actual
+    //vkAllocateMemory calls, allocations are the resources packed into them.
+    struct GpuMemoryStats
+    {
+        uint32_t blockCount = 0;
+        uint32_t allocationCount = 0;
+        uint32_t unusedRangeCount = 0;
+        uint64_t blockBytes = 0;
+        uint64_t allocationBytes = 0;
+        //How much of the free space inside blocks is unusable for one large
+        //allocation. 0 is one contiguous free range, near 1 is scattered.
+        float fragmentation = 0.f;
+        //Moved by the defragmentation pass this frame and since start up.
+        uint64_t defragmentedBytes = 0;
+        uint64_t totalDefragmentedBytes = 0;
+        //Budgets only track other processes with VK_EXT_memory_budget,
+        //otherwise they are an estimate from the heap sizes.
+        bool driverBudget = false;
+        MemoryPressure pressure = MemoryPressure::NORMAL;
+        //Given back by eviction callbacks since start up.
+        uint64_t evictedBytes = 0;
+        std::vector<GpuMemoryHeap> heaps;
+    };
+}
+
+#endif // !GPU_MEMORY_STATS_HDR
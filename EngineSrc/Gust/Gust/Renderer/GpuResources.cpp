@@ -0,0 +1,56 @@
+#include "PreComp.h"
+#include "GpuResources.h"
+#include "DeletionQueue.h"
+
+namespace Gust
+{
+    GpuResources::GpuResources(VkDevice device, VmaAllocator allocator, DeletionQueue& deletionQueue) :
+        _device(device), _allocator(allocator), _deletionQueue(deletionQueue)
+    {
+    }
+
+    GpuResources::~GpuResources()
+    {
+        for (const GpuPipeline& pipeline : _pipelines)
+        {
+            vkDestroyPipeline(_device, pipeline.pipeline, nullptr);
+        }
+
+        for (const GpuTexture& texture : _textures)
+        {
+            vkDestroyImageView(_device, texture.view, nullptr);
+            vmaDestroyImage(_allocator, texture.image, texture.allocation);
+        }
+
+        for (const GpuBuffer& buffer : _buffers)
+        {
+            vmaDestroyBuffer(_allocator, buffer.buffer, buffer.allocation);
+        }
+    }
+
+    void GpuResources::release(uint64_t frame, BufferHandle handle)
+    {
+        GpuBuffer buffer = _buffers.remove(handle);
+        _deletionQueue.retireBuffer(frame, buffer.buffer, buffer.allocation);
+    }
+
+    void GpuResources::release(uint64_t frame, TextureHandle handle)
+    {
+        GpuTexture texture = _textures.remove(handle);
+        _deletionQueue.retireImageView(frame, texture.view);
+        _deletionQueue.retireImage(frame, texture.image, texture.allocation);
+    }
+
+    void GpuResources::release(uint64_t frame, PipelineHandle handle)
+    {
+        GpuPipeline pipeline = _pipelines.remove(handle);
+        _deletionQueue.retirePipeline(frame, pipeline.pipeline);
+    }
+
+    void GpuResources::replace(uint64_t frame, PipelineHandle handle, VkPipeline pipeline)
+    {
+        GpuPipeline& existing = _pipelines.get(handle);
+        _deletionQueue.retirePipeline(frame, existing.pipeline);
+        existing.pipeline = pipeline;
+    }
+}
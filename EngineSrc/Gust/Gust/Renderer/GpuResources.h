@@ -0,0 +1,87 @@
+#ifndef GPU_RESOURCES_HDR
+#define GPU_RESOURCES_HDR
+
+#include "PreComp.h"
+#include "HandlePool.h"
+
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+namespace Gust
+{
+    class DeletionQueue;
+
+    struct GpuBuffer
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+    };
+
+    struct GpuTexture
+    {
+        VkImage image = VK_NULL_HANDLE;
+        VmaAllocation allocation = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent = {};
+        uint32_t mipLevels = 1;
+        //Its slot in the bindless set, what shaders find it by.
+        uint32_t bindlessIndex = UINT32_MAX;
+    };
+
+    struct GpuPipeline
+    {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        //Shared between pipelines and owned by whoever made it.
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+    };
+
+    //Owns the renderer's buffers, textures and pipelines behind handles, so
+    //they can be shared and passed around as 32 bit values. Releasing a
+    //handle frees it straight away while the Vulkan objects go through the
+    //deletion queue behind the frames that may still use them.
+    class GpuResources
+    {
+    public:
+        GpuResources(VkDevice device, VmaAllocator allocator, DeletionQueue& deletionQueue);
+        //Destroys whatever is left. Only once the device is idle.
+        ~GpuResources();
+
+        GpuResources(const GpuResources&) = delete;
+        GpuResources& operator=(const GpuResources&) = delete;
+
+        BufferHandle addBuffer(const GpuBuffer& buffer) { return _buffers.add(buffer); }
+        TextureHandle addTexture(const GpuTexture& texture) { return _textures.add(texture); }
+        PipelineHandle addPipeline(const GpuPipeline& pipeline) { return _pipelines.add(pipeline); }
+
+        GpuBuffer& get(BufferHandle handle) { return _buffers.get(handle); }
+        GpuTexture& get(TextureHandle handle) { return _textures.get(handle); }
+        GpuPipeline& get(PipelineHandle handle) { return _pipelines.get(handle); }
+        const GpuBuffer& get(BufferHandle handle) const { return _buffers.get(handle); }
+        const GpuTexture& get(TextureHandle handle) const { return _textures.get(handle); }
+        const GpuPipeline& get(PipelineHandle handle) const { return _pipelines.get(handle); }
+
+        bool isValid(BufferHandle handle) const { return _buffers.isValid(handle); }
+        bool isValid(TextureHandle handle) const { return _textures.isValid(handle); }
+        bool isValid(PipelineHandle handle) const { return _pipelines.isValid(handle); }
+
+        //Frame is the last frame that could have used the resource.
+        void release(uint64_t frame, BufferHandle handle);
+        void release(uint64_t frame, TextureHandle handle);
+        void release(uint64_t frame, PipelineHandle handle);
+        //Swaps the pipeline behind a handle, so anything holding the handle
+        //picks up the new one. The old one is retired after frame.
+        void replace(uint64_t frame, PipelineHandle handle, VkPipeline pipeline);
+    private:
+        VkDevice _device;
+        VmaAllocator _allocator;
+        DeletionQueue& _deletionQueue;
+
+        HandlePool<BufferHandle, GpuBuffer> _buffers;
+        HandlePool<TextureHandle, GpuTexture> _textures;
+        HandlePool<PipelineHandle, GpuPipeline> _pipelines;
+    };
+}
+
+#endif // !GPU_RESOURCES_HDR
@@ -0,0 +1,52 @@
+#ifndef HANDLE_HDR
+#define HANDLE_HDR
+
+#include "PreComp.h"
+
+namespace Gust
+{
+    //A 32 bit reference to a slot in a HandlePool. The low bits pick the
+    //slot, the high bits hold the slot's generation when the handle was
+    //made, so a handle to something since freed no longer matches. The tag
+    //only exists to stop one kind of handle being passed as another.
+    template<typename Tag>
+    class Handle
+    {
+    public:
+        static constexpr uint32_t INDEX_BITS = 20;
+        static constexpr uint32_t GENERATION_BITS = 32 - INDEX_BITS;
+        static constexpr uint32_t MAX_INDEX = (1u << INDEX_BITS) - 1;
+        static constexpr uint32_t MAX_GENERATION = (1u << GENERATION_BITS) - 1;
+
+        //Generations start at 1 so the default handle is never valid.
+        Handle() = default;
+        Handle(uint32_t index, uint32_t generation) : _value((generation << INDEX_BITS) | index) {}
+
+        static Handle fromValue(uint32_t value)
+        {
+            Handle handle;
+            handle._value = value;
+            return handle;
+        }
+
+        uint32_t getIndex() const { return _value & MAX_INDEX; }
+        uint32_t getGeneration() const { return _value >> INDEX_BITS; }
+        uint32_t getValue() const { return _value; }
+        bool isNull() const { return _value == 0; }
+
+        bool operator==(const Handle& other) const { return _value == other._value; }
+        bool operator!=(const Handle& other) const { return _value != other._value; }
+    private:
+        uint32_t _value = 0;
+    };
+
+    struct BufferTag;
+    struct TextureTag;
+    struct PipelineTag;
+
+    using BufferHandle = Handle<BufferTag>;
+    using TextureHandle = Handle<TextureTag>;
+    using PipelineHandle = Handle<PipelineTag>;
+}
+
+#endif // !HANDLE_HDR
@@ -0,0 +1,121 @@
+#ifndef HANDLE_POOL_HDR
+#define HANDLE_POOL_HDR
+
+#include "PreComp.h"
+#include "Handle.h"
+
+#include "Gust/Core/Core.h"
+
+namespace Gust
+{
+    //Owns values of one type behind generational handles. The values are
+    //kept packed in one array so walking all of them stays cache friendly,
+    //and a slot table maps each handle to where its value currently is.
+    //Removing swaps the last value into the hole, so lookups are always two
+    //array reads. Debug builds catch handles used after their slot was
+    //freed or reused.
+    template<typename HandleType, typename T>
+    class HandlePool
+    {
+    public:
+        HandleType add(T value)
+        {
+            uint32_t index;
+            if (_freeSlots.empty() == false)
+            {
+                index = _freeSlots.back();
+                _freeSlots.pop_back();
+            }
+            else
+            {
+                GUST_CORE_ASSERT("Handle pool is out of slots.", _slots.size() > HandleType::MAX_INDEX);
+                index = static_cast<uint32_t>(_slots.size());
+                _slots.push_back(Slot());
+            }
+
+            Slot& slot = _slots[index];
+            slot.dense = static_cast<uint32_t>(_values.size());
+            _values.push_back(std::move(value));
+            _valueSlots.push_back(index);
+
+            return HandleType(index, slot.generation);
+        }
+
+        //Hands the value back so the caller can destroy what it refers to.
+        T remove(HandleType handle)
+        {
+            check(handle);
+
+            Slot& slot = _slots[handle.getIndex()];
+            T value = std::move(_values[slot.dense]);
+
+            uint32_t last = static_cast<uint32_t>(_values.size() - 1);
+            if (slot.dense != last)
+            {
+                _values[slot.dense] = std::move(_values[last]);
+                _valueSlots[slot.dense] = _valueSlots[last];
+                _slots[_valueSlots[slot.dense]].dense = slot.dense;
+            }
+            _values.pop_back();
+            _valueSlots.pop_back();
+
+            //Skip 0 on wrap so no live handle ever equals the null one.
+            slot.generation = slot.generation == HandleType::MAX_GENERATION ? 1 : slot.generation + 1;
+            _freeSlots.push_back(handle.getIndex());
+
+            return value;
+        }
+
+        T& get(HandleType handle)
+        {
+            check(handle);
+            return _values[_slots[handle.getIndex()].dense];
+        }
+
+        const T& get(HandleType handle) const
+        {
+            check(handle);
+            return _values[_slots[handle.getIndex()].dense];
+        }
+
+        bool isValid(HandleType handle) const
+        {
+            uint32_t index = handle.getIndex();
+            return handle.isNull() == false && index < _slots.size() && _slots[index].generation == handle.getGeneration();
+        }
+
+        size_t size() const { return _values.size(); }
+        bool empty() const { return _values.empty(); }
+
+        //In no particular order, and only until the next add or remove.
+        typename std::vector<T>::iterator begin() { return _values.begin(); }
+        typename std::vector<T>::iterator end() { return _values.end(); }
+        typename std::vector<T>::const_iterator begin() const { return _values.begin(); }
+        typename std::vector<T>::const_iterator end() const { return _values.end(); }
+    private:
+        struct Slot
+        {
+            uint32_t dense = 0;
+            uint32_t generation = 1;
+        };
+
+        void check(HandleType handle) const
+        {
+#ifdef GUST_DEBUG
+            if (isValid(handle) == false)
+            {
+                GUST_CRITICAL("Stale or null handle used: slot {0}, generation {1}.", handle.getIndex(), handle.getGeneration());
+                __debugbreak();
+            }
+#endif
+        }
+    private:
+        std::vector<Slot> _slots;
+        std::vector<uint32_t> _freeSlots;
+        std::vector<T> _values;
+        //Which slot each packed value belongs to, for the swap on remove.
+        std::vector<uint32_t> _valueSlots;
+    };
+}
+
+#endif // !HANDLE_POOL_HDR
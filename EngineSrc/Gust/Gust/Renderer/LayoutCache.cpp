@@ -0,0 +1,190 @@
+#include "PreComp.h"
+#include "LayoutCache.h"
+#include "DescriptorAllocator.h"
+
+#include "Gust/Core/Hash.h"
+
+namespace
+{
+    //Immutable samplers aren't compared, we don't use them.
+    bool sameBindings(const std::vector<VkDescriptorSetLayoutBinding>& a, const std::vector<VkDescriptorSetLayoutBinding>& b)
+    {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const VkDescriptorSetLayoutBinding& x, const VkDescriptorSetLayoutBinding& y)
+        {
+            return x.binding == y.binding && x.descriptorType == y.descriptorType &&
+                   x.descriptorCount == y.descriptorCount && x.stageFlags == y.stageFlags;
+        });
+    }
+
+    bool samePushConstants(const std::vector<VkPushConstantRange>& a, const std::vector<VkPushConstantRange>& b)
+    {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const VkPushConstantRange& x, const VkPushConstantRange& y)
+        {
+            return x.stageFlags == y.stageFlags && x.offset == y.offset && x.size == y.size;
+        });
+    }
+}
+
+namespace Gust
+{
+    LayoutCache::LayoutCache(VkDevice device) :
+        _device(device)
+    {
+    }
+
+    LayoutCache::~LayoutCache()
+    {
+        for (auto& [key, entries] : _pipelineLayouts)
+        {
+            for (auto& entry : entries)
+            {
+                vkDestroyPipelineLayout(_device, entry.layout, nullptr);
+            }
+        }
+
+        for (auto& [key, entries] : _setLayouts)
+        {
+            for (auto& entry : entries)
+            {
+                vkDestroyDescriptorUpdateTemplate(_device, entry.updateTemplate, nullptr);
+                vkDestroyDescriptorSetLayout(_device, entry.layout, nullptr);
+            }
+        }
+    }
+
+    VkDescriptorSetLayout LayoutCache::getSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+    {
+        SetLayoutEntry* entry = findSetLayout(bindings);
+        return entry != nullptr ? entry->layout : VK_NULL_HANDLE;
+    }
+
+    VkPipelineLayout LayoutCache::getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstants)
+    {
+        //Set layouts come from this cache, so the handle is the signature.
+        uint64_t key = HASH_SEED;
+        for (VkDescriptorSetLayout setLayout : setLayouts)
+        {
+            key = hashValue(setLayout, key);
+        }
+        for (const auto& range : pushConstants)
+        {
+            key = hashValue(range.stageFlags, key);
+            key = hashValue(range.offset, key);
+            key = hashValue(range.size, key);
+        }
+
+        auto& entries = _pipelineLayouts[key];
+        for (const auto& entry : entries)
+        {
+            if (entry.setLayouts == setLayouts && samePushConstants(entry.pushConstants, pushConstants))
+            {
+                _stats.hits++;
+                return entry.layout;
+            }
+        }
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstants.size());
+        pipelineLayoutInfo.pPushConstantRanges = pushConstants.data();
+
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS)
+        {
+            GUST_ERROR("Failed to create a pipeline layout with {0} sets.", setLayouts.size());
+            return VK_NULL_HANDLE;
+        }
+
+        entries.push_back({ setLayouts, pushConstants, layout });
+        _stats.pipelineLayouts++;
+        return layout;
+    }
+
+    VkDescriptorUpdateTemplate LayoutCache::getUpdateTemplate(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+    {
+        SetLayoutEntry* entry = findSetLayout(bindings);
+        if (entry == nullptr || entry->updateTemplate != VK_NULL_HANDLE)
+        {
+            return entry != nullptr ? entry->updateTemplate : VK_NULL_HANDLE;
+        }
+
+        //Packed back to back, so a binding's data starts after every
+        //descriptor of the bindings before it.
+        std::vector<VkDescriptorUpdateTemplateEntry> templateEntries;
+        size_t offset = 0;
+        for (const auto& binding : bindings)
+        {
+            if (binding.descriptorCount == 0)
+            {
+                continue;
+            }
+
+            VkDescriptorUpdateTemplateEntry templateEntry{};
+            templateEntry.dstBinding = binding.binding;
+            templateEntry.dstArrayElement = 0;
+            templateEntry.descriptorCount = binding.descriptorCount;
+            templateEntry.descriptorType = binding.descriptorType;
+            templateEntry.offset = offset;
+            templateEntry.stride = sizeof(DescriptorInfo);
+            templateEntries.push_back(templateEntry);
+            offset += binding.descriptorCount * sizeof(DescriptorInfo);
+        }
+
+        VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+        templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+        templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(templateEntries.size());
+        templateInfo.pDescriptorUpdateEntries = templateEntries.data();
+        templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+        templateInfo.descriptorSetLayout = entry->layout;
+
+        if (vkCreateDescriptorUpdateTemplate(_device, &templateInfo, nullptr, &entry->updateTemplate) != VK_SUCCESS)
+        {
+            GUST_ERROR("Failed to create a descriptor update template with {0} bindings.", bindings.size());
+            entry->updateTemplate = VK_NULL_HANDLE;
+            return VK_NULL_HANDLE;
+        }
+
+        _stats.updateTemplates++;
+        return entry->updateTemplate;
+    }
+
+    LayoutCache::SetLayoutEntry* LayoutCache::findSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+    {
+        uint64_t key = HASH_SEED;
+        for (const auto& binding : bindings)
+        {
+            key = hashValue(binding.binding, key);
+            key = hashValue(binding.descriptorType, key);
+            key = hashValue(binding.descriptorCount, key);
+            key = hashValue(binding.stageFlags, key);
+        }
+
+        auto& entries = _setLayouts[key];
+        for (auto& entry : entries)
+        {
+            if (sameBindings(entry.bindings, bindings))
+            {
+                _stats.hits++;
+                return &entry;
+            }
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+        if (vkCreateDescriptorSetLayout(_device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+        {
+            GUST_ERROR("Failed to create a descriptor set layout with {0} bindings.", bindings.size());
+            return nullptr;
+        }
+
+        entries.push_back({ bindings, layout });
+        _stats.setLayouts++;
+        return &entries.back();
+    }
+}
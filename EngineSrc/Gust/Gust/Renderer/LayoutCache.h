@@ -0,0 +1,70 @@
+#ifndef LAYOUT_CACHE_HDR
+#define LAYOUT_CACHE_HDR
+
+#include "PreComp.h"
+
+#include <vulkan/vulkan.h>
+
+namespace Gust
+{
+    struct LayoutCacheStats
+    {
+        uint32_t setLayouts = 0;
+        uint32_t pipelineLayouts = 0;
+        uint32_t updateTemplates = 0;
+        //Requests for a layout that already existed.
+        uint64_t hits = 0;
+    };
+
+    //Hands out one descriptor set layout or pipeline layout per distinct
+    //signature so pipelines whose shaders agree share them, along with the
+    //update template for each set layout. Owns everything it makes, they
+    //live until the cache goes. Main thread only.
+    class LayoutCache
+    {
+    public:
+        LayoutCache(VkDevice device);
+        ~LayoutCache();
+
+        LayoutCache(const LayoutCache&) = delete;
+        LayoutCache& operator=(const LayoutCache&) = delete;
+
+        //Bindings are compared in order, so keep them sorted by binding.
+        VkDescriptorSetLayout getSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+        VkPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstants);
+        //Writes a whole set of this layout from one DescriptorInfo per
+        //descriptor, in binding order. Runtime sized arrays are left out,
+        //they're written on their own.
+        VkDescriptorUpdateTemplate getUpdateTemplate(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+        const LayoutCacheStats& getStats() const { return _stats; }
+    private:
+        struct SetLayoutEntry
+        {
+            std::vector<VkDescriptorSetLayoutBinding> bindings;
+            VkDescriptorSetLayout layout;
+            //Made the first time it's asked for.
+            VkDescriptorUpdateTemplate updateTemplate = VK_NULL_HANDLE;
+        };
+
+        struct PipelineLayoutEntry
+        {
+            std::vector<VkDescriptorSetLayout> setLayouts;
+            std::vector<VkPushConstantRange> pushConstants;
+            VkPipelineLayout layout;
+        };
+
+        SetLayoutEntry* findSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+    private:
+        VkDevice _device;
+
+        //Keyed by hash with every entry that landed on it, so a collision
+        //just costs a compare.
+        std::unordered_map<uint64_t, std::vector<SetLayoutEntry>> _setLayouts;
+        std::unordered_map<uint64_t, std::vector<PipelineLayoutEntry>> _pipelineLayouts;
+
+        LayoutCacheStats _stats;
+    };
+}
+
+#endif // !LAYOUT_CACHE_HDR
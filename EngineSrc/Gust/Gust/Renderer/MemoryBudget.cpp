@@ -0,0 +1,155 @@
+#include "PreComp.h"
+#include "MemoryBudget.h"
+
+namespace
+{
+    //Fractions of the VRAM budget. Eviction aims for the release watermark
+    //so pressure doesn't flicker on and off around the high one.
+    const float RELEASE_WATERMARK = 0.8f;
+    const float HIGH_WATERMARK = 0.85f;
+    const float CRITICAL_WATERMARK = 0.95f;
+
+    const char* pressureName(Gust::MemoryPressure pressure)
+    {
+        switch (pressure)
+        {
+        case Gust::MemoryPressure::HIGH:
+            return "high";
+        case Gust::MemoryPressure::CRITICAL:
+            return "critical";
+        case Gust::MemoryPressure::NORMAL:
+        default:
+            return "normal";
+        }
+    }
+}
+
+namespace Gust
+{
+    MemoryBudget::MemoryBudget(VmaAllocator allocator, bool driverBudget, uint32_t framesInFlight) :
+        _allocator(allocator), _driverBudget(driverBudget), _framesInFlight(framesInFlight)
+    {
+        vmaGetMemoryProperties(_allocator, &_memoryProperties);
+
+        VkDeviceSize largest = 0;
+        for (uint32_t i = 0; i < _memoryProperties->memoryHeapCount; i++)
+        {
+            const VkMemoryHeap& heap = _memoryProperties->memoryHeaps[i];
+            if ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0 && heap.size > largest)
+            {
+                largest = heap.size;
+                _vramHeap = i;
+            }
+        }
+
+        _budgets.resize(_memoryProperties->memoryHeapCount);
+        vmaGetHeapBudgets(_allocator, _budgets.data());
+    }
+
+    void MemoryBudget::update(uint64_t frameNumber)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        //VMA only re-queries the driver's budget when the frame index moves.
+        vmaSetCurrentFrameIndex(_allocator, static_cast<uint32_t>(frameNumber));
+        vmaGetHeapBudgets(_allocator, _budgets.data());
+
+        const VmaBudget& vram = _budgets[_vramHeap];
+        float usage = vram.budget > 0 ? static_cast<float>(vram.usage) / static_cast<float>(vram.budget) : 0.f;
+
+        MemoryPressure pressure = pressureFor(usage);
+        if (pressure != _pressure)
+        {
+            GUST_WARN("GPU memory pressure is now {0}, VRAM {1:.2f} MB used of a {2:.2f} MB budget.", pressureName(pressure),
+                      vram.usage / (1024.0 * 1024.0), vram.budget / (1024.0 * 1024.0));
+            _pressure = pressure;
+        }
+
+        if (_pressure == MemoryPressure::NORMAL || frameNumber < _nextEvictionFrame)
+        {
+            return;
+        }
+
+        uint64_t target = static_cast<uint64_t>(vram.budget * RELEASE_WATERMARK);
+        uint64_t requested = vram.usage > target ? vram.usage - target : 0;
+        uint64_t freed = 0;
+        for (size_t i = 0; i < _evictions.size() && freed < requested; i++)
+        {
+            freed += _evictions[i].evict(requested - freed);
+        }
+        _evictedBytes += freed;
+
+        //Give what was just released time to pass through the deletion queue
+        //before asking again.
+        _nextEvictionFrame = frameNumber + _framesInFlight + 1;
+
+        if (freed < requested && _pressure == MemoryPressure::CRITICAL)
+        {
+            GUST_WARN("Could only evict {0:.2f} MB of the {1:.2f} MB needed, VRAM may spill into system memory.",
+                      freed / (1024.0 * 1024.0), requested / (1024.0 * 1024.0));
+        }
+    }
+
+    uint32_t MemoryBudget::addEvictionCallback(EvictFunc evict)
+    {
+        uint32_t id = _nextEvictionId++;
+        _evictions.push_back({ id, std::move(evict) });
+        return id;
+    }
+
+    void MemoryBudget::removeEvictionCallback(uint32_t id)
+    {
+        _evictions.erase(std::remove_if(_evictions.begin(), _evictions.end(), [id](const Eviction& eviction) { return eviction.id == id; }), _evictions.end());
+    }
+
+    bool MemoryBudget::fitsDeviceLocal(VkDeviceSize size) const
+    {
+        const VmaBudget& vram = _budgets[_vramHeap];
+        return vram.usage + size <= static_cast<VkDeviceSize>(vram.budget * HIGH_WATERMARK);
+    }
+
+    void MemoryBudget::prepareNonCritical(VmaAllocationCreateInfo& createInfo, VkDeviceSize size) const
+    {
+        if (_pressure == MemoryPressure::NORMAL && fitsDeviceLocal(size))
+        {
+            //Still fails rather than going over if something else grabbed
+            //the memory since the last update.
+            createInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+            createInfo.flags |= VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+        }
+        else
+        {
+            createInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+            createInfo.flags &= ~VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+        }
+    }
+
+    void MemoryBudget::logHeaps() const
+    {
+        GUST_INFO("GPU memory budget from {0}:", _driverBudget ? "VK_EXT_memory_budget" : "heap size estimates");
+        for (uint32_t i = 0; i < _memoryProperties->memoryHeapCount; i++)
+        {
+            bool deviceLocal = (_memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+            GUST_INFO("  Heap {0} ({1}): {2:.2f} MB used of {3:.2f} MB.", i, deviceLocal ? "device local" : "host",
+                      _budgets[i].usage / (1024.0 * 1024.0), _budgets[i].budget / (1024.0 * 1024.0));
+        }
+    }
+
+    MemoryPressure MemoryBudget::pressureFor(float usage) const
+    {
+        if (usage >= CRITICAL_WATERMARK)
+        {
+            return MemoryPressure::CRITICAL;
+        }
+        if (usage >= HIGH_WATERMARK)
+        {
+            return MemoryPressure::HIGH;
+        }
+        //Hold on to high until eviction has got us under the release mark.
+        if (_pressure != MemoryPressure::NORMAL && usage >= RELEASE_WATERMARK)
+        {
+            return MemoryPressure::HIGH;
+        }
+        return MemoryPressure::NORMAL;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef MEMORY_BUDGET_HDR
+#define MEMORY_BUDGET_HDR
+
+#include "PreComp.h"
+#include "GpuMemoryStats.h"
+
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+namespace Gust
+{
+    //Watches VRAM against the budget the driver gives us and reacts before
+    //allocations start spilling into system memory. Past the high watermark
+    //the eviction callbacks are asked to give memory back and non critical
+    //allocations are steered into host memory.
+    class MemoryBudget
+    {
+    public:
+        //Asked to free about this many bytes, returns how many it expects to
+        //free. Memory released through the deletion queue only shows up in
+        //the budget a few frames later.
+        using EvictFunc = std::function<uint64_t(uint64_t bytes)>;
+
+        MemoryBudget(VmaAllocator allocator, bool driverBudget, uint32_t framesInFlight);
+
+        MemoryBudget(const MemoryBudget&) = delete;
+        MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+        //Call once a frame after the frame's fence has signalled.
+        void update(uint64_t frameNumber);
+
+        uint32_t addEvictionCallback(EvictFunc evict);
+        void removeEvictionCallback(uint32_t id);
+
+        //Whether size more bytes still leaves VRAM under the high watermark.
+        bool fitsDeviceLocal(VkDeviceSize size) const;
+        //For data that can be read over the bus, like geometry. It stays in
+        //VRAM while there is room and goes to host memory otherwise, rather
+        //than pushing something critical out.
+        void prepareNonCritical(VmaAllocationCreateInfo& createInfo, VkDeviceSize size) const;
+
+        MemoryPressure getPressure() const { return _pressure; }
+        bool isDriverBudget() const { return _driverBudget; }
+        uint64_t getEvictedBytes() const { return _evictedBytes; }
+        void logHeaps() const;
+    private:
+        struct Eviction
+        {
+            uint32_t id;
+            EvictFunc evict;
+        };
+
+        MemoryPressure pressureFor(float usage) const;
+    private:
+        VmaAllocator _allocator;
+        bool _driverBudget;
+        uint32_t _framesInFlight;
+        const VkPhysicalDeviceMemoryProperties* _memoryProperties = nullptr;
+        //The largest device local heap. Small ones like the resizable BAR
+        //window fill up with mapped buffers and aren't a sign of pressure.
+        uint32_t _vramHeap = 0;
+
+        std::vector<VmaBudget> _budgets;
+        MemoryPressure _pressure = MemoryPressure::NORMAL;
+
+        std::vector<Eviction> _evictions;
+        uint32_t _nextEvictionId = 1;
+        uint64_t _nextEvictionFrame = 0;
+        uint64_t _evictedBytes = 0;
+    };
+}
+
+#endif // !MEMORY_BUDGET_HDR
@@ -0,0 +1,167 @@
+#include "PreComp.h"
+#include "PipelineCache.h"
+
+#include "Gust/Core/Core.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace Gust
+{
+    PipelineCache::PipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& filePath) :
+        _device(device), _filePath(filePath), _ownerThread(std::this_thread::get_id())
+    {
+        GUST_PROFILE_FUNCTION();
+
+        vkGetPhysicalDeviceProperties(physicalDevice, &_properties);
+
+        std::vector<uint8_t> data;
+        std::ifstream file(_filePath, std::ios::ate | std::ios::binary);
+        if (file.is_open())
+        {
+            data.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file.good())
+            {
+                data.clear();
+            }
+        }
+
+        if (data.empty() == false && isCompatible(data) == false)
+        {
+            GUST_INFO("Pipeline cache {0} was written by another GPU or driver, starting cold.", _filePath);
+            data.clear();
+        }
+
+        _cache = create(data);
+        _stats.warm = data.empty() == false;
+        _stats.loadedBytes = data.size();
+    }
+
+    PipelineCache::~PipelineCache()
+    {
+        for (const auto& [thread, cache] : _threadCaches)
+        {
+            vkDestroyPipelineCache(_device, cache, nullptr);
+        }
+        vkDestroyPipelineCache(_device, _cache, nullptr);
+    }
+
+    VkPipelineCache PipelineCache::get()
+    {
+        std::thread::id thread = std::this_thread::get_id();
+        if (thread == _ownerThread)
+        {
+            return _cache;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        VkPipelineCache& cache = _threadCaches[thread];
+        if (cache == VK_NULL_HANDLE)
+        {
+            cache = create({});
+        }
+        return cache;
+    }
+
+    void PipelineCache::recordCreation(float milliseconds)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.pipelines++;
+        _stats.creationMilliseconds += milliseconds;
+    }
+
+    bool PipelineCache::save()
+    {
+        GUST_PROFILE_FUNCTION();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::vector<VkPipelineCache> sources;
+            for (const auto& [thread, cache] : _threadCaches)
+            {
+                sources.push_back(cache);
+            }
+
+            if (sources.empty() == false)
+            {
+                VkResult result = vkMergePipelineCaches(_device, _cache, static_cast<uint32_t>(sources.size()), sources.data());
+                GUST_CORE_ASSERT("Failed to merge the pipeline caches.", result != VK_SUCCESS);
+            }
+        }
+
+        size_t size = 0;
+        vkGetPipelineCacheData(_device, _cache, &size, nullptr);
+        std::vector<uint8_t> data(size);
+        if (vkGetPipelineCacheData(_device, _cache, &size, data.data()) != VK_SUCCESS)
+        {
+            GUST_ERROR("Failed to read back the pipeline cache.");
+            return false;
+        }
+        data.resize(size);
+
+        //Written to the side then renamed so a crash mid write never leaves
+        //a truncated cache for the next run.
+        std::string temporaryPath = _filePath + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file.good())
+            {
+                GUST_ERROR("Failed to write pipeline cache {0}", _filePath);
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, _filePath, error);
+        if (error)
+        {
+            GUST_ERROR("Failed to replace pipeline cache {0}: {1}", _filePath, error.message());
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+
+        GUST_INFO("Saved {0:.2f} KB of pipeline cache to {1}", data.size() / 1024.0, _filePath);
+        return true;
+    }
+
+    PipelineCacheStats PipelineCache::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    //Drivers reject data that isn't theirs, but some only after reading it
+    //so it's checked here first.
+    bool PipelineCache::isCompatible(const std::vector<uint8_t>& data) const
+    {
+        VkPipelineCacheHeaderVersionOne header{};
+        if (data.size() < sizeof(header))
+        {
+            return false;
+        }
+        memcpy(&header, data.data(), sizeof(header));
+
+        return header.headerSize >= sizeof(header) &&
+               header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+               header.vendorID == _properties.vendorID &&
+               header.deviceID == _properties.deviceID &&
+               memcmp(header.pipelineCacheUUID, _properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    VkPipelineCache PipelineCache::create(const std::vector<uint8_t>& data) const
+    {
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = data.size();
+        createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        VkPipelineCache cache;
+        VkResult result = vkCreatePipelineCache(_device, &createInfo, nullptr, &cache);
+        GUST_CORE_ASSERT("Failed to create a pipeline cache.", result != VK_SUCCESS);
+        return cache;
+    }
+}
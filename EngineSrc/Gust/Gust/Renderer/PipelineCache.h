@@ -0,0 +1,62 @@
+#ifndef PIPELINE_CACHE_HDR
+#define PIPELINE_CACHE_HDR
+
+#include "PreComp.h"
+
+#include <vulkan/vulkan.h>
+#include <mutex>
+#include <thread>
+
+namespace Gust
+{
+    struct PipelineCacheStats
+    {
+        //Started from a file this device had written.
+        bool warm = false;
+        size_t loadedBytes = 0;
+        uint32_t pipelines = 0;
+        float creationMilliseconds = 0.f;
+    };
+
+    //A VkPipelineCache kept on disk between runs so pipelines compiled once
+    //are only looked up afterwards. The file is only trusted when its header
+    //matches this GPU and driver. Each thread compiling pipelines gets a
+    //cache of its own so they never wait on each other, and they are merged
+    //back into one when saving.
+    class PipelineCache
+    {
+    public:
+        PipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, const std::string& filePath);
+        ~PipelineCache();
+
+        PipelineCache(const PipelineCache&) = delete;
+        PipelineCache& operator=(const PipelineCache&) = delete;
+
+        //The cache for the calling thread.
+        VkPipelineCache get();
+        //Time spent in vkCreate*Pipelines, for comparing cold and warm runs.
+        void recordCreation(float milliseconds);
+
+        //Merges every thread's cache and writes the result to the side before
+        //renaming it over the old file. No thread may be compiling.
+        bool save();
+
+        PipelineCacheStats getStats() const;
+    private:
+        bool isCompatible(const std::vector<uint8_t>& data) const;
+        VkPipelineCache create(const std::vector<uint8_t>& data) const;
+    private:
+        VkDevice _device;
+        VkPhysicalDeviceProperties _properties;
+        std::string _filePath;
+
+        VkPipelineCache _cache = VK_NULL_HANDLE;
+        std::thread::id _ownerThread;
+
+        mutable std::mutex _mutex;
+        std::unordered_map<std::thread::id, VkPipelineCache> _threadCaches;
+        PipelineCacheStats _stats;
+    };
+}
+
+#endif // !PIPELINE_CACHE_HDR
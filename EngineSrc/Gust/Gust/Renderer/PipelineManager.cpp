@@ -0,0 +1,867 @@
+#include "PreComp.h"
+#include "PipelineManager.h"
+#include "GpuResources.h"
+#include "PipelineCache.h"
+
+#include "Gust/Core/Hash.h"
+#include "Gust/Core/ThreadPool.h"
+
+#include <chrono>
+
+namespace
+{
+    //The shader stages of one pipeline or library, with the modules and
+    //specialisation data they point at. Destroys the modules with it, they
+    //aren't needed once the pipeline is created.
+    class ShaderStages
+    {
+    public:
+        ShaderStages(VkDevice device) :
+            _device(device)
+        {
+        }
+
+        ~ShaderStages()
+        {
+            for (uint32_t i = 0; i < _count; i++)
+            {
+                vkDestroyShaderModule(_device, _stages[i].module, nullptr);
+            }
+        }
+
+        ShaderStages(const ShaderStages&) = delete;
+        ShaderStages& operator=(const ShaderStages&) = delete;
+
+        bool add(Gust::ShaderVariants& variants, const std::string& filePath, Gust::VariantKey key, VkShaderStageFlagBits stage)
+        {
+            Gust::ShaderVariant& variant = _variants[_count];
+            if (variants.load(filePath, key, variant) == false)
+            {
+                GUST_ERROR("Failed to read shader {0}", filePath);
+                return false;
+            }
+
+            VkShaderModuleCreateInfo createInfo{};
+            createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            createInfo.codeSize = variant.spirv->size() * sizeof(uint32_t);
+            createInfo.pCode = variant.spirv->data();
+
+            VkShaderModule shaderModule;
+            if (vkCreateShaderModule(_device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+            {
+                GUST_ERROR("Failed to create a shader module from {0}", filePath);
+                return false;
+            }
+
+            VkPipelineShaderStageCreateInfo& stageInfo = _stages[_count];
+            stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stageInfo.stage = stage;
+            stageInfo.module = shaderModule;
+            stageInfo.pName = "main";
+
+            if (variant.specialisationEntries.empty() == false)
+            {
+                VkSpecializationInfo& specialisation = _specialisations[_count];
+                specialisation.mapEntryCount = static_cast<uint32_t>(variant.specialisationEntries.size());
+                specialisation.pMapEntries = variant.specialisationEntries.data();
+                specialisation.dataSize = variant.specialisationData.size() * sizeof(VkBool32);
+                specialisation.pData = variant.specialisationData.data();
+                stageInfo.pSpecializationInfo = &specialisation;
+            }
+
+            _count++;
+            return true;
+        }
+
+        uint32_t count() const { return _count; }
+        const VkPipelineShaderStageCreateInfo* data() const { return _stages.data(); }
+    private:
+        VkDevice _device;
+        std::array<VkPipelineShaderStageCreateInfo, 2> _stages{};
+        std::array<Gust::ShaderVariant, 2> _variants;
+        std::array<VkSpecializationInfo, 2> _specialisations{};
+        uint32_t _count = 0;
+    };
+
+    //All the fixed function state for a description. Libraries only point
+    //at the parts that belong to them.
+    struct FixedFunctionState
+    {
+        VkVertexInputBindingDescription bindingDescription{};
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+        VkPipelineViewportStateCreateInfo viewportState{};
+        VkPipelineRasterizationStateCreateInfo rasterizer{};
+        VkPipelineMultisampleStateCreateInfo multisampling{};
+        VkPipelineDepthStencilStateCreateInfo depthStencil{};
+        VkPipelineColorBlendAttachmentState colourBlendAttachment{};
+        VkPipelineColorBlendStateCreateInfo colourBlending{};
+        std::array<VkDynamicState, 2> dynamicStates{};
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+
+        FixedFunctionState(const Gust::PipelineDescription& description)
+        {
+            bindingDescription.binding = 0;
+            bindingDescription.stride = description.vertexStride;
+            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+            vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+            vertexInputInfo.vertexBindingDescriptionCount = description.vertexStride > 0 ? 1 : 0;
+            vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+            vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.vertexAttributes.size());
+            vertexInputInfo.pVertexAttributeDescriptions = description.vertexAttributes.data();
+
+            inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+            inputAssembly.topology = description.topology;
+            inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+            viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+            viewportState.viewportCount = 1;
+            viewportState.scissorCount = 1;
+
+            rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+            rasterizer.depthClampEnable = VK_FALSE;
+            rasterizer.rasterizerDiscardEnable = VK_FALSE;
+            rasterizer.polygonMode = description.polygonMode;
+            rasterizer.lineWidth = 1.f;
+            rasterizer.cullMode = description.cullMode;
+            rasterizer.frontFace = description.frontFace;
+            rasterizer.depthBiasEnable = VK_FALSE;
+
+            multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+            multisampling.sampleShadingEnable = VK_FALSE;
+            multisampling.rasterizationSamples = description.samples;
+
+            depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+            depthStencil.depthTestEnable = description.depthTest ? VK_TRUE : VK_FALSE;
+            depthStencil.depthWriteEnable = description.depthWrite ? VK_TRUE : VK_FALSE;
+            depthStencil.depthCompareOp = description.depthCompare;
+            depthStencil.depthBoundsTestEnable = VK_FALSE;
+            depthStencil.stencilTestEnable = VK_FALSE;
+
+            colourBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+            colourBlendAttachment.blendEnable = description.blend ? VK_TRUE : VK_FALSE;
+            colourBlendAttachment.srcColorBlendFactor = description.sourceBlend;
+            colourBlendAttachment.dstColorBlendFactor = description.destinationBlend;
+            colourBlendAttachment.colorBlendOp = description.blendOp;
+            colourBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            colourBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            colourBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+            colourBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+            colourBlending.logicOpEnable = VK_FALSE;
+            colourBlending.logicOp = VK_LOGIC_OP_COPY;
+            colourBlending.attachmentCount = 1;
+            colourBlending.pAttachments = &colourBlendAttachment;
+
+            dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+            dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+            dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+            dynamicState.pDynamicStates = dynamicStates.data();
+        }
+
+        FixedFunctionState(const FixedFunctionState&) = delete;
+        FixedFunctionState& operator=(const FixedFunctionState&) = delete;
+    };
+
+    VkPipeline createPipeline(VkDevice device, VkPipelineCache cache, const VkGraphicsPipelineCreateInfo& pipelineInfo, float& milliseconds)
+    {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        auto startTime = std::chrono::high_resolution_clock::now();
+        if (vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+        {
+            pipeline = VK_NULL_HANDLE;
+        }
+        milliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+        return pipeline;
+    }
+}
+
+namespace Gust
+{
+    //Field by field rather than over the whole struct so padding and the
+    //strings' heap pointers never end up in the key.
+    uint64_t PipelineDescription::hash() const
+    {
+        uint64_t hash = hashString(vertexShader);
+        hash = hashString(fragmentShader, hash);
+        hash = hashValue(variant, hash);
+
+        hash = hashValue(vertexStride, hash);
+        for (const auto& attribute : vertexAttributes)
+        {
+            hash = hashValue(attribute.location, hash);
+            hash = hashValue(attribute.binding, hash);
+            hash = hashValue(attribute.format, hash);
+            hash = hashValue(attribute.offset, hash);
+        }
+        hash = hashValue(topology, hash);
+
+        hash = hashValue(polygonMode, hash);
+        hash = hashValue(cullMode, hash);
+        hash = hashValue(frontFace, hash);
+
+        hash = hashValue(depthTest, hash);
+        hash = hashValue(depthWrite, hash);
+        hash = hashValue(depthCompare, hash);
+
+        hash = hashValue(blend, hash);
+        hash = hashValue(sourceBlend, hash);
+        hash = hashValue(destinationBlend, hash);
+        hash = hashValue(blendOp, hash);
+
+        hash = hashValue(colourFormat, hash);
+        hash = hashValue(depthFormat, hash);
+        hash = hashValue(samples, hash);
+        hash = hashValue(renderPass, hash);
+        hash = hashValue(subpass, hash);
+        hash = hashValue(layout, hash);
+        return hash;
+    }
+
+    bool PipelineDescription::operator==(const PipelineDescription& other) const
+    {
+        if (vertexAttributes.size() != other.vertexAttributes.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < vertexAttributes.size(); i++)
+        {
+            const auto& a = vertexAttributes[i];
+            const auto& b = other.vertexAttributes[i];
+            if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset)
+            {
+                return false;
+            }
+        }
+
+        return vertexShader == other.vertexShader && fragmentShader == other.fragmentShader && variant == other.variant &&
+               vertexStride == other.vertexStride && topology == other.topology &&
+               polygonMode == other.polygonMode && cullMode == other.cullMode && frontFace == other.frontFace &&
+               depthTest == other.depthTest && depthWrite == other.depthWrite && depthCompare == other.depthCompare &&
+               blend == other.blend && sourceBlend == other.sourceBlend && destinationBlend == other.destinationBlend && blendOp == other.blendOp &&
+               colourFormat == other.colourFormat && depthFormat == other.depthFormat && samples == other.samples &&
+               renderPass == other.renderPass && subpass == other.subpass && layout == other.layout;
+    }
+
+    PipelineManager::PipelineManager(VkDevice device, GpuResources& resources, PipelineCache& cache, ShaderVariants& variants, bool graphicsPipelineLibrary) :
+        _device(device), _resources(resources), _cache(cache), _variants(variants), _graphicsPipelineLibrary(graphicsPipelineLibrary)
+    {
+    }
+
+    PipelineManager::~PipelineManager()
+    {
+        std::unique_lock<std::mutex> lock(_completedMutex);
+        _idle.wait(lock, [this]() { return _compilesInFlight == 0; });
+
+        //Finished but never picked up, so nothing has drawn with them.
+        for (const Compiled& compiled : _completed)
+        {
+            vkDestroyPipeline(_device, compiled.pipeline, nullptr);
+        }
+
+        //Linked pipelines don't need their libraries once they're created.
+        for (auto& [key, library] : _libraries)
+        {
+            vkDestroyPipeline(_device, library.pipeline, nullptr);
+        }
+    }
+
+    PipelineHandle PipelineManager::getOrCreate(const PipelineDescription& requested)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        PipelineDescription description = normalise(requested);
+        uint64_t key = description.hash();
+        auto found = _entries.find(key);
+        if (found != _entries.end())
+        {
+            Entry* entry = find(key, description);
+            if (entry == nullptr)
+            {
+                return PipelineHandle();
+            }
+
+            //Already on a worker, rather than build it twice wait for it.
+            while (entry->state == State::COMPILING)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(_completedMutex);
+                    _idle.wait(lock, [this]() { return _completed.empty() == false || _compilesInFlight == 0; });
+                }
+                update(_frame);
+            }
+
+            std::lock_guard<std::mutex> lock(_statsMutex);
+            _stats.hits++;
+            return entry->handle;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_statsMutex);
+            _stats.misses++;
+        }
+        Entry& entry = _entries[key];
+        entry.description = description;
+        //Nothing is waiting on it, so go straight to the optimised link. The
+        //libraries it leaves behind make the later pipelines sharing its
+        //parts quick to link.
+        bool linked = false;
+        finish(key, entry, compile(description, true, linked));
+        return entry.handle;
+    }
+
+    PipelineHandle PipelineManager::request(const PipelineDescription& requested)
+    {
+        PipelineDescription description = normalise(requested);
+        uint64_t key = description.hash();
+        auto found = _entries.find(key);
+        if (found != _entries.end())
+        {
+            Entry* entry = find(key, description);
+            std::lock_guard<std::mutex> lock(_statsMutex);
+            _stats.hits++;
+            return entry != nullptr && entry->state == State::READY ? entry->handle : PipelineHandle();
+        }
+
+        Entry& entry = _entries[key];
+        entry.description = description;
+        {
+            std::lock_guard<std::mutex> lock(_statsMutex);
+            _stats.misses++;
+            _stats.compiling++;
+        }
+        submit(key, entry, false);
+
+        return PipelineHandle();
+    }
+
+    void PipelineManager::update(uint64_t frame)
+    {
+        _frame = frame;
+
+        std::vector<Compiled> completed;
+        {
+            std::lock_guard<std::mutex> lock(_completedMutex);
+            completed.swap(_completed);
+        }
+
+        for (const Compiled& compiled : completed)
+        {
+            Entry& entry = _entries[compiled.key];
+            //Built from a shader that has been reloaded since.
+            bool stale = compiled.generation != entry.generation;
+            if (compiled.replacement)
+            {
+                //The one it replaces may still be in a frame in flight.
+                if (stale == false && compiled.pipeline != VK_NULL_HANDLE && entry.state == State::READY)
+                {
+                    _resources.replace(frame, entry.handle, compiled.pipeline);
+                }
+                else
+                {
+                    if (stale == false && compiled.pipeline == VK_NULL_HANDLE)
+                    {
+                        GUST_WARN("Rebuilding pipeline {0:x} failed, keeping the old one.", compiled.key);
+                    }
+                    vkDestroyPipeline(_device, compiled.pipeline, nullptr);
+                }
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_statsMutex);
+                _stats.compiling--;
+            }
+            finish(compiled.key, entry, compiled.pipeline);
+            if (stale)
+            {
+                rebuild(compiled.key, entry);
+            }
+        }
+
+        if (_staleLibraries)
+        {
+            bool idle = false;
+            {
+                std::lock_guard<std::mutex> lock(_completedMutex);
+                idle = _compilesInFlight == 0;
+            }
+            if (idle)
+            {
+                destroyStaleLibraries();
+                _staleLibraries = false;
+            }
+        }
+    }
+
+    void PipelineManager::reload(const std::string& shaderPath)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        {
+            std::lock_guard<std::mutex> lock(_libraryMutex);
+            _shaderRevisions[shaderPath]++;
+        }
+        _staleLibraries = _graphicsPipelineLibrary;
+
+        uint32_t rebuilt = 0;
+        for (auto& [key, entry] : _entries)
+        {
+            if (entry.description.vertexShader != shaderPath && entry.description.fragmentShader != shaderPath)
+            {
+                continue;
+            }
+
+            entry.generation++;
+            rebuild(key, entry);
+            rebuilt++;
+        }
+
+        GUST_INFO("Rebuilding {0} pipelines using {1}.", rebuilt, shaderPath);
+    }
+
+    void PipelineManager::benchmark(const PipelineDescription& requested, uint32_t runs)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        if (_graphicsPipelineLibrary == false || runs == 0)
+        {
+            GUST_WARN("Pipeline benchmark skipped, graphics pipeline libraries aren't supported.");
+            return;
+        }
+
+        PipelineDescription description = normalise(requested);
+        float fullCompile = 0.f;
+        float libraries = 0.f;
+        float fastLink = 0.f;
+        float optimisedLink = 0.f;
+        for (uint32_t run = 0; run < runs; run++)
+        {
+            float milliseconds = 0.f;
+            vkDestroyPipeline(_device, compileFull(description, VK_NULL_HANDLE, milliseconds), nullptr);
+            fullCompile += milliseconds;
+
+            Libraries parts{};
+            for (size_t part = 0; part < parts.size(); part++)
+            {
+                parts[part] = buildLibrary(libraryDescription(description, static_cast<LibraryPart>(part)), static_cast<LibraryPart>(part), VK_NULL_HANDLE, milliseconds);
+                libraries += milliseconds;
+            }
+
+            if (std::find(parts.begin(), parts.end(), VK_NULL_HANDLE) == parts.end())
+            {
+                vkDestroyPipeline(_device, link(description, parts, false, VK_NULL_HANDLE, milliseconds), nullptr);
+                fastLink += milliseconds;
+                vkDestroyPipeline(_device, link(description, parts, true, VK_NULL_HANDLE, milliseconds), nullptr);
+                optimisedLink += milliseconds;
+            }
+
+            for (VkPipeline part : parts)
+            {
+                vkDestroyPipeline(_device, part, nullptr);
+            }
+        }
+
+        float scale = 1.f / static_cast<float>(runs);
+        GUST_INFO("Pipeline benchmark ({0}, {1}) over {2} runs: full compile {3:.3f} ms, libraries {4:.3f} ms, fast link {5:.3f} ms, optimised link {6:.3f} ms.",
+                  description.vertexShader, description.fragmentShader, runs, fullCompile * scale, libraries * scale, fastLink * scale, optimisedLink * scale);
+    }
+
+    PipelineManagerStats PipelineManager::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        return _stats;
+    }
+
+    PipelineManager::Entry* PipelineManager::find(uint64_t key, const PipelineDescription& description)
+    {
+        Entry& entry = _entries[key];
+        if ((entry.description == description) == false)
+        {
+            GUST_ERROR("Pipeline hash collision on {0:x}, the second pipeline won't be built.", key);
+            return nullptr;
+        }
+        return &entry;
+    }
+
+    PipelineDescription PipelineManager::normalise(const PipelineDescription& description)
+    {
+        PipelineDescription normalised = description;
+        if (normalised.variant != 0)
+        {
+            normalised.variant = _variants.normalise(description.vertexShader, description.variant) |
+                                 _variants.normalise(description.fragmentShader, description.variant);
+        }
+        return normalised;
+    }
+
+    void PipelineManager::finish(uint64_t key, Entry& entry, VkPipeline pipeline)
+    {
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        if (pipeline == VK_NULL_HANDLE)
+        {
+            GUST_WARN("Pipeline {0:x} ({1}, {2}) failed to build.", key, entry.description.vertexShader, entry.description.fragmentShader);
+            entry.state = State::FAILED;
+            _stats.failed++;
+            return;
+        }
+
+        GpuPipeline gpuPipeline;
+        gpuPipeline.pipeline = pipeline;
+        gpuPipeline.layout = entry.description.layout;
+        entry.handle = _resources.addPipeline(gpuPipeline);
+        entry.state = State::READY;
+        _stats.pipelines++;
+    }
+
+    void PipelineManager::submit(uint64_t key, const Entry& entry, bool replacement)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_completedMutex);
+            _compilesInFlight++;
+        }
+
+        ThreadPool::get().submit([this, key, description = entry.description, generation = entry.generation, replacement]()
+        {
+            bool linked = false;
+            VkPipeline pipeline = compile(description, false, linked);
+            {
+                std::lock_guard<std::mutex> lock(_completedMutex);
+                _completed.push_back({ key, pipeline, generation, replacement });
+            }
+
+            //The fast link got something drawing, now build the one worth
+            //keeping. Still counted as in flight so shutdown waits for it.
+            if (linked && pipeline != VK_NULL_HANDLE)
+            {
+                VkPipeline optimised = compile(description, true, linked);
+                std::lock_guard<std::mutex> lock(_completedMutex);
+                _completed.push_back({ key, optimised, generation, true });
+            }
+
+            std::lock_guard<std::mutex> lock(_completedMutex);
+            _compilesInFlight--;
+            _idle.notify_all();
+        });
+    }
+
+    void PipelineManager::rebuild(uint64_t key, Entry& entry)
+    {
+        if (entry.state == State::COMPILING)
+        {
+            return;
+        }
+
+        //A ready pipeline keeps drawing with the old shader until the new
+        //one lands. A failed one gets another go, the edit may have fixed it.
+        bool replacement = entry.state == State::READY;
+        if (replacement == false)
+        {
+            std::lock_guard<std::mutex> lock(_statsMutex);
+            _stats.failed--;
+            _stats.compiling++;
+            entry.state = State::COMPILING;
+        }
+        submit(key, entry, replacement);
+    }
+
+    //Only reads the description and its files, so it runs on any thread.
+    VkPipeline PipelineManager::compile(const PipelineDescription& description, bool optimised, bool& linked)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        float milliseconds = 0.f;
+        Libraries libraries{};
+        linked = _graphicsPipelineLibrary && getLibraries(description, libraries);
+        if (linked)
+        {
+            VkPipeline pipeline = link(description, libraries, optimised, _cache.get(), milliseconds);
+            _cache.recordCreation(milliseconds);
+
+            std::lock_guard<std::mutex> lock(_statsMutex);
+            if (optimised)
+            {
+                _stats.optimisedLinks++;
+                _stats.optimisedLinkMilliseconds += milliseconds;
+            }
+            else
+            {
+                _stats.fastLinks++;
+                _stats.fastLinkMilliseconds += milliseconds;
+            }
+            return pipeline;
+        }
+
+        VkPipeline pipeline = compileFull(description, _cache.get(), milliseconds);
+        _cache.recordCreation(milliseconds);
+
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        _stats.fullCompiles++;
+        _stats.fullCompileMilliseconds += milliseconds;
+        return pipeline;
+    }
+
+    VkPipeline PipelineManager::compileFull(const PipelineDescription& description, VkPipelineCache cache, float& milliseconds)
+    {
+        ShaderStages shaderStages(_device);
+        if (shaderStages.add(_variants, description.vertexShader, description.variant, VK_SHADER_STAGE_VERTEX_BIT) == false ||
+            shaderStages.add(_variants, description.fragmentShader, description.variant, VK_SHADER_STAGE_FRAGMENT_BIT) == false)
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        FixedFunctionState state(description);
+
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = shaderStages.count();
+        pipelineInfo.pStages = shaderStages.data();
+        pipelineInfo.pVertexInputState = &state.vertexInputInfo;
+        pipelineInfo.pInputAssemblyState = &state.inputAssembly;
+        pipelineInfo.pViewportState = &state.viewportState;
+        pipelineInfo.pRasterizationState = &state.rasterizer;
+        pipelineInfo.pDepthStencilState = &state.depthStencil;
+        pipelineInfo.pMultisampleState = &state.multisampling;
+        pipelineInfo.pColorBlendState = &state.colourBlending;
+        pipelineInfo.pDynamicState = &state.dynamicState;
+        pipelineInfo.layout = description.layout;
+        pipelineInfo.renderPass = description.renderPass;
+        pipelineInfo.subpass = description.subpass;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        return createPipeline(_device, cache, pipelineInfo, milliseconds);
+    }
+
+    //Everything outside the part is left at its default so descriptions
+    //that only differ elsewhere share the library.
+    PipelineDescription PipelineManager::libraryDescription(const PipelineDescription& description, LibraryPart part)
+    {
+        PipelineDescription library;
+        switch (part)
+        {
+        case LibraryPart::VERTEX_INPUT:
+            library.vertexStride = description.vertexStride;
+            library.vertexAttributes = description.vertexAttributes;
+            library.topology = description.topology;
+            break;
+        case LibraryPart::PRE_RASTERISATION:
+            library.vertexShader = description.vertexShader;
+            library.variant = description.variant != 0 ? _variants.normalise(description.vertexShader, description.variant) : 0;
+            library.polygonMode = description.polygonMode;
+            library.cullMode = description.cullMode;
+            library.frontFace = description.frontFace;
+            library.layout = description.layout;
+            library.renderPass = description.renderPass;
+            library.subpass = description.subpass;
+            break;
+        case LibraryPart::FRAGMENT_SHADER:
+            library.fragmentShader = description.fragmentShader;
+            library.variant = description.variant != 0 ? _variants.normalise(description.fragmentShader, description.variant) : 0;
+            library.depthTest = description.depthTest;
+            library.depthWrite = description.depthWrite;
+            library.depthCompare = description.depthCompare;
+            library.samples = description.samples;
+            library.layout = description.layout;
+            library.renderPass = description.renderPass;
+            library.subpass = description.subpass;
+            break;
+        case LibraryPart::FRAGMENT_OUTPUT:
+            library.blend = description.blend;
+            library.sourceBlend = description.sourceBlend;
+            library.destinationBlend = description.destinationBlend;
+            library.blendOp = description.blendOp;
+            library.colourFormat = description.colourFormat;
+            library.depthFormat = description.depthFormat;
+            library.samples = description.samples;
+            library.renderPass = description.renderPass;
+            library.subpass = description.subpass;
+            break;
+        default:
+            break;
+        }
+        return library;
+    }
+
+    bool PipelineManager::getLibraries(const PipelineDescription& description, Libraries& libraries)
+    {
+        for (size_t part = 0; part < libraries.size(); part++)
+        {
+            libraries[part] = getLibrary(description, static_cast<LibraryPart>(part));
+            if (libraries[part] == VK_NULL_HANDLE)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    VkPipeline PipelineManager::getLibrary(const PipelineDescription& description, LibraryPart part)
+    {
+        PipelineDescription partDescription = libraryDescription(description, part);
+
+        std::unique_lock<std::mutex> lock(_libraryMutex);
+        uint32_t revision = shaderRevision(partDescription, part);
+        uint64_t key = hashValue(revision, hashValue(part, partDescription.hash()));
+        auto [found, inserted] = _libraries.try_emplace(key);
+        Library& library = found->second;
+        if (inserted == false)
+        {
+            if (library.part != part || library.revision != revision || (library.description == partDescription) == false)
+            {
+                GUST_ERROR("Pipeline library hash collision on {0:x}, falling back to a full compile.", key);
+                return VK_NULL_HANDLE;
+            }
+
+            _libraryBuilt.wait(lock, [&library]() { return library.building == false; });
+            return library.pipeline;
+        }
+
+        library.description = partDescription;
+        library.part = part;
+        library.revision = revision;
+        lock.unlock();
+
+        float milliseconds = 0.f;
+        VkPipeline pipeline = buildLibrary(partDescription, part, _cache.get(), milliseconds);
+        _cache.recordCreation(milliseconds);
+        {
+            std::lock_guard<std::mutex> statsLock(_statsMutex);
+            _stats.libraries++;
+            _stats.libraryMilliseconds += milliseconds;
+        }
+
+        //A failed part stays failed, the pipelines using it fall back to
+        //full compiles rather than trying it again.
+        lock.lock();
+        library.pipeline = pipeline;
+        library.building = false;
+        _libraryBuilt.notify_all();
+        return pipeline;
+    }
+
+    uint32_t PipelineManager::shaderRevision(const PipelineDescription& partDescription, LibraryPart part) const
+    {
+        const std::string* shader = nullptr;
+        if (part == LibraryPart::PRE_RASTERISATION)
+        {
+            shader = &partDescription.vertexShader;
+        }
+        else if (part == LibraryPart::FRAGMENT_SHADER)
+        {
+            shader = &partDescription.fragmentShader;
+        }
+
+        if (shader == nullptr)
+        {
+            return 0;
+        }
+        auto found = _shaderRevisions.find(*shader);
+        return found != _shaderRevisions.end() ? found->second : 0;
+    }
+
+    //Linked pipelines don't need their libraries, so nothing drawing cares.
+    void PipelineManager::destroyStaleLibraries()
+    {
+        std::lock_guard<std::mutex> lock(_libraryMutex);
+        for (auto it = _libraries.begin(); it != _libraries.end();)
+        {
+            if (it->second.revision != shaderRevision(it->second.description, it->second.part))
+            {
+                vkDestroyPipeline(_device, it->second.pipeline, nullptr);
+                it = _libraries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    VkPipeline PipelineManager::buildLibrary(const PipelineDescription& description, LibraryPart part, VkPipelineCache cache, float& milliseconds)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        ShaderStages shaderStages(_device);
+        FixedFunctionState state(description);
+
+        VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+        libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+
+        //Kept for the optimised link, which needs more than the fast one.
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.pNext = &libraryInfo;
+        pipelineInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        switch (part)
+        {
+        case LibraryPart::VERTEX_INPUT:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+            pipelineInfo.pVertexInputState = &state.vertexInputInfo;
+            pipelineInfo.pInputAssemblyState = &state.inputAssembly;
+            break;
+        case LibraryPart::PRE_RASTERISATION:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+            if (shaderStages.add(_variants, description.vertexShader, description.variant, VK_SHADER_STAGE_VERTEX_BIT) == false)
+            {
+                return VK_NULL_HANDLE;
+            }
+            pipelineInfo.pViewportState = &state.viewportState;
+            pipelineInfo.pRasterizationState = &state.rasterizer;
+            pipelineInfo.pDynamicState = &state.dynamicState;
+            break;
+        case LibraryPart::FRAGMENT_SHADER:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+            if (shaderStages.add(_variants, description.fragmentShader, description.variant, VK_SHADER_STAGE_FRAGMENT_BIT) == false)
+            {
+                return VK_NULL_HANDLE;
+            }
+            pipelineInfo.pDepthStencilState = &state.depthStencil;
+            pipelineInfo.pMultisampleState = &state.multisampling;
+            break;
+        case LibraryPart::FRAGMENT_OUTPUT:
+            libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+            pipelineInfo.pMultisampleState = &state.multisampling;
+            pipelineInfo.pColorBlendState = &state.colourBlending;
+            break;
+        default:
+            return VK_NULL_HANDLE;
+        }
+
+        pipelineInfo.stageCount = shaderStages.count();
+        pipelineInfo.pStages = shaderStages.count() > 0 ? shaderStages.data() : nullptr;
+        pipelineInfo.layout = description.layout;
+        pipelineInfo.renderPass = description.renderPass;
+        pipelineInfo.subpass = description.subpass;
+
+        VkPipeline pipeline = createPipeline(_device, cache, pipelineInfo, milliseconds);
+        if (pipeline == VK_NULL_HANDLE)
+        {
+            GUST_WARN("Pipeline library part {0} failed to build.", static_cast<uint32_t>(part));
+        }
+        return pipeline;
+    }
+
+    VkPipeline PipelineManager::link(const PipelineDescription& description, const Libraries& libraries, bool optimised, VkPipelineCache cache, float& milliseconds)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        VkPipelineLibraryCreateInfoKHR linkInfo{};
+        linkInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+        linkInfo.libraryCount = static_cast<uint32_t>(libraries.size());
+        linkInfo.pLibraries = libraries.data();
+
+        //Without the flag the driver only stitches the parts together, with
+        //it the shaders are optimised across them like a full compile.
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.pNext = &linkInfo;
+        pipelineInfo.flags = optimised ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+        pipelineInfo.layout = description.layout;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        return createPipeline(_device, cache, pipelineInfo, milliseconds);
+    }
+}
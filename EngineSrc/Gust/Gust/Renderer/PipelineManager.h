@@ -0,0 +1,239 @@
+#ifndef PIPELINE_MANAGER_HDR
+#define PIPELINE_MANAGER_HDR
+
+#include "PreComp.h"
+#include "Handle.h"
+#include "ShaderVariants.h"
+
+#include <vulkan/vulkan.h>
+#include <mutex>
+#include <condition_variable>
+
+namespace Gust
+{
+    class GpuResources;
+    class PipelineCache;
+
+    //Everything that makes one graphics pipeline differ from another.
+    //Viewport and scissor are always dynamic so they aren't part of it.
+    struct PipelineDescription
+    {
+        //Cooked SPIR-V, compiled from the GLSL instead when the source tree
+        //is there.
+        std::string vertexShader;
+        std::string fragmentShader;
+        //Option bits for both stages, see ShaderVariants.
+        VariantKey variant = 0;
+
+        uint32_t vertexStride = 0;
+        std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+        VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+        VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+        VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+        bool depthTest = true;
+        bool depthWrite = true;
+        VkCompareOp depthCompare = VK_COMPARE_OP_LESS;
+
+        bool blend = false;
+        VkBlendFactor sourceBlend = VK_BLEND_FACTOR_ONE;
+        VkBlendFactor destinationBlend = VK_BLEND_FACTOR_ZERO;
+        VkBlendOp blendOp = VK_BLEND_OP_ADD;
+
+        VkFormat colourFormat = VK_FORMAT_UNDEFINED;
+        VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        uint32_t subpass = 0;
+
+        //Not owned by the pipeline, it must outlive it.
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+
+        uint64_t hash() const;
+        bool operator==(const PipelineDescription& other) const;
+    };
+
+    struct PipelineManagerStats
+    {
+        uint32_t pipelines = 0;
+        uint32_t compiling = 0;
+        uint32_t failed = 0;
+        //Requests for a pipeline that already existed or was on its way.
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        //Where the time goes. Full compiles are the fallback without
+        //graphics pipeline libraries.
+        uint32_t fullCompiles = 0;
+        uint32_t libraries = 0;
+        uint32_t fastLinks = 0;
+        uint32_t optimisedLinks = 0;
+        float fullCompileMilliseconds = 0.f;
+        float libraryMilliseconds = 0.f;
+        float fastLinkMilliseconds = 0.f;
+        float optimisedLinkMilliseconds = 0.f;
+    };
+
+    //Builds each distinct pipeline once, keyed on a hash of its full
+    //description. Pipelines needed mid game are compiled on the thread pool
+    //so a new material never stalls the frame, the caller draws with a
+    //fallback or skips the draw until it's ready.
+    //
+    //With VK_EXT_graphics_pipeline_library each pipeline is split into its
+    //vertex input, pre-rasterisation, fragment shader and fragment output
+    //parts. Each distinct part is built once as a library and shared by
+    //every pipeline using it, so a new pipeline is usually only a fast link
+    //of parts that already exist. The fast linked pipeline is handed out
+    //straight away and an optimised link is swapped in behind the same
+    //handle when it's done.
+    //
+    //Reloading a shader rebuilds only the pipelines using it, the same way,
+    //and swaps them in behind their handles too. Nothing holding a handle
+    //has to know.
+    class PipelineManager
+    {
+    public:
+        PipelineManager(VkDevice device, GpuResources& resources, PipelineCache& cache, ShaderVariants& variants, bool graphicsPipelineLibrary);
+        //Waits for any compiles still running.
+        ~PipelineManager();
+
+        PipelineManager(const PipelineManager&) = delete;
+        PipelineManager& operator=(const PipelineManager&) = delete;
+
+        //Compiles on the calling thread if it doesn't exist yet. For the
+        //pipelines that have to be there before the first frame, like the
+        //fallback. Null if it failed to build.
+        PipelineHandle getOrCreate(const PipelineDescription& description);
+        //Never blocks. Null until the pipeline is ready, the first call
+        //starts it compiling in the background.
+        PipelineHandle request(const PipelineDescription& description);
+
+        //Call once a frame from the main thread to pick up finished compiles.
+        //Pipelines replaced by their optimised link or a rebuild are retired
+        //after frame.
+        void update(uint64_t frame);
+        //The shader's source changed. Rebuilds every pipeline using it in
+        //the background, the old ones keep drawing until then. Call from the
+        //main thread after ShaderVariants::invalidate.
+        void reload(const std::string& shaderPath);
+
+        //Times a full compile against building the libraries and linking
+        //them, without the pipeline cache so nothing is just looked up.
+        //Everything built is destroyed again. Blocks, start up only.
+        void benchmark(const PipelineDescription& description, uint32_t runs);
+
+        bool usesLibraries() const { return _graphicsPipelineLibrary; }
+        PipelineManagerStats getStats() const;
+    private:
+        enum class State
+        {
+            COMPILING,
+            READY,
+            FAILED
+        };
+
+        struct Entry
+        {
+            PipelineDescription description;
+            State state = State::COMPILING;
+            PipelineHandle handle;
+            //Goes up each time one of its shaders is reloaded.
+            uint32_t generation = 0;
+        };
+
+        struct Compiled
+        {
+            uint64_t key;
+            VkPipeline pipeline;
+            //Results from before the latest reload are thrown away.
+            uint32_t generation = 0;
+            //Swapped in behind the entry's handle, the optimised link or a
+            //rebuild after a reload.
+            bool replacement = false;
+        };
+
+        enum class LibraryPart : uint32_t
+        {
+            VERTEX_INPUT,
+            PRE_RASTERISATION,
+            FRAGMENT_SHADER,
+            FRAGMENT_OUTPUT,
+            COUNT
+        };
+
+        using Libraries = std::array<VkPipeline, static_cast<size_t>(LibraryPart::COUNT)>;
+
+        struct Library
+        {
+            //Only the fields the part depends on, the rest are defaults.
+            PipelineDescription description;
+            LibraryPart part = LibraryPart::VERTEX_INPUT;
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            //Of its shader, see shaderRevision.
+            uint32_t revision = 0;
+            bool building = true;
+        };
+
+        //Null if the description doesn't match the one stored under its
+        //hash, which should never happen but must never draw the wrong thing.
+        Entry* find(uint64_t key, const PipelineDescription& description);
+        //Drops the option bits neither shader declared so they don't make
+        //a second copy of the same pipeline.
+        PipelineDescription normalise(const PipelineDescription& description);
+        void finish(uint64_t key, Entry& entry, VkPipeline pipeline);
+        //Compiles on the thread pool, then the optimised link if it was a
+        //fast link.
+        void submit(uint64_t key, const Entry& entry, bool replacement);
+        //Compiles it again from the current shaders, or leaves it to update
+        //when it's still compiling from the old ones.
+        void rebuild(uint64_t key, Entry& entry);
+        //Runs on any thread. The fast or optimised link when libraries are
+        //supported and a full compile otherwise, linked says which it was.
+        VkPipeline compile(const PipelineDescription& description, bool optimised, bool& linked);
+        VkPipeline compileFull(const PipelineDescription& description, VkPipelineCache cache, float& milliseconds);
+
+        PipelineDescription libraryDescription(const PipelineDescription& description, LibraryPart part);
+        //Builds any part nobody has built yet. False if one failed.
+        bool getLibraries(const PipelineDescription& description, Libraries& libraries);
+        VkPipeline getLibrary(const PipelineDescription& description, LibraryPart part);
+        //How many times the part's shader has been reloaded, zero for the
+        //parts without one. Call with _libraryMutex held.
+        uint32_t shaderRevision(const PipelineDescription& partDescription, LibraryPart part) const;
+        //Libraries built from shaders that have since been reloaded. Only
+        //once no compile is running, one could be linking against them.
+        void destroyStaleLibraries();
+        VkPipeline buildLibrary(const PipelineDescription& description, LibraryPart part, VkPipelineCache cache, float& milliseconds);
+        VkPipeline link(const PipelineDescription& description, const Libraries& libraries, bool optimised, VkPipelineCache cache, float& milliseconds);
+    private:
+        VkDevice _device;
+        GpuResources& _resources;
+        PipelineCache& _cache;
+        ShaderVariants& _variants;
+        bool _graphicsPipelineLibrary;
+
+        std::unordered_map<uint64_t, Entry> _entries;
+        uint64_t _frame = 0;
+
+        //Workers share libraries, a part being built by one is waited on by
+        //the others rather than built twice.
+        std::mutex _libraryMutex;
+        std::condition_variable _libraryBuilt;
+        std::unordered_map<uint64_t, Library> _libraries;
+        //Part of every shader library's key, so a reload gets new libraries
+        //and the old ones are left for destroyStaleLibraries.
+        std::unordered_map<std::string, uint32_t> _shaderRevisions;
+        bool _staleLibraries = false;
+
+        std::mutex _completedMutex;
+        std::condition_variable _idle;
+        std::vector<Compiled> _completed;
+        uint32_t _compilesInFlight = 0;
+
+        mutable std::mutex _statsMutex;
+        PipelineManagerStats _stats;
+    };
+}
+
+#endif // !PIPELINE_MANAGER_HDR
@@ -0,0 +1,164 @@
+#include "PreComp.h"
+#include "RenderPassCache.h"
+
+#include "Gust/Core/Hash.h"
+
+namespace Gust
+{
+    uint64_t RenderPassDescription::hash() const
+    {
+        uint64_t hash = HASH_SEED;
+        for (VkFormat format : colourFormats)
+        {
+            hash = hashValue(format, hash);
+        }
+        hash = hashValue(depthFormat, hash);
+        hash = hashValue(samples, hash);
+        hash = hashValue(clear, hash);
+        hash = hashValue(storeDepth, hash);
+        hash = hashValue(colourFinalLayout, hash);
+        return hash;
+    }
+
+    bool RenderPassDescription::operator==(const RenderPassDescription& other) const
+    {
+        return colourFormats == other.colourFormats && depthFormat == other.depthFormat && samples == other.samples &&
+               clear == other.clear && storeDepth == other.storeDepth && colourFinalLayout == other.colourFinalLayout;
+    }
+
+    RenderPassCache::RenderPassCache(VkDevice device) :
+        _device(device)
+    {
+    }
+
+    RenderPassCache::~RenderPassCache()
+    {
+        for (auto& [key, entries] : _renderPasses)
+        {
+            for (auto& entry : entries)
+            {
+                vkDestroyRenderPass(_device, entry.renderPass, nullptr);
+            }
+        }
+    }
+
+    VkRenderPass RenderPassCache::getRenderPass(const RenderPassDescription& description)
+    {
+        auto& entries = _renderPasses[description.hash()];
+        for (const auto& entry : entries)
+        {
+            if (entry.description == description)
+            {
+                _stats.hits++;
+                return entry.renderPass;
+            }
+        }
+
+        VkRenderPass renderPass = create(description);
+        if (renderPass == VK_NULL_HANDLE)
+        {
+            GUST_ERROR("Failed to create a render pass with {0} colour attachments.", description.colourFormats.size());
+            return VK_NULL_HANDLE;
+        }
+
+        entries.push_back({ description, renderPass });
+        _stats.renderPasses++;
+        return renderPass;
+    }
+
+    VkRenderPass RenderPassCache::create(const RenderPassDescription& description) const
+    {
+        bool multisampled = description.samples != VK_SAMPLE_COUNT_1_BIT;
+        bool hasDepth = description.depthFormat != VK_FORMAT_UNDEFINED;
+        VkAttachmentLoadOp loadOp = description.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+
+        std::vector<VkAttachmentDescription> attachments;
+        std::vector<VkAttachmentReference> colourReferences;
+        std::vector<VkAttachmentReference> resolveReferences;
+
+        for (VkFormat format : description.colourFormats)
+        {
+            VkAttachmentDescription colourAttachment{};
+            colourAttachment.format = format;
+            colourAttachment.samples = description.samples;
+            colourAttachment.loadOp = loadOp;
+            //Only the resolve is kept, so the samples never have to leave the
+            //tile and the attachment can live in lazily allocated memory.
+            colourAttachment.storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+            colourAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colourAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colourAttachment.initialLayout = description.clear ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            colourAttachment.finalLayout = multisampled ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : description.colourFinalLayout;
+
+            colourReferences.push_back({ static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+            attachments.push_back(colourAttachment);
+        }
+
+        VkAttachmentReference depthReference{};
+        if (hasDepth)
+        {
+            VkAttachmentDescription depthAttachment{};
+            depthAttachment.format = description.depthFormat;
+            depthAttachment.samples = description.samples;
+            depthAttachment.loadOp = loadOp;
+            depthAttachment.storeOp = description.storeDepth ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depthAttachment.initialLayout = description.clear ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+            depthReference = { static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+            attachments.push_back(depthAttachment);
+        }
+
+        if (multisampled)
+        {
+            for (VkFormat format : description.colourFormats)
+            {
+                VkAttachmentDescription resolveAttachment{};
+                resolveAttachment.format = format;
+                resolveAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+                resolveAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                resolveAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+                resolveAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                resolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                resolveAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                resolveAttachment.finalLayout = description.colourFinalLayout;
+
+                resolveReferences.push_back({ static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+                attachments.push_back(resolveAttachment);
+            }
+        }
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = static_cast<uint32_t>(colourReferences.size());
+        subpass.pColorAttachments = colourReferences.data();
+        subpass.pDepthStencilAttachment = hasDepth ? &depthReference : nullptr;
+        subpass.pResolveAttachments = multisampled ? resolveReferences.data() : nullptr;
+
+        VkSubpassDependency dependency{};
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependency.srcAccessMask = 0;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        renderPassInfo.pAttachments = attachments.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.dependencyCount = 1;
+        renderPassInfo.pDependencies = &dependency;
+
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        if (vkCreateRenderPass(_device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+        {
+            return VK_NULL_HANDLE;
+        }
+        return renderPass;
+    }
+}
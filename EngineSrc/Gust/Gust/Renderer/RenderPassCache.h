@@ -0,0 +1,70 @@
+#ifndef RENDER_PASS_CACHE_HDR
+#define RENDER_PASS_CACHE_HDR
+
+#include "PreComp.h"
+
+#include <vulkan/vulkan.h>
+
+namespace Gust
+{
+    //A single subpass pass, the only shape the engine draws with. Colour
+    //attachments come first, then depth, then when multisampled one single
+    //sample resolve per colour attachment.
+    struct RenderPassDescription
+    {
+        std::vector<VkFormat> colourFormats;
+        //Undefined for no depth attachment.
+        VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+        bool clear = true;
+        //Depth is normally thrown away at the end of the pass.
+        bool storeDepth = false;
+        //The layout the kept colour, or its resolve, is left in.
+        VkImageLayout colourFinalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+        uint64_t hash() const;
+        bool operator==(const RenderPassDescription& other) const;
+    };
+
+    struct RenderPassCacheStats
+    {
+        uint32_t renderPasses = 0;
+        //Requests for a pass that already existed.
+        uint64_t hits = 0;
+    };
+
+    //One render pass per distinct description, so passes and pipelines
+    //that agree on their attachments share it. Owns every pass it makes,
+    //they live until the cache goes. Main thread only.
+    class RenderPassCache
+    {
+    public:
+        RenderPassCache(VkDevice device);
+        ~RenderPassCache();
+
+        RenderPassCache(const RenderPassCache&) = delete;
+        RenderPassCache& operator=(const RenderPassCache&) = delete;
+
+        VkRenderPass getRenderPass(const RenderPassDescription& description);
+
+        const RenderPassCacheStats& getStats() const { return _stats; }
+    private:
+        struct Entry
+        {
+            RenderPassDescription description;
+            VkRenderPass renderPass;
+        };
+
+        VkRenderPass create(const RenderPassDescription& description) const;
+    private:
+        VkDevice _device;
+
+        //Keyed by hash with every entry that landed on it, so a collision
+        //just costs a compare.
+        std::unordered_map<uint64_t, std::vector<Entry>> _renderPasses;
+
+        RenderPassCacheStats _stats;
+    };
+}
+
+#endif // !RENDER_PASS_CACHE_HDR
@@ -0,0 +1,520 @@
+#include "PreComp.h"
+#include "ShaderCompiler.h"
+
+#include "Gust/Core/Hash.h"
+#include "Gust/Core/ThreadPool.h"
+
+#ifdef GUST_HAS_SHADERC
+#include <shaderc/shaderc.hpp>
+#endif
+
+#include <chrono>
+#include <fstream>
+
+namespace
+{
+    //Bump this whenever compiling changes the output for the same input.
+    const uint32_t SHADER_COMPILER_VERSION = 1;
+    const uint32_t SPIRV_MAGIC = 0x07230203;
+
+    bool readText(const std::filesystem::path& filePath, std::string& text)
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        std::stringstream contents;
+        contents << file.rdbuf();
+        text = contents.str();
+        return true;
+    }
+
+    struct IncludeDirective
+    {
+        std::string name;
+        bool relative;
+    };
+
+    //Only has to be good enough for the cache key. Includes that are
+    //commented out or behind an #if still count, which at worst costs a
+    //compile that wasn't needed.
+    std::vector<IncludeDirective> findIncludes(const std::string& text)
+    {
+        std::vector<IncludeDirective> includes;
+
+        std::istringstream lines(text);
+        std::string line;
+        while (std::getline(lines, line))
+        {
+            size_t position = line.find_first_not_of(" \t");
+            if (position == std::string::npos || line[position] != '#')
+            {
+                continue;
+            }
+
+            position = line.find_first_not_of(" \t", position + 1);
+            if (position == std::string::npos || line.compare(position, 7, "include") != 0)
+            {
+                continue;
+            }
+
+            position = line.find_first_not_of(" \t", position + 7);
+            if (position == std::string::npos || (line[position] != '"' && line[position] != '<'))
+            {
+                continue;
+            }
+
+            bool relative = line[position] == '"';
+            size_t end = line.find(relative ? '"' : '>', position + 1);
+            if (end != std::string::npos)
+            {
+                includes.push_back({ line.substr(position + 1, end - position - 1), relative });
+            }
+        }
+
+        return includes;
+    }
+
+#ifdef GUST_HAS_SHADERC
+    shaderc_shader_kind shaderKind(const std::filesystem::path& filePath)
+    {
+        std::string extension = filePath.extension().string();
+        if (extension == ".vert") return shaderc_glsl_vertex_shader;
+        if (extension == ".frag") return shaderc_glsl_fragment_shader;
+        if (extension == ".comp") return shaderc_glsl_compute_shader;
+        if (extension == ".geom") return shaderc_glsl_geometry_shader;
+        if (extension == ".tesc") return shaderc_glsl_tess_control_shader;
+        if (extension == ".tese") return shaderc_glsl_tess_evaluation_shader;
+        return shaderc_glsl_infer_from_source;
+    }
+
+    //Resolves includes the same way the cache key does, so the key always
+    //covers what actually got compiled.
+    class Includer : public shaderc::CompileOptions::IncluderInterface
+    {
+    public:
+        Includer(const std::filesystem::path& sourceRoot) : _sourceRoot(sourceRoot)
+        {
+        }
+
+        shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type, const char* requestingSource, size_t includeDepth) override
+        {
+            auto* include = new Include();
+
+            std::filesystem::path resolved;
+            if (Gust::ShaderCompiler::resolveInclude(_sourceRoot, requestingSource, requestedSource, type == shaderc_include_type_relative, resolved) &&
+                readText(resolved, include->content))
+            {
+                include->name = resolved.string();
+            }
+            else
+            {
+                //An empty name tells shaderc it failed and the content is
+                //the error.
+                include->content = std::string("Can't find include ") + requestedSource;
+            }
+
+            include->result.source_name = include->name.c_str();
+            include->result.source_name_length = include->name.size();
+            include->result.content = include->content.c_str();
+            include->result.content_length = include->content.size();
+            include->result.user_data = include;
+            return &include->result;
+        }
+
+        void ReleaseInclude(shaderc_include_result* data) override
+        {
+            delete static_cast<Include*>(data->user_data);
+        }
+    private:
+        struct Include
+        {
+            shaderc_include_result result;
+            std::string name;
+            std::string content;
+        };
+
+        std::filesystem::path _sourceRoot;
+    };
+#endif
+}
+
+namespace Gust
+{
+    ShaderCompiler::ShaderCompiler(const std::string& sourceRoot, const std::string& cacheDirectory) :
+        _sourceRoot(sourceRoot), _cacheDirectory(cacheDirectory)
+    {
+        std::error_code error;
+        bool hasSources = !_sourceRoot.empty() && std::filesystem::is_directory(_sourceRoot, error);
+
+#ifdef GUST_HAS_SHADERC
+        _canCompile = hasSources;
+#else
+        if (hasSources)
+        {
+            GUST_INFO("Built without shaderc, shaders load from the cooked SPIR-V.");
+        }
+#endif
+    }
+
+    bool ShaderCompiler::compile(const ShaderCompileRequest& request, std::vector<uint32_t>& spirv)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        bool sourcesFound = false;
+        uint64_t key = makeKey(request, sourcesFound);
+        if (sourcesFound == false)
+        {
+            GUST_ERROR("Failed to read shader source {0}", request.sourcePath);
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.failures++;
+            return false;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _compiled.wait(lock, [this, key]() { return _compiling.count(key) == 0; });
+
+            auto found = _spirv.find(key);
+            if (found != _spirv.end())
+            {
+                _stats.memoryHits++;
+                spirv = found->second;
+                return true;
+            }
+            _compiling.insert(key);
+        }
+
+        std::filesystem::path cacheFile = cachePath(key);
+        bool fromDisk = readSpirv(cacheFile.string(), spirv);
+        bool compiled = false;
+        float milliseconds = 0.f;
+
+        if (fromDisk == false)
+        {
+            auto startTime = std::chrono::high_resolution_clock::now();
+            compiled = compileSource(request, spirv);
+            milliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+            if (compiled)
+            {
+                std::error_code error;
+                std::filesystem::create_directories(_cacheDirectory, error);
+
+                std::filesystem::path tempFile = cacheFile;
+                tempFile += ".tmp";
+                {
+                    std::ofstream file(tempFile, std::ios::binary | std::ios::trunc);
+                    file.write(reinterpret_cast<const char*>(spirv.data()), static_cast<std::streamsize>(spirv.size() * sizeof(uint32_t)));
+                }
+                std::filesystem::rename(tempFile, cacheFile, error);
+                if (error)
+                {
+                    GUST_WARN("Failed to write the shader cache {0}", cacheFile.string());
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _compiling.erase(key);
+
+            if (fromDisk || compiled)
+            {
+                _spirv[key] = spirv;
+            }
+
+            if (fromDisk)
+            {
+                _stats.diskHits++;
+            }
+            else if (compiled)
+            {
+                _stats.compiles++;
+                _stats.compileMilliseconds += milliseconds;
+            }
+            else
+            {
+                _stats.failures++;
+            }
+        }
+        _compiled.notify_all();
+
+        return fromDisk || compiled;
+    }
+
+    bool ShaderCompiler::load(const std::string& spirvPath, const std::vector<ShaderDefine>& defines, std::vector<uint32_t>& spirv)
+    {
+        std::filesystem::path sourcePath = sourcePathFor(spirvPath);
+        if (!sourcePath.empty())
+        {
+            ShaderCompileRequest request;
+            request.sourcePath = sourcePath.generic_string();
+            request.defines = defines;
+            if (compile(request, spirv))
+            {
+                return true;
+            }
+
+            GUST_WARN("Falling back to the cooked {0}", spirvPath);
+        }
+
+        return readSpirv(spirvPath, spirv);
+    }
+
+    bool ShaderCompiler::readSource(const std::string& spirvPath, std::string& source) const
+    {
+        std::filesystem::path sourcePath = sourcePathFor(spirvPath);
+        return !sourcePath.empty() && readText(_sourceRoot / sourcePath, source);
+    }
+
+    uint32_t ShaderCompiler::compileAll(const std::vector<ShaderCompileRequest>& requests)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining = requests.size();
+        uint32_t failures = 0;
+
+        for (const auto& request : requests)
+        {
+            ThreadPool::get().submit([this, request, &mutex, &done, &remaining, &failures]()
+            {
+                std::vector<uint32_t> spirv;
+                bool compiled = compile(request, spirv);
+
+                //Notify under the lock, the waiting thread owns everything
+                //captured by reference.
+                std::lock_guard<std::mutex> lock(mutex);
+                if (compiled == false)
+                {
+                    failures++;
+                }
+                remaining--;
+                done.notify_all();
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&remaining]() { return remaining == 0; });
+        return failures;
+    }
+
+    std::vector<ShaderCompileRequest> ShaderCompiler::findSources() const
+    {
+        std::vector<ShaderCompileRequest> requests;
+
+        std::error_code error;
+        if (_sourceRoot.empty() || std::filesystem::is_directory(_sourceRoot, error) == false)
+        {
+            return requests;
+        }
+
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(_sourceRoot, error))
+        {
+            if (entry.is_regular_file() && isShaderSource(entry.path()))
+            {
+                ShaderCompileRequest request;
+                request.sourcePath = std::filesystem::relative(entry.path(), _sourceRoot, error).generic_string();
+                requests.push_back(request);
+            }
+        }
+
+        return requests;
+    }
+
+    std::vector<ShaderCompileRequest> ShaderCompiler::findDependents(const std::string& filePath) const
+    {
+        GUST_PROFILE_FUNCTION();
+
+        std::string changed = std::filesystem::path(filePath).lexically_normal().generic_string();
+        std::vector<ShaderCompileRequest> dependents;
+        for (auto& request : findSources())
+        {
+            //The same walk the cache key takes, so this sees exactly the
+            //includes a compile would.
+            std::unordered_set<std::string> visited;
+            uint64_t hash = HASH_SEED;
+            hashSources(_sourceRoot / request.sourcePath, visited, hash);
+            if (visited.count(changed) != 0)
+            {
+                dependents.push_back(std::move(request));
+            }
+        }
+
+        return dependents;
+    }
+
+    ShaderCompilerStats ShaderCompiler::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    bool ShaderCompiler::readSpirv(const std::string& filePath, std::vector<uint32_t>& spirv)
+    {
+        std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        if (fileSize == 0 || fileSize % sizeof(uint32_t) != 0)
+        {
+            return false;
+        }
+
+        spirv.resize(fileSize / sizeof(uint32_t));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(spirv.data()), static_cast<std::streamsize>(fileSize));
+        return file.good() && spirv[0] == SPIRV_MAGIC;
+    }
+
+    bool ShaderCompiler::isShaderSource(const std::filesystem::path& filePath)
+    {
+        std::string extension = filePath.extension().string();
+        return extension == ".vert" || extension == ".frag" || extension == ".comp" ||
+               extension == ".geom" || extension == ".tesc" || extension == ".tese";
+    }
+
+    bool ShaderCompiler::resolveInclude(const std::filesystem::path& sourceRoot, const std::filesystem::path& requestingFile,
+                                        const std::string& requested, bool relative, std::filesystem::path& resolved)
+    {
+        std::error_code error;
+        if (relative)
+        {
+            std::filesystem::path candidate = requestingFile.parent_path() / requested;
+            if (std::filesystem::is_regular_file(candidate, error))
+            {
+                resolved = candidate.lexically_normal();
+                return true;
+            }
+        }
+
+        std::filesystem::path candidate = sourceRoot / requested;
+        if (std::filesystem::is_regular_file(candidate, error))
+        {
+            resolved = candidate.lexically_normal();
+            return true;
+        }
+
+        return false;
+    }
+
+    bool ShaderCompiler::hashSources(const std::filesystem::path& filePath, std::unordered_set<std::string>& visited, uint64_t& hash) const
+    {
+        std::string name = filePath.lexically_normal().generic_string();
+        if (visited.insert(name).second == false)
+        {
+            return true;
+        }
+
+        std::string text;
+        if (readText(filePath, text) == false)
+        {
+            return false;
+        }
+
+        hash = hashString(name, hash);
+        hash = hashString(text, hash);
+
+        //A missing include is left for the compiler to report.
+        for (const auto& include : findIncludes(text))
+        {
+            std::filesystem::path resolved;
+            if (resolveInclude(_sourceRoot, filePath, include.name, include.relative, resolved) &&
+                hashSources(resolved, visited, hash) == false)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    uint64_t ShaderCompiler::makeKey(const ShaderCompileRequest& request, bool& sourcesFound) const
+    {
+        uint64_t hash = hashValue(SHADER_COMPILER_VERSION);
+
+        std::unordered_set<std::string> visited;
+        sourcesFound = hashSources(_sourceRoot / request.sourcePath, visited, hash);
+
+        //The same defines in a different order are the same shader.
+        std::vector<ShaderDefine> defines = request.defines;
+        std::sort(defines.begin(), defines.end(), [](const ShaderDefine& a, const ShaderDefine& b) { return a.name < b.name; });
+        for (const auto& define : defines)
+        {
+            hash = hashString(define.name, hash);
+            hash = hashString(define.value, hash);
+        }
+
+        hash = hashValue(request.optimise, hash);
+        hash = hashValue(request.debugInfo, hash);
+        return hash;
+    }
+
+    std::filesystem::path ShaderCompiler::cachePath(uint64_t key) const
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(key));
+        return _cacheDirectory / name;
+    }
+
+    std::filesystem::path ShaderCompiler::sourcePathFor(const std::string& spirvPath) const
+    {
+        std::filesystem::path sourcePath = spirvPath;
+        if (_canCompile == false || sourcePath.extension() != ".spv")
+        {
+            return {};
+        }
+
+        sourcePath.replace_extension();
+        std::error_code error;
+        return std::filesystem::is_regular_file(_sourceRoot / sourcePath, error) ? sourcePath : std::filesystem::path();
+    }
+
+    bool ShaderCompiler::compileSource(const ShaderCompileRequest& request, std::vector<uint32_t>& spirv)
+    {
+#ifdef GUST_HAS_SHADERC
+        std::filesystem::path filePath = _sourceRoot / request.sourcePath;
+        std::string source;
+        if (readText(filePath, source) == false)
+        {
+            return false;
+        }
+
+        shaderc::CompileOptions options;
+        options.SetSourceLanguage(shaderc_source_language_glsl);
+        options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
+        options.SetOptimizationLevel(request.optimise ? shaderc_optimization_level_performance : shaderc_optimization_level_zero);
+        if (request.debugInfo)
+        {
+            options.SetGenerateDebugInfo();
+        }
+        for (const auto& define : request.defines)
+        {
+            options.AddMacroDefinition(define.name, define.value);
+        }
+        options.SetIncluder(std::make_unique<Includer>(_sourceRoot));
+
+        //Making a compiler per call keeps them off the shared state, they're
+        //cheap next to the compile itself.
+        shaderc::Compiler compiler;
+        shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source, shaderKind(filePath), filePath.string().c_str(), options);
+        if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+        {
+            GUST_ERROR("Failed to compile {0}:\n{1}", request.sourcePath, result.GetErrorMessage());
+            return false;
+        }
+
+        spirv.assign(result.cbegin(), result.cend());
+        return true;
+#else
+        return false;
+#endif
+    }
+}
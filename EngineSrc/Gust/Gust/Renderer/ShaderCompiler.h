@@ -0,0 +1,103 @@
+#ifndef SHADER_COMPILER_HDR
+#define SHADER_COMPILER_HDR
+
+#include "PreComp.h"
+
+#include <filesystem>
+#include <mutex>
+#include <condition_variable>
+
+namespace Gust
+{
+    struct ShaderDefine
+    {
+        std::string name;
+        std::string value;
+    };
+
+    struct ShaderCompileRequest
+    {
+        //GLSL relative to the source root, the stage comes from the extension.
+        std::string sourcePath;
+        std::vector<ShaderDefine> defines;
+        bool optimise = true;
+        bool debugInfo = false;
+    };
+
+    struct ShaderCompilerStats
+    {
+        uint64_t memoryHits = 0;
+        uint64_t diskHits = 0;
+        uint64_t compiles = 0;
+        uint64_t failures = 0;
+        float compileMilliseconds = 0.f;
+    };
+
+    //Compiles GLSL to SPIR-V at runtime so shaders can be edited without a
+    //cook. The result is keyed on a hash of the source, everything it
+    //includes, the defines and the options, and kept in memory and on disk,
+    //so a shader is only compiled again when one of those changes. Without
+    //shaderc, or without the source tree, it falls back to the SPIR-V that
+    //GustCook made.
+    class ShaderCompiler
+    {
+    public:
+        ShaderCompiler(const std::string& sourceRoot, const std::string& cacheDirectory);
+        ~ShaderCompiler() = default;
+
+        ShaderCompiler(const ShaderCompiler&) = delete;
+        ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+
+        //Safe to call from any thread.
+        bool compile(const ShaderCompileRequest& request, std::vector<uint32_t>& spirv);
+        //Takes the path of cooked SPIR-V, compiling the GLSL it came from
+        //instead when that's in the source tree.
+        bool load(const std::string& spirvPath, const std::vector<ShaderDefine>& defines, std::vector<uint32_t>& spirv);
+        //The GLSL a cooked SPIR-V path came from, false if it can't be
+        //compiled here.
+        bool readSource(const std::string& spirvPath, std::string& source) const;
+        //Compiles on the thread pool and waits for all of them, so never
+        //call it from a pool thread. Returns how many failed.
+        uint32_t compileAll(const std::vector<ShaderCompileRequest>& requests);
+
+        //Every shader stage file under the source root.
+        std::vector<ShaderCompileRequest> findSources() const;
+        //The stage files that are, or include, the given file. Takes the
+        //full path, as a file watcher reports it.
+        std::vector<ShaderCompileRequest> findDependents(const std::string& filePath) const;
+        //False if built without shaderc or there's no source tree.
+        bool canCompile() const { return _canCompile; }
+
+        ShaderCompilerStats getStats() const;
+
+        static bool readSpirv(const std::string& filePath, std::vector<uint32_t>& spirv);
+        static bool isShaderSource(const std::filesystem::path& filePath);
+        //Where an include resolves to. Quoted includes look next to the file
+        //doing the including first, both then look in the source root.
+        static bool resolveInclude(const std::filesystem::path& sourceRoot, const std::filesystem::path& requestingFile,
+                                   const std::string& requested, bool relative, std::filesystem::path& resolved);
+    private:
+        //Hashes the file and everything it includes, in the order they're
+        //first included.
+        bool hashSources(const std::filesystem::path& filePath, std::unordered_set<std::string>& visited, uint64_t& hash) const;
+        uint64_t makeKey(const ShaderCompileRequest& request, bool& sourcesFound) const;
+        std::filesystem::path cachePath(uint64_t key) const;
+        //Relative to the source root, empty if there's nothing to compile.
+        std::filesystem::path sourcePathFor(const std::string& spirvPath) const;
+        bool compileSource(const ShaderCompileRequest& request, std::vector<uint32_t>& spirv);
+    private:
+        std::filesystem::path _sourceRoot;
+        std::filesystem::path _cacheDirectory;
+        bool _canCompile = false;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _compiled;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> _spirv;
+        //Keys being compiled right now, so two pipelines sharing a shader
+        //wait on one compile instead of both doing it.
+        std::unordered_set<uint64_t> _compiling;
+        ShaderCompilerStats _stats;
+    };
+}
+
+#endif // !SHADER_COMPILER_HDR
@@ -0,0 +1,608 @@
+#include "PreComp.h"
+#include "ShaderReflection.h"
+
+#include <spirv-headers/spirv.hpp>
+#include <cstring>
+
+namespace
+{
+    struct SpirvType
+    {
+        spv::Op op = spv::OpNop;
+        //Int and float.
+        uint32_t width = 0;
+        bool isSigned = false;
+        //The element of a vector, matrix or array, what a pointer points
+        //to, or the image in a sampled image.
+        uint32_t elementType = 0;
+        //Vector components or matrix columns.
+        uint32_t elementCount = 0;
+        uint32_t lengthId = 0;
+        spv::StorageClass storageClass = spv::StorageClassMax;
+        spv::Dim dim = spv::DimMax;
+        uint32_t sampled = 0;
+        std::vector<uint32_t> members;
+    };
+
+    struct SpirvDecorations
+    {
+        bool hasSet = false;
+        bool hasBinding = false;
+        bool hasLocation = false;
+        bool hasSpecId = false;
+        uint32_t set = 0;
+        uint32_t binding = 0;
+        uint32_t location = 0;
+        uint32_t specId = 0;
+        bool block = false;
+        bool bufferBlock = false;
+        bool builtIn = false;
+        uint32_t arrayStride = 0;
+        std::vector<uint32_t> memberOffsets;
+        std::vector<uint32_t> memberMatrixStrides;
+        bool memberBuiltIn = false;
+    };
+
+    struct SpirvVariable
+    {
+        uint32_t id;
+        uint32_t typeId;
+        spv::StorageClass storageClass;
+    };
+
+    struct SpirvSpecConstant
+    {
+        uint32_t id;
+        bool isBool;
+    };
+
+    struct SpirvModule
+    {
+        spv::ExecutionModel executionModel = spv::ExecutionModelMax;
+        std::unordered_map<uint32_t, SpirvType> types;
+        std::unordered_map<uint32_t, SpirvDecorations> decorations;
+        //Only the low word, which is all array lengths ever need.
+        std::unordered_map<uint32_t, uint32_t> constants;
+        std::vector<SpirvVariable> variables;
+        std::vector<SpirvSpecConstant> specConstants;
+        std::unordered_map<uint32_t, std::string> names;
+
+        const SpirvType& type(uint32_t id) const
+        {
+            static const SpirvType unknown;
+            auto found = types.find(id);
+            return found != types.end() ? found->second : unknown;
+        }
+
+        const SpirvDecorations& decoration(uint32_t id) const
+        {
+            static const SpirvDecorations none;
+            auto found = decorations.find(id);
+            return found != decorations.end() ? found->second : none;
+        }
+    };
+
+    void setMember(std::vector<uint32_t>& values, uint32_t member, uint32_t value)
+    {
+        if (values.size() <= member)
+        {
+            values.resize(member + 1, 0);
+        }
+        values[member] = value;
+    }
+
+    bool parse(const std::vector<uint32_t>& spirv, SpirvModule& module)
+    {
+        if (spirv.size() < 5 || spirv[0] != spv::MagicNumber)
+        {
+            return false;
+        }
+
+        size_t position = 5;
+        while (position < spirv.size())
+        {
+            uint32_t wordCount = spirv[position] >> 16;
+            spv::Op op = static_cast<spv::Op>(spirv[position] & 0xFFFF);
+            if (wordCount == 0 || position + wordCount > spirv.size())
+            {
+                return false;
+            }
+            const uint32_t* words = &spirv[position];
+            position += wordCount;
+
+            switch (op)
+            {
+            case spv::OpEntryPoint:
+                if (module.executionModel == spv::ExecutionModelMax)
+                {
+                    module.executionModel = static_cast<spv::ExecutionModel>(words[1]);
+                }
+                break;
+            case spv::OpDecorate:
+            {
+                if (wordCount < 3)
+                {
+                    break;
+                }
+                SpirvDecorations& decorations = module.decorations[words[1]];
+                uint32_t literal = wordCount > 3 ? words[3] : 0;
+                switch (static_cast<spv::Decoration>(words[2]))
+                {
+                case spv::DecorationDescriptorSet: decorations.hasSet = true; decorations.set = literal; break;
+                case spv::DecorationBinding: decorations.hasBinding = true; decorations.binding = literal; break;
+                case spv::DecorationLocation: decorations.hasLocation = true; decorations.location = literal; break;
+                case spv::DecorationSpecId: decorations.hasSpecId = true; decorations.specId = literal; break;
+                case spv::DecorationBlock: decorations.block = true; break;
+                case spv::DecorationBufferBlock: decorations.bufferBlock = true; break;
+                case spv::DecorationBuiltIn: decorations.builtIn = true; break;
+                case spv::DecorationArrayStride: decorations.arrayStride = literal; break;
+                default: break;
+                }
+                break;
+            }
+            case spv::OpMemberDecorate:
+            {
+                if (wordCount < 4)
+                {
+                    break;
+                }
+                SpirvDecorations& decorations = module.decorations[words[1]];
+                uint32_t literal = wordCount > 4 ? words[4] : 0;
+                switch (static_cast<spv::Decoration>(words[3]))
+                {
+                case spv::DecorationOffset: setMember(decorations.memberOffsets, words[2], literal); break;
+                case spv::DecorationMatrixStride: setMember(decorations.memberMatrixStrides, words[2], literal); break;
+                case spv::DecorationBuiltIn: decorations.memberBuiltIn = true; break;
+                default: break;
+                }
+                break;
+            }
+            case spv::OpTypeInt:
+            {
+                SpirvType& type = module.types[words[1]];
+                type.op = op;
+                type.width = words[2];
+                type.isSigned = words[3] != 0;
+                break;
+            }
+            case spv::OpTypeFloat:
+            {
+                SpirvType& type = module.types[words[1]];
+                type.op = op;
+                type.width = words[2];
+                break;
+            }
+            case spv::OpTypeVector:
+            case spv::OpTypeMatrix:
+            {
+                SpirvType& type = module.types[words[1]];
+                type.op = op;
+                type.elementType = words[2];
+                type.elementCount = words[3];
+                break;
+            }
+            case spv::OpTypeImage:
+            {
+                SpirvType& type = module.types[words[1]];
+                type.op = op;
+                type.dim = static_cast<spv::Dim>(words[3]);
+                type.sampled = words[7];
+                break;
+            }
+            case spv::OpTypeSampledImage:
+            {
+                SpirvType& type = module.types[words[1]];
+                type.op = op;
+                type.elementType = words[2];
+                break;
+            }
+            case spv::OpTypeArray:
+            {
+                SpirvType& type = module.types[words[1]];
+                type.op = op;
+                type.elementType = words[2];
+                type.lengthId = words[3];
+                break;
+            }
+            case spv::OpTypeRuntimeArray:
+            {
+                SpirvType& type = module.types[words[1]];
+                type.op = op;
+                type.elementType = words[2];
+                break;
+            }
+            case spv::OpTypeStruct:
+            {
+                SpirvType& type = module.types[words[1]];
+                type.op = op;
+                type.members.assign(words + 2, words + wordCount);
+                break;
+            }
+            case spv::OpTypePointer:
+            {
+                SpirvType& type = module.types[words[1]];
+                type.op = op;
+                type.storageClass = static_cast<spv::StorageClass>(words[2]);
+                type.elementType = words[3];
+                break;
+            }
+            case spv::OpTypeSampler:
+            case spv::OpTypeAccelerationStructureKHR:
+                module.types[words[1]].op = op;
+                break;
+            case spv::OpName:
+                if (wordCount > 2)
+                {
+                    //A nul terminated string packed into the words.
+                    const char* name = reinterpret_cast<const char*>(words + 2);
+                    module.names[words[1]] = std::string(name, strnlen(name, (wordCount - 2) * sizeof(uint32_t)));
+                }
+                break;
+            case spv::OpConstant:
+                if (wordCount > 3)
+                {
+                    module.constants[words[2]] = words[3];
+                }
+                break;
+            case spv::OpSpecConstant:
+                if (wordCount > 3)
+                {
+                    module.constants[words[2]] = words[3];
+                    module.specConstants.push_back({ words[2], false });
+                }
+                break;
+            case spv::OpSpecConstantTrue:
+            case spv::OpSpecConstantFalse:
+                module.specConstants.push_back({ words[2], true });
+                break;
+            case spv::OpVariable:
+                module.variables.push_back({ words[2], words[1], static_cast<spv::StorageClass>(words[3]) });
+                break;
+            case spv::OpFunction:
+                //Everything we care about is declared before the first function.
+                return true;
+            default:
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    uint32_t typeSize(const SpirvModule& module, uint32_t typeId, uint32_t matrixStride = 0)
+    {
+        const SpirvType& type = module.type(typeId);
+        switch (type.op)
+        {
+        case spv::OpTypeInt:
+        case spv::OpTypeFloat:
+            return type.width / 8;
+        case spv::OpTypeVector:
+            return type.elementCount * typeSize(module, type.elementType);
+        case spv::OpTypeMatrix:
+            return type.elementCount * (matrixStride > 0 ? matrixStride : typeSize(module, type.elementType));
+        case spv::OpTypeArray:
+        {
+            uint32_t stride = module.decoration(typeId).arrayStride;
+            auto length = module.constants.find(type.lengthId);
+            uint32_t count = length != module.constants.end() ? length->second : 0;
+            return count * (stride > 0 ? stride : typeSize(module, type.elementType));
+        }
+        case spv::OpTypeStruct:
+        {
+            const SpirvDecorations& decorations = module.decoration(typeId);
+            uint32_t size = 0;
+            for (uint32_t i = 0; i < type.members.size(); i++)
+            {
+                uint32_t offset = i < decorations.memberOffsets.size() ? decorations.memberOffsets[i] : 0;
+                uint32_t stride = i < decorations.memberMatrixStrides.size() ? decorations.memberMatrixStrides[i] : 0;
+                size = std::max(size, offset + typeSize(module, type.members[i], stride));
+            }
+            return size;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    VkDescriptorType descriptorType(const SpirvModule& module, spv::StorageClass storageClass, uint32_t typeId)
+    {
+        const SpirvType& type = module.type(typeId);
+        switch (storageClass)
+        {
+        case spv::StorageClassUniform:
+            if (module.decoration(typeId).bufferBlock)
+            {
+                return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            }
+            return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        case spv::StorageClassStorageBuffer:
+            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        case spv::StorageClassUniformConstant:
+            switch (type.op)
+            {
+            case spv::OpTypeSampledImage:
+                return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            case spv::OpTypeSampler:
+                return VK_DESCRIPTOR_TYPE_SAMPLER;
+            case spv::OpTypeAccelerationStructureKHR:
+                return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+            case spv::OpTypeImage:
+                //Sampled is 2 for images that are read and written.
+                if (type.dim == spv::DimBuffer)
+                {
+                    return type.sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+                }
+                if (type.dim == spv::DimSubpassData)
+                {
+                    return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                }
+                return type.sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            default:
+                return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+            }
+        default:
+            return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        }
+    }
+
+    VkFormat vertexFormat(const SpirvModule& module, uint32_t typeId)
+    {
+        const SpirvType* type = &module.type(typeId);
+        uint32_t components = 1;
+        if (type->op == spv::OpTypeVector)
+        {
+            components = type->elementCount;
+            type = &module.type(type->elementType);
+        }
+
+        if (type->width != 32 || components < 1 || components > 4)
+        {
+            return VK_FORMAT_UNDEFINED;
+        }
+
+        static const VkFormat floats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+        static const VkFormat signedInts[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+        static const VkFormat unsignedInts[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+        if (type->op == spv::OpTypeFloat)
+        {
+            return floats[components - 1];
+        }
+        if (type->op == spv::OpTypeInt)
+        {
+            return type->isSigned ? signedInts[components - 1] : unsignedInts[components - 1];
+        }
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    //Only the formats vertexFormat can hand back.
+    uint32_t vertexFormatSize(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_R32_SFLOAT:
+        case VK_FORMAT_R32_SINT:
+        case VK_FORMAT_R32_UINT:
+            return 4;
+        case VK_FORMAT_R32G32_SFLOAT:
+        case VK_FORMAT_R32G32_SINT:
+        case VK_FORMAT_R32G32_UINT:
+            return 8;
+        case VK_FORMAT_R32G32B32_SFLOAT:
+        case VK_FORMAT_R32G32B32_SINT:
+        case VK_FORMAT_R32G32B32_UINT:
+            return 12;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+        case VK_FORMAT_R32G32B32A32_SINT:
+        case VK_FORMAT_R32G32B32A32_UINT:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    bool shaderStage(spv::ExecutionModel executionModel, VkShaderStageFlagBits& stage)
+    {
+        switch (executionModel)
+        {
+        case spv::ExecutionModelVertex: stage = VK_SHADER_STAGE_VERTEX_BIT; return true;
+        case spv::ExecutionModelTessellationControl: stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT; return true;
+        case spv::ExecutionModelTessellationEvaluation: stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT; return true;
+        case spv::ExecutionModelGeometry: stage = VK_SHADER_STAGE_GEOMETRY_BIT; return true;
+        case spv::ExecutionModelFragment: stage = VK_SHADER_STAGE_FRAGMENT_BIT; return true;
+        case spv::ExecutionModelGLCompute: stage = VK_SHADER_STAGE_COMPUTE_BIT; return true;
+        default: return false;
+        }
+    }
+}
+
+namespace Gust
+{
+    bool ShaderReflector::reflect(const std::vector<uint32_t>& spirv, ShaderReflection& reflection)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        SpirvModule module;
+        if (parse(spirv, module) == false)
+        {
+            GUST_ERROR("Can't reflect a broken SPIR-V module.");
+            return false;
+        }
+
+        reflection = ShaderReflection();
+        if (shaderStage(module.executionModel, reflection.stage) == false)
+        {
+            GUST_ERROR("Can't reflect SPIR-V with execution model {0}.", static_cast<uint32_t>(module.executionModel));
+            return false;
+        }
+
+        for (const SpirvVariable& variable : module.variables)
+        {
+            const SpirvType& pointer = module.type(variable.typeId);
+            const SpirvDecorations& decorations = module.decoration(variable.id);
+
+            if (variable.storageClass == spv::StorageClassPushConstant)
+            {
+                const SpirvDecorations& block = module.decoration(pointer.elementType);
+                uint32_t offset = block.memberOffsets.empty() ? 0 : *std::min_element(block.memberOffsets.begin(), block.memberOffsets.end());
+                reflection.pushConstantOffset = offset;
+                reflection.pushConstantSize = typeSize(module, pointer.elementType) - offset;
+                continue;
+            }
+
+            if (variable.storageClass == spv::StorageClassInput)
+            {
+                if (reflection.stage != VK_SHADER_STAGE_VERTEX_BIT || decorations.builtIn || decorations.hasLocation == false ||
+                    module.decoration(pointer.elementType).memberBuiltIn)
+                {
+                    continue;
+                }
+
+                VkVertexInputAttributeDescription attribute{};
+                attribute.location = decorations.location;
+                attribute.binding = 0;
+                attribute.format = vertexFormat(module, pointer.elementType);
+                if (attribute.format == VK_FORMAT_UNDEFINED)
+                {
+                    GUST_WARN("Vertex input at location {0} isn't a 32 bit scalar or vector, it's been left out.", attribute.location);
+                    continue;
+                }
+                reflection.vertexInputs.push_back(attribute);
+                continue;
+            }
+
+            if (decorations.hasBinding == false)
+            {
+                continue;
+            }
+
+            //Peel arrays of descriptors off down to the resource itself.
+            uint32_t typeId = pointer.elementType;
+            uint32_t count = 1;
+            while (module.type(typeId).op == spv::OpTypeArray || module.type(typeId).op == spv::OpTypeRuntimeArray)
+            {
+                const SpirvType& array = module.type(typeId);
+                if (array.op == spv::OpTypeArray)
+                {
+                    auto length = module.constants.find(array.lengthId);
+                    count *= length != module.constants.end() ? length->second : 1;
+                }
+                else
+                {
+                    count = 0;
+                }
+                typeId = array.elementType;
+            }
+
+            ReflectedBinding binding;
+            binding.set = decorations.set;
+            binding.binding = decorations.binding;
+            binding.type = descriptorType(module, variable.storageClass, typeId);
+            binding.count = count;
+            if (binding.type == VK_DESCRIPTOR_TYPE_MAX_ENUM)
+            {
+                GUST_WARN("Set {0} binding {1} has a type we can't reflect, it's been left out.", binding.set, binding.binding);
+                continue;
+            }
+            reflection.bindings.push_back(binding);
+        }
+
+        for (const SpirvSpecConstant& constant : module.specConstants)
+        {
+            const SpirvDecorations& decorations = module.decoration(constant.id);
+            if (decorations.hasSpecId == false)
+            {
+                continue;
+            }
+
+            ReflectedSpecialization specialization;
+            specialization.constantId = decorations.specId;
+            auto name = module.names.find(constant.id);
+            if (name != module.names.end())
+            {
+                specialization.name = name->second;
+            }
+            specialization.isBool = constant.isBool;
+            reflection.specializations.push_back(specialization);
+        }
+
+        std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(),
+                  [](const VkVertexInputAttributeDescription& a, const VkVertexInputAttributeDescription& b) { return a.location < b.location; });
+
+        return true;
+    }
+
+    bool ShaderReflector::merge(const std::vector<ShaderReflection>& stages, ShaderLayout& layout)
+    {
+        layout = ShaderLayout();
+
+        for (const ShaderReflection& stage : stages)
+        {
+            for (const ReflectedBinding& binding : stage.bindings)
+            {
+                if (layout.sets.size() <= binding.set)
+                {
+                    layout.sets.resize(binding.set + 1);
+                }
+
+                auto& set = layout.sets[binding.set];
+                auto existing = std::find_if(set.begin(), set.end(), [&binding](const VkDescriptorSetLayoutBinding& other) { return other.binding == binding.binding; });
+                if (existing != set.end())
+                {
+                    if (existing->descriptorType != binding.type || existing->descriptorCount != binding.count)
+                    {
+                        GUST_ERROR("Shader stages disagree about set {0} binding {1}.", binding.set, binding.binding);
+                        return false;
+                    }
+                    existing->stageFlags |= stage.stage;
+                    continue;
+                }
+
+                VkDescriptorSetLayoutBinding layoutBinding{};
+                layoutBinding.binding = binding.binding;
+                layoutBinding.descriptorType = binding.type;
+                layoutBinding.descriptorCount = binding.count;
+                layoutBinding.stageFlags = stage.stage;
+                layoutBinding.pImmutableSamplers = nullptr;
+                set.push_back(layoutBinding);
+            }
+
+            //One range covering every stage's block is always valid, and
+            //means the push only has to name the stages once.
+            if (stage.pushConstantSize > 0)
+            {
+                if (layout.pushConstants.empty())
+                {
+                    layout.pushConstants.push_back({ static_cast<VkShaderStageFlags>(stage.stage), stage.pushConstantOffset, stage.pushConstantSize });
+                }
+                else
+                {
+                    VkPushConstantRange& range = layout.pushConstants[0];
+                    uint32_t end = std::max(range.offset + range.size, stage.pushConstantOffset + stage.pushConstantSize);
+                    range.offset = std::min(range.offset, stage.pushConstantOffset);
+                    range.size = end - range.offset;
+                    range.stageFlags |= stage.stage;
+                }
+            }
+
+            if (stage.vertexInputs.empty() == false)
+            {
+                layout.vertexAttributes = stage.vertexInputs;
+            }
+        }
+
+        for (auto& set : layout.sets)
+        {
+            std::sort(set.begin(), set.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+        }
+
+        for (auto& attribute : layout.vertexAttributes)
+        {
+            attribute.offset = layout.vertexStride;
+            layout.vertexStride += vertexFormatSize(attribute.format);
+        }
+
+        return true;
+    }
+}
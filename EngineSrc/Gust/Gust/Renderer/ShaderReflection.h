@@ -0,0 +1,65 @@
+#ifndef SHADER_REFLECTION_HDR
+#define SHADER_REFLECTION_HDR
+
+#include "PreComp.h"
+
+#include <vulkan/vulkan.h>
+
+namespace Gust
+{
+    struct ReflectedBinding
+    {
+        uint32_t set = 0;
+        uint32_t binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        //Zero for a runtime sized array.
+        uint32_t count = 1;
+    };
+
+    struct ReflectedSpecialization
+    {
+        uint32_t constantId = 0;
+        //Empty if the module was stripped of names.
+        std::string name;
+        bool isBool = false;
+    };
+
+    //What one SPIR-V module needs from the pipeline layout and vertex input.
+    struct ShaderReflection
+    {
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL;
+        std::vector<ReflectedBinding> bindings;
+        //Both zero if the shader has no push constants.
+        uint32_t pushConstantOffset = 0;
+        uint32_t pushConstantSize = 0;
+        //Vertex shaders only, in location order.
+        std::vector<VkVertexInputAttributeDescription> vertexInputs;
+        std::vector<ReflectedSpecialization> specializations;
+    };
+
+    //The stages of one pipeline merged together, ready to build the layouts
+    //from.
+    struct ShaderLayout
+    {
+        //Indexed by set number, each sorted by binding.
+        std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+        std::vector<VkPushConstantRange> pushConstants;
+        //Tightly packed in location order into a single binding.
+        std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+        uint32_t vertexStride = 0;
+    };
+
+    //Reads the bindings, push constants and vertex inputs straight out of
+    //SPIR-V, so the layouts always match the shaders without anyone writing
+    //them out by hand. Uniform buffers come back dynamic as all our uniforms
+    //are suballocated from the per frame buffer.
+    class ShaderReflector
+    {
+    public:
+        static bool reflect(const std::vector<uint32_t>& spirv, ShaderReflection& reflection);
+        //False if two stages disagree about what's in a binding.
+        static bool merge(const std::vector<ShaderReflection>& stages, ShaderLayout& layout);
+    };
+}
+
+#endif // !SHADER_REFLECTION_HDR
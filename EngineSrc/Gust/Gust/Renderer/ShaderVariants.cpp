@@ -0,0 +1,241 @@
+#include "PreComp.h"
+#include "ShaderVariants.h"
+#include "ShaderCompiler.h"
+#include "ShaderReflection.h"
+
+namespace
+{
+    //The names from every "#pragma option NAME" line. Unknown pragmas are
+    //ignored by the GLSL compiler so these cost nothing there.
+    std::vector<std::string> findDefineOptions(const std::string& source)
+    {
+        std::vector<std::string> options;
+
+        std::istringstream lines(source);
+        std::string line;
+        while (std::getline(lines, line))
+        {
+            std::istringstream words(line);
+            std::string pragma;
+            std::string option;
+            std::string name;
+            if ((words >> pragma >> option >> name) && pragma == "#pragma" && option == "option")
+            {
+                options.push_back(name);
+            }
+        }
+
+        return options;
+    }
+}
+
+namespace Gust
+{
+    ShaderVariants::ShaderVariants(ShaderCompiler& compiler) :
+        _compiler(compiler)
+    {
+    }
+
+    VariantKey ShaderVariants::optionBit(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return optionBitLocked(name);
+    }
+
+    void ShaderVariants::registerSpecialisation(const std::string& name, uint32_t constantId)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _specialisationNames[constantId] = name;
+        optionBitLocked(name);
+    }
+
+    VariantKey ShaderVariants::normalise(const std::string& spirvPath, VariantKey key)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return key & getInfo(spirvPath).mask;
+    }
+
+    bool ShaderVariants::load(const std::string& spirvPath, VariantKey key, ShaderVariant& variant)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        VariantKey defineKey = 0;
+        uint64_t generation = 0;
+        std::vector<ShaderDefine> defines;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ShaderInfo& info = getInfo(spirvPath);
+            generation = info.generation;
+            key &= info.mask;
+            defineKey = key & info.defineMask;
+
+            variant = ShaderVariant();
+            for (const ShaderOption& option : info.options)
+            {
+                if (option.kind == ShaderOptionKind::SPECIALISATION)
+                {
+                    VkSpecializationMapEntry entry{};
+                    entry.constantID = option.constantId;
+                    entry.offset = static_cast<uint32_t>(variant.specialisationData.size() * sizeof(VkBool32));
+                    entry.size = sizeof(VkBool32);
+                    variant.specialisationEntries.push_back(entry);
+                    variant.specialisationData.push_back((key & option.bit) != 0 ? VK_TRUE : VK_FALSE);
+                }
+                else if ((defineKey & option.bit) != 0)
+                {
+                    defines.push_back({ option.name, "1" });
+                }
+            }
+
+            if (info.live.insert(key).second)
+            {
+                _stats.liveVariants++;
+            }
+
+            auto module = info.modules.find(defineKey);
+            if (module != info.modules.end())
+            {
+                variant.spirv = module->second;
+                return true;
+            }
+        }
+
+        //Compiled outside the lock so other shaders' variants aren't held
+        //up. The compiler makes sure the same one is never built twice.
+        std::vector<uint32_t> spirv;
+        if (_compiler.load(spirvPath, defines, spirv) == false)
+        {
+            GUST_ERROR("Failed to build variant {0:x} of {1}", key, spirvPath);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        ShaderInfo& info = getInfo(spirvPath);
+        if (info.generation != generation)
+        {
+            //Reloaded while it compiled. Whoever asked still gets it, the
+            //pipeline it goes into is rebuilt anyway.
+            variant.spirv = std::make_shared<const std::vector<uint32_t>>(std::move(spirv));
+            return true;
+        }
+
+        auto [module, inserted] = info.modules.emplace(defineKey, std::make_shared<const std::vector<uint32_t>>(std::move(spirv)));
+        if (inserted)
+        {
+            _stats.modules++;
+        }
+        variant.spirv = module->second;
+        return true;
+    }
+
+    void ShaderVariants::invalidate(const std::string& spirvPath)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto found = _shaders.find(spirvPath);
+        if (found == _shaders.end())
+        {
+            return;
+        }
+
+        _stats.shaders--;
+        _stats.liveVariants -= static_cast<uint32_t>(found->second.live.size());
+        _stats.modules -= static_cast<uint32_t>(found->second.modules.size());
+        _shaders.erase(found);
+    }
+
+    ShaderVariantStats ShaderVariants::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    //The first look at a shader reads its source and reflects its base
+    //module. That happens under the lock, but the start up compile means the
+    //base module is almost always already in the compiler's cache.
+    ShaderVariants::ShaderInfo& ShaderVariants::getInfo(const std::string& spirvPath)
+    {
+        ShaderInfo& info = _shaders[spirvPath];
+        if (info.loaded)
+        {
+            return info;
+        }
+        info.loaded = true;
+        info.generation = ++_generation;
+        _stats.shaders++;
+
+        //Without the source only the specialisation options are usable.
+        std::string source;
+        if (_compiler.readSource(spirvPath, source))
+        {
+            for (const std::string& name : findDefineOptions(source))
+            {
+                ShaderOption option;
+                option.name = name;
+                option.kind = ShaderOptionKind::DEFINE;
+                option.bit = optionBitLocked(name);
+                info.options.push_back(option);
+            }
+        }
+
+        std::vector<uint32_t> spirv;
+        ShaderReflection reflection;
+        if (_compiler.load(spirvPath, {}, spirv) && ShaderReflector::reflect(spirv, reflection))
+        {
+            for (const ReflectedSpecialization& specialisation : reflection.specializations)
+            {
+                if (specialisation.isBool == false)
+                {
+                    continue;
+                }
+
+                auto registered = _specialisationNames.find(specialisation.constantId);
+                std::string name = registered != _specialisationNames.end() ? registered->second : specialisation.name;
+                if (name.empty())
+                {
+                    GUST_WARN("{0} has an unregistered specialisation constant {1}, it can't be an option.", spirvPath, specialisation.constantId);
+                    continue;
+                }
+
+                ShaderOption option;
+                option.name = name;
+                option.kind = ShaderOptionKind::SPECIALISATION;
+                option.constantId = specialisation.constantId;
+                option.bit = optionBitLocked(name);
+                info.options.push_back(option);
+            }
+
+            info.modules.emplace(0, std::make_shared<const std::vector<uint32_t>>(std::move(spirv)));
+            _stats.modules++;
+        }
+
+        for (const ShaderOption& option : info.options)
+        {
+            info.mask |= option.bit;
+            if (option.kind == ShaderOptionKind::DEFINE)
+            {
+                info.defineMask |= option.bit;
+            }
+        }
+
+        return info;
+    }
+
+    VariantKey ShaderVariants::optionBitLocked(const std::string& name)
+    {
+        auto found = _optionBits.find(name);
+        if (found != _optionBits.end())
+        {
+            return found->second;
+        }
+
+        if (_optionBits.size() >= 64)
+        {
+            GUST_ERROR("Out of shader option bits, {0} will always be off.", name);
+            return 0;
+        }
+
+        VariantKey bit = VariantKey(1) << _optionBits.size();
+        _optionBits[name] = bit;
+        return bit;
+    }
+}
@@ -0,0 +1,115 @@
+#ifndef SHADER_VARIANTS_HDR
+#define SHADER_VARIANTS_HDR
+
+#include "PreComp.h"
+
+#include <vulkan/vulkan.h>
+#include <mutex>
+
+namespace Gust
+{
+    class ShaderCompiler;
+
+    //One bit per option, see ShaderVariants::optionBit.
+    using VariantKey = uint64_t;
+
+    enum class ShaderOptionKind
+    {
+        //Compiled in with a define, a separate SPIR-V module per combination.
+        DEFINE,
+        //A bool specialisation constant, the same module specialised when
+        //the pipeline is created.
+        SPECIALISATION
+    };
+
+    struct ShaderOption
+    {
+        std::string name;
+        ShaderOptionKind kind = ShaderOptionKind::DEFINE;
+        uint32_t constantId = 0;
+        VariantKey bit = 0;
+    };
+
+    //Everything needed to make the shader stage for one variant.
+    struct ShaderVariant
+    {
+        std::shared_ptr<const std::vector<uint32_t>> spirv;
+        std::vector<VkSpecializationMapEntry> specialisationEntries;
+        std::vector<VkBool32> specialisationData;
+    };
+
+    struct ShaderVariantStats
+    {
+        uint32_t shaders = 0;
+        //Distinct shader and key pairs that have been asked for.
+        uint32_t liveVariants = 0;
+        //How many of those needed a module of their own.
+        uint32_t modules = 0;
+    };
+
+    //Lets one shader file stand in for all its variants. Shaders declare
+    //their own options. A define option is a line in the GLSL like
+    //"#pragma option ALPHA_TEST". A specialisation option is a bool
+    //constant like "layout(constant_id = 0) const bool ALPHA_TEST = false;",
+    //found by reflecting the SPIR-V. Option names map to the same bit for
+    //every shader, so one key describes a whole pipeline and each stage
+    //ignores the bits it didn't declare. Variants are only built the first
+    //time something asks for them. Safe to use from any thread.
+    //
+    //Optimised SPIR-V has its names stripped, so constant ids are given
+    //names with registerSpecialisation and mean the same in every shader.
+    class ShaderVariants
+    {
+    public:
+        ShaderVariants(ShaderCompiler& compiler);
+        ~ShaderVariants() = default;
+
+        ShaderVariants(const ShaderVariants&) = delete;
+        ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+        //The bit for an option name, given out the first time it's seen.
+        //Zero once all 64 are taken.
+        VariantKey optionBit(const std::string& name);
+        //Before any shader using the id is loaded.
+        void registerSpecialisation(const std::string& name, uint32_t constantId);
+        //Only the bits this shader declared, so keys that differ in bits it
+        //doesn't care about share a variant.
+        VariantKey normalise(const std::string& spirvPath, VariantKey key);
+
+        bool load(const std::string& spirvPath, VariantKey key, ShaderVariant& variant);
+        //Forgets a shader whose source changed so the next load reads its
+        //options and modules again. Variants already handed out stay valid.
+        void invalidate(const std::string& spirvPath);
+
+        ShaderVariantStats getStats() const;
+    private:
+        struct ShaderInfo
+        {
+            bool loaded = false;
+            //Which load of the shader this is, so a module compiled from
+            //the old source isn't cached after an invalidate.
+            uint64_t generation = 0;
+            std::vector<ShaderOption> options;
+            VariantKey mask = 0;
+            VariantKey defineMask = 0;
+            //Keyed by the define bits only.
+            std::unordered_map<VariantKey, std::shared_ptr<const std::vector<uint32_t>>> modules;
+            std::unordered_set<VariantKey> live;
+        };
+
+        //Call with _mutex held.
+        ShaderInfo& getInfo(const std::string& spirvPath);
+        VariantKey optionBitLocked(const std::string& name);
+    private:
+        ShaderCompiler& _compiler;
+
+        mutable std::mutex _mutex;
+        std::unordered_map<std::string, VariantKey> _optionBits;
+        std::unordered_map<uint32_t, std::string> _specialisationNames;
+        std::unordered_map<std::string, ShaderInfo> _shaders;
+        uint64_t _generation = 0;
+        ShaderVariantStats _stats;
+    };
+}
+
+#endif // !SHADER_VARIANTS_HDR
@@ -0,0 +1,430 @@
+#include "PreComp.h"
+#include "StagingRing.h"
+
+#include "Gust/Core/Core.h"
+
+namespace
+{
+    //Covers texel and block sizes of every format we upload.
+    const VkDeviceSize STAGING_ALIGNMENT = 16;
+
+    //What the consuming queue may do with an upload once it owns it.
+    const VkPipelineStageFlags CONSUMER_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    const VkAccessFlags CONSUMER_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+    VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+namespace Gust
+{
+    StagingRing::StagingRing(VkDevice device, VmaAllocator allocator, VkQueue queue, uint32_t queueFamily, uint32_t consumerFamily, VkDeviceSize capacity) :
+        _device(device), _allocator(allocator), _queue(queue), _queueFamily(queueFamily), _consumerFamily(consumerFamily), _capacity(capacity)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = queueFamily;
+
+        VkResult result = vkCreateCommandPool(_device, &poolInfo, nullptr, &_commandPool);
+        GUST_CORE_ASSERT("Failed to create the staging command pool.", result != VK_SUCCESS);
+
+        VkSemaphoreTypeCreateInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        timelineInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &timelineInfo;
+
+        result = vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &_timeline);
+        GUST_CORE_ASSERT("Failed to create the staging timeline semaphore.", result != VK_SUCCESS);
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = _capacity;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VmaAllocationCreateInfo allocationCreateInfo{};
+        allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+        VmaAllocationInfo allocationInfo{};
+        result = vmaCreateBuffer(_allocator, &bufferInfo, &allocationCreateInfo, &_buffer, &_allocation, &allocationInfo);
+        GUST_CORE_ASSERT("Failed to create the staging ring.", result != VK_SUCCESS);
+        _mapped = static_cast<uint8_t*>(allocationInfo.pMappedData);
+    }
+
+    StagingRing::~StagingRing()
+    {
+        GUST_PROFILE_FUNCTION();
+
+        flush();
+        waitIdle();
+
+        vkDestroySemaphore(_device, _timeline, nullptr);
+        vkDestroyCommandPool(_device, _commandPool, nullptr);
+        vmaDestroyBuffer(_allocator, _buffer, _allocation);
+    }
+
+    void StagingRing::uploadBuffer(VkBuffer destination, const void* data, VkDeviceSize size, VkDeviceSize destinationOffset, bool concurrent)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        VkBuffer source;
+        VkDeviceSize sourceOffset;
+        stage(data, size, source, sourceOffset);
+
+        VkBufferCopy region{};
+        region.srcOffset = sourceOffset;
+        region.dstOffset = destinationOffset;
+        region.size = size;
+        vkCmdCopyBuffer(getRecordingBatch().commandBuffer, source, destination, 1, &region);
+
+        if (transfersOwnership() && concurrent == false)
+        {
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcQueueFamilyIndex = _queueFamily;
+            barrier.dstQueueFamilyIndex = _consumerFamily;
+            barrier.buffer = destination;
+            barrier.offset = destinationOffset;
+            barrier.size = size;
+            _recordingAcquire.buffers.push_back(barrier);
+        }
+    }
+
+    void StagingRing::uploadImage(VkImage destination, uint32_t mipLevels, const void* data, VkDeviceSize size, std::vector<VkBufferImageCopy> regions)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        VkBuffer source;
+        VkDeviceSize sourceOffset;
+        stage(data, size, source, sourceOffset);
+
+        for (auto& region : regions)
+        {
+            region.bufferOffset += sourceOffset;
+        }
+
+        VkCommandBuffer commandBuffer = getRecordingBatch().commandBuffer;
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = destination;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 };
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        vkCmdCopyBufferToImage(commandBuffer, source, destination, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        if (transfersOwnership())
+        {
+            //The layout change happens as part of the ownership transfer,
+            //the upload queue may not even support fragment shaders.
+            barrier.srcQueueFamilyIndex = _queueFamily;
+            barrier.dstQueueFamilyIndex = _consumerFamily;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = 0;
+            _recordingAcquire.images.push_back(barrier);
+            return;
+        }
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    uint64_t StagingRing::flush()
+    {
+        GUST_PROFILE_FUNCTION();
+
+        releaseBatches(false);
+        if (!_recording)
+        {
+            return _submittedValue;
+        }
+
+        Batch batch = std::move(*_recording);
+        _recording.reset();
+
+        if (transfersOwnership())
+        {
+            //Release everything to the consuming family. The acquires are
+            //the same barriers with the access masks on the other side.
+            std::vector<VkBufferMemoryBarrier> bufferReleases = _recordingAcquire.buffers;
+            for (auto& release : bufferReleases)
+            {
+                release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            }
+            std::vector<VkImageMemoryBarrier> imageReleases = _recordingAcquire.images;
+            for (auto& release : imageReleases)
+            {
+                release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            }
+
+            vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                                 static_cast<uint32_t>(bufferReleases.size()), bufferReleases.data(),
+                                 static_cast<uint32_t>(imageReleases.size()), imageReleases.data());
+
+            for (auto& acquire : _recordingAcquire.buffers)
+            {
+                acquire.dstAccessMask = CONSUMER_ACCESS;
+            }
+            for (auto& acquire : _recordingAcquire.images)
+            {
+                acquire.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            }
+        }
+        else
+        {
+            //One barrier for every buffer copied in this batch. Draws
+            //submitted after this come later in submission order so it
+            //covers them.
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = CONSUMER_ACCESS;
+            vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, CONSUMER_STAGES, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
+
+        VkResult result = vkEndCommandBuffer(batch.commandBuffer);
+        GUST_CORE_ASSERT("Failed to record the staging commands.", result != VK_SUCCESS);
+
+        vmaFlushAllocation(_allocator, _allocation, 0, VK_WHOLE_SIZE);
+
+        batch.value = ++_submittedValue;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues = &batch.value;
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &batch.commandBuffer;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &_timeline;
+
+        result = vkQueueSubmit(_queue, 1, &submitInfo, VK_NULL_HANDLE);
+        GUST_CORE_ASSERT("Failed to submit the staging commands.", result != VK_SUCCESS);
+
+        if (transfersOwnership())
+        {
+            _recordingAcquire.value = batch.value;
+            _pendingAcquires.push_back(std::move(_recordingAcquire));
+            _recordingAcquire = Acquire();
+        }
+
+        batch.endOffset = _writeOffset;
+        _inFlight.push_back(std::move(batch));
+        _stats.submits++;
+
+        return _submittedValue;
+    }
+
+    void StagingRing::waitIdle()
+    {
+        while (_inFlight.empty() == false)
+        {
+            releaseBatches(true);
+        }
+    }
+
+    uint64_t StagingRing::getCompletedValue() const
+    {
+        uint64_t value = 0;
+        vkGetSemaphoreCounterValue(_device, _timeline, &value);
+        return value;
+    }
+
+    void StagingRing::wait(uint64_t value) const
+    {
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &_timeline;
+        waitInfo.pValues = &value;
+        vkWaitSemaphores(_device, &waitInfo, UINT64_MAX);
+    }
+
+    bool StagingRing::recordAcquires(VkCommandBuffer commandBuffer, uint64_t value)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        std::vector<VkBufferMemoryBarrier> buffers;
+        std::vector<VkImageMemoryBarrier> images;
+        while (_pendingAcquires.empty() == false && _pendingAcquires.front().value <= value)
+        {
+            Acquire& acquire = _pendingAcquires.front();
+            buffers.insert(buffers.end(), acquire.buffers.begin(), acquire.buffers.end());
+            images.insert(images.end(), acquire.images.begin(), acquire.images.end());
+            _pendingAcquires.pop_front();
+        }
+
+        if (buffers.empty() && images.empty())
+        {
+            return false;
+        }
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, CONSUMER_STAGES, 0, 0, nullptr,
+                             static_cast<uint32_t>(buffers.size()), buffers.data(),
+                             static_cast<uint32_t>(images.size()), images.data());
+        return true;
+    }
+
+    void StagingRing::stage(const void* data, VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset)
+    {
+        _stats.uploads++;
+        _stats.bytes += size;
+
+        if (size <= _capacity)
+        {
+            offset = reserve(size);
+            buffer = _buffer;
+            memcpy(_mapped + offset, data, static_cast<size_t>(size));
+            return;
+        }
+
+        GUST_WARN("A {0:.2f} MB upload doesn't fit the staging ring, it gets its own buffer.", size / (1024.0 * 1024.0));
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VmaAllocationCreateInfo allocationCreateInfo{};
+        allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+        VmaAllocation allocation;
+        VmaAllocationInfo allocationInfo{};
+        VkResult result = vmaCreateBuffer(_allocator, &bufferInfo, &allocationCreateInfo, &buffer, &allocation, &allocationInfo);
+        GUST_CORE_ASSERT("Failed to create an overflow staging buffer.", result != VK_SUCCESS);
+
+        memcpy(allocationInfo.pMappedData, data, static_cast<size_t>(size));
+        vmaFlushAllocation(_allocator, allocation, 0, VK_WHOLE_SIZE);
+
+        getRecordingBatch().overflowBuffers.push_back({ buffer, allocation });
+        offset = 0;
+    }
+
+    VkDeviceSize StagingRing::reserve(VkDeviceSize size)
+    {
+        for (;;)
+        {
+            VkDeviceSize position = _writeOffset % _capacity;
+            VkDeviceSize start = alignUp(position, STAGING_ALIGNMENT);
+            if (start + size > _capacity)
+            {
+                //Doesn't fit before the end so skip to the start of the ring.
+                start = _capacity;
+            }
+
+            VkDeviceSize total = start - position + size;
+            if (_writeOffset + total - _releasedOffset <= _capacity)
+            {
+                _writeOffset += total;
+                return start % _capacity;
+            }
+
+            if (_writeOffset == _releasedOffset)
+            {
+                //Nothing is in use, start again from the beginning.
+                _writeOffset = alignUp(_writeOffset, _capacity);
+                _releasedOffset = _writeOffset;
+                continue;
+            }
+
+            //Full. The oldest space has to come back before we can go on.
+            if (_inFlight.empty())
+            {
+                flush();
+            }
+            _stats.stalls++;
+            releaseBatches(true);
+        }
+    }
+
+    StagingRing::Batch& StagingRing::getRecordingBatch()
+    {
+        if (_recording)
+        {
+            return *_recording;
+        }
+
+        _recording = std::make_unique<Batch>();
+        if (_freeBatches.empty() == false)
+        {
+            *_recording = std::move(_freeBatches.back());
+            _freeBatches.pop_back();
+        }
+        else
+        {
+            VkCommandBufferAllocateInfo allocateInfo{};
+            allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocateInfo.commandPool = _commandPool;
+            allocateInfo.commandBufferCount = 1;
+            vkAllocateCommandBuffers(_device, &allocateInfo, &_recording->commandBuffer);
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        VkResult result = vkBeginCommandBuffer(_recording->commandBuffer, &beginInfo);
+        GUST_CORE_ASSERT("Failed to begin the staging commands.", result != VK_SUCCESS);
+
+        return *_recording;
+    }
+
+    //Batches finish in the order they were submitted, so the ring space is
+    //handed back from the oldest one forward.
+    void StagingRing::releaseBatches(bool wait)
+    {
+        uint64_t completedValue = getCompletedValue();
+        while (_inFlight.empty() == false)
+        {
+            Batch& batch = _inFlight.front();
+            if (batch.value > completedValue)
+            {
+                if (wait == false)
+                {
+                    break;
+                }
+                this->wait(batch.value);
+                completedValue = batch.value;
+                wait = false;
+            }
+
+            for (const auto& [buffer, allocation] : batch.overflowBuffers)
+            {
+                vmaDestroyBuffer(_allocator, buffer, allocation);
+            }
+            batch.overflowBuffers.clear();
+
+            vkResetCommandBuffer(batch.commandBuffer, 0);
+            _releasedOffset = batch.endOffset;
+
+            _freeBatches.push_back(std::move(batch));
+            _inFlight.pop_front();
+        }
+    }
+}
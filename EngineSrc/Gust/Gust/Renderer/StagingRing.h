@@ -0,0 +1,124 @@
+#ifndef STAGING_RING_HDR
+#define STAGING_RING_HDR
+
+#include "PreComp.h"
+
+#include <vulkan/vulkan.h>
+#include <vma/vk_mem_alloc.h>
+
+namespace Gust
+{
+    struct StagingStats
+    {
+        uint64_t uploads = 0;
+        uint64_t bytes = 0;
+        uint64_t submits = 0;
+        //Times the ring was full and had to wait on the GPU.
+        uint64_t stalls = 0;
+    };
+
+    //One persistently mapped upload buffer used as a ring. Uploads are copied
+    //in and their transfer commands collected into a single command buffer
+    //until flush submits them. Each submit signals the next value of a
+    //timeline semaphore and the ring only reuses space once that value has
+    //been reached, so nothing waits on the queue going idle.
+    //
+    //When the queue belongs to a different family than the one drawing with
+    //the uploads, every resource is released to that family at the end of
+    //its batch and the matching acquire is recorded by recordAcquires.
+    class StagingRing
+    {
+    public:
+        StagingRing(VkDevice device, VmaAllocator allocator, VkQueue queue, uint32_t queueFamily, uint32_t consumerFamily, VkDeviceSize capacity);
+        ~StagingRing();
+
+        StagingRing(const StagingRing&) = delete;
+        StagingRing& operator=(const StagingRing&) = delete;
+
+        //Buffers shared concurrently with the consuming family need no
+        //ownership transfer, waiting on the timeline is enough.
+        void uploadBuffer(VkBuffer destination, const void* data, VkDeviceSize size, VkDeviceSize destinationOffset = 0, bool concurrent = false);
+        //Regions' buffer offsets are relative to data. The image is moved to
+        //shader read only once the copy is done.
+        void uploadImage(VkImage destination, uint32_t mipLevels, const void* data, VkDeviceSize size, std::vector<VkBufferImageCopy> regions);
+
+        //Submits everything recorded since the last flush and returns the
+        //timeline value it signals, or the last one if there was nothing.
+        uint64_t flush();
+        //Blocks until every flushed upload has finished.
+        void waitIdle();
+
+        //Value the batch being recorded will signal. Anything uploaded now is
+        //on the GPU once the timeline reaches it.
+        uint64_t getRecordingValue() const { return _submittedValue + 1; }
+        uint64_t getCompletedValue() const;
+        void wait(uint64_t value) const;
+        VkSemaphore getTimelineSemaphore() const { return _timeline; }
+
+        //Records the ownership acquires for every flushed batch up to value
+        //into a command buffer for the consuming queue. That submit has to
+        //wait on the timeline for value. Returns false when there was
+        //nothing to acquire.
+        bool recordAcquires(VkCommandBuffer commandBuffer, uint64_t value);
+        //Resources in batches nobody has acquired yet still belong to the
+        //upload queue.
+        bool hasPendingAcquires() const { return _pendingAcquires.empty() == false; }
+        bool transfersOwnership() const { return _queueFamily != _consumerFamily; }
+
+        const StagingStats& getStats() const { return _stats; }
+    private:
+        struct Batch
+        {
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            uint64_t value = 0;
+            //Ring position once this batch's data was written.
+            VkDeviceSize endOffset = 0;
+            //Uploads too big for the ring get their own staging buffer.
+            std::vector<std::pair<VkBuffer, VmaAllocation>> overflowBuffers;
+        };
+
+        struct Acquire
+        {
+            uint64_t value = 0;
+            std::vector<VkBufferMemoryBarrier> buffers;
+            std::vector<VkImageMemoryBarrier> images;
+        };
+
+        //Returns where the data goes, either in the ring or in an overflow
+        //buffer owned by the recording batch.
+        void stage(const void* data, VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset);
+        VkDeviceSize reserve(VkDeviceSize size);
+        Batch& getRecordingBatch();
+        void releaseBatches(bool wait);
+    private:
+        VkDevice _device;
+        VmaAllocator _allocator;
+        VkQueue _queue;
+        uint32_t _queueFamily;
+        uint32_t _consumerFamily;
+        VkCommandPool _commandPool;
+
+        VkSemaphore _timeline;
+        uint64_t _submittedValue = 0;
+
+        VkBuffer _buffer;
+        VmaAllocation _allocation;
+        uint8_t* _mapped;
+        VkDeviceSize _capacity;
+        //Both only ever grow, the position in the ring is modulo capacity.
+        VkDeviceSize _writeOffset = 0;
+        VkDeviceSize _releasedOffset = 0;
+
+        std::unique_ptr<Batch> _recording;
+        std::deque<Batch> _inFlight;
+        std::vector<Batch> _freeBatches;
+        //Acquires for the batch being recorded, then one entry per flush
+        //waiting for the consumer to record them.
+        Acquire _recordingAcquire;
+        std::deque<Acquire> _pendingAcquires;
+
+        StagingStats _stats;
+    };
+}
+
+#endif // !STAGING_RING_HDR
@@ -0,0 +1,8 @@
+#include "PreComp.h"
+
+//The Vulkan Memory Allocator is header only, its implementation is compiled
+//once here.
+#include <vulkan/vulkan.h>
+
+#define VMA_IMPLEMENTATION
+#include <vma/vk_mem_alloc.h>
@@ -0,0 +1,23 @@
+#ifndef CAMERA_HDR
+#define CAMERA_HDR
+
+#include "PreComp.h"
+
+#include <glm/glm.hpp>
+
+namespace Gust
+{
+    //The engine is Z up. The defaults frame the demo model.
+    struct Camera
+    {
+        glm::vec3 position = glm::vec3(2.f, 2.f, 2.f);
+        glm::vec3 target = glm::vec3(0.f, 0.f, 0.f);
+        glm::vec3 up = glm::vec3(0.f, 0.f, 1.f);
+        //In degrees.
+        float fieldOfView = 45.f;
+        float nearPlane = 0.1f;
+        float farPlane = 10.f;
+    };
+}
+
+#endif // !CAMERA_HDR
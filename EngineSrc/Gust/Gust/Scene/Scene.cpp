@@ -0,0 +1,79 @@
+#include "PreComp.h"
+#include "Scene.h"
+
+#include "SceneFile.h"
+
+#include <cstring>
+
+namespace Gust
+{
+    uint32_t Scene::instantiate(const SceneFile& file)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        const SceneFileHeader& header = file.getHeader();
+        uint32_t firstObject = getObjectCount();
+        size_t objectCount = static_cast<size_t>(header.objects.count);
+
+        //Only the asset tables need looking up, there are far fewer of
+        //those than objects.
+        std::vector<uint32_t> meshRemap(static_cast<size_t>(header.meshes.count));
+        for (size_t i = 0; i < meshRemap.size(); i++)
+        {
+            meshRemap[i] = registerAsset(header.meshes[i].path.view(), _meshPaths, _meshLookup);
+        }
+
+        std::vector<uint32_t> materialRemap(static_cast<size_t>(header.materials.count));
+        for (size_t i = 0; i < materialRemap.size(); i++)
+        {
+            materialRemap[i] = registerAsset(header.materials[i].path.view(), _materialPaths, _materialLookup);
+        }
+
+        //One allocation per array for the whole level, never per object.
+        _transforms.resize(firstObject + objectCount);
+        _meshes.resize(firstObject + objectCount);
+        _materials.resize(firstObject + objectCount);
+        _boundsMin.resize(firstObject + objectCount);
+        _boundsMax.resize(firstObject + objectCount);
+
+        const SceneTransform* transforms = header.transforms.begin();
+        const SceneObject* objects = header.objects.begin();
+        for (size_t i = 0; i < objectCount; i++)
+        {
+            const SceneObject& object = objects[i];
+            size_t index = firstObject + i;
+
+            memcpy(&_transforms[index], transforms[object.transform].matrix, sizeof(glm::mat4));
+            _meshes[index] = meshRemap[object.mesh];
+            _materials[index] = object.material == SCENE_NO_MATERIAL ? SCENE_NO_MATERIAL : materialRemap[object.material];
+            _boundsMin[index] = glm::vec3(object.boundsMin[0], object.boundsMin[1], object.boundsMin[2]);
+            _boundsMax[index] = glm::vec3(object.boundsMax[0], object.boundsMax[1], object.boundsMax[2]);
+        }
+
+        return firstObject;
+    }
+
+    void Scene::clear()
+    {
+        _transforms.clear();
+        _meshes.clear();
+        _materials.clear();
+        _boundsMin.clear();
+        _boundsMax.clear();
+    }
+
+    uint32_t Scene::registerAsset(std::string_view path, std::vector<std::string>& paths, std::unordered_map<std::string, uint32_t>& lookup)
+    {
+        std::string key(path);
+        auto found = lookup.find(key);
+        if (found != lookup.end())
+        {
+            return found->second;
+        }
+
+        uint32_t index = static_cast<uint32_t>(paths.size());
+        paths.push_back(key);
+        lookup.emplace(std::move(key), index);
+        return index;
+    }
+}
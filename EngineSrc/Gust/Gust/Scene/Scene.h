@@ -0,0 +1,58 @@
+#ifndef SCENE_HDR
+#define SCENE_HDR
+
+#include "PreComp.h"
+
+#include "Camera.h"
+
+#include <glm/glm.hpp>
+#include <string_view>
+
+namespace Gust
+{
+    class SceneFile;
+
+    //Every object in the world, stored as parallel arrays so systems that
+    //only need one part, like culling on bounds, walk packed memory.
+    class Scene
+    {
+    public:
+        //Appends every object in the level. Returns the index of the first.
+        uint32_t instantiate(const SceneFile& file);
+        void clear();
+
+        uint32_t getObjectCount() const { return static_cast<uint32_t>(_transforms.size()); }
+
+        const std::vector<glm::mat4>& getTransforms() const { return _transforms; }
+        //Indices into the mesh and material path tables below.
+        const std::vector<uint32_t>& getMeshes() const { return _meshes; }
+        const std::vector<uint32_t>& getMaterials() const { return _materials; }
+        const std::vector<glm::vec3>& getBoundsMin() const { return _boundsMin; }
+        const std::vector<glm::vec3>& getBoundsMax() const { return _boundsMax; }
+
+        const std::vector<std::string>& getMeshPaths() const { return _meshPaths; }
+        const std::vector<std::string>& getMaterialPaths() const { return _materialPaths; }
+
+        Camera& getCamera() { return _camera; }
+        const Camera& getCamera() const { return _camera; }
+    private:
+        static uint32_t registerAsset(std::string_view path, std::vector<std::string>& paths, std::unordered_map<std::string, uint32_t>& lookup);
+    private:
+        std::vector<glm::mat4> _transforms;
+        std::vector<uint32_t> _meshes;
+        std::vector<uint32_t> _materials;
+        std::vector<glm::vec3> _boundsMin;
+        std::vector<glm::vec3> _boundsMax;
+
+        //Levels refer to assets by path. They are shared across levels so
+        //each path is only stored once.
+        std::vector<std::string> _meshPaths;
+        std::vector<std::string> _materialPaths;
+        std::unordered_map<std::string, uint32_t> _meshLookup;
+        std::unordered_map<std::string, uint32_t> _materialLookup;
+
+        Camera _camera;
+    };
+}
+
+#endif // !SCENE_HDR
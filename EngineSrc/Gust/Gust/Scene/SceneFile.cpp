@@ -0,0 +1,231 @@
+#include "PreComp.h"
+#include "SceneFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    //Checks an array lies inside the file and is aligned for its type.
+    template<typename T>
+    bool isArrayValid(const Gust::RelativeArray<T>& array, const uint8_t* base, size_t size)
+    {
+        if (array.count == 0)
+        {
+            return true;
+        }
+
+        const uint8_t* field = reinterpret_cast<const uint8_t*>(&array.data);
+        if (field < base || field + sizeof(array) > base + size)
+        {
+            return false;
+        }
+
+        int64_t target = static_cast<int64_t>(field - base) + array.data.offset;
+        if (target < 0 || static_cast<uint64_t>(target) > size || target % alignof(T) != 0)
+        {
+            return false;
+        }
+
+        return array.count <= (size - static_cast<size_t>(target)) / sizeof(T);
+    }
+
+    template<typename T>
+    void setRelative(Gust::RelativePointer<T>& pointer, const uint8_t* base, size_t target)
+    {
+        pointer.offset = static_cast<int64_t>(target) - static_cast<int64_t>(reinterpret_cast<const uint8_t*>(&pointer) - base);
+    }
+}
+
+namespace Gust
+{
+    bool SceneFile::open(const std::string& filePath)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        close();
+        if (_file.open(filePath) == false || _file.getSize() < sizeof(SceneFileHeader))
+        {
+            GUST_ERROR("Failed to open scene {0}", filePath);
+            close();
+            return false;
+        }
+
+        _header = reinterpret_cast<const SceneFileHeader*>(_file.getData());
+        if (_header->magic != SCENE_MAGIC || _header->version != SCENE_VERSION || _header->fileSize != _file.getSize())
+        {
+            GUST_ERROR("Scene {0} is out of date or truncated.", filePath);
+            close();
+            return false;
+        }
+
+        if (validate(filePath) == false)
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void SceneFile::close()
+    {
+        _header = nullptr;
+        _file.close();
+    }
+
+    //The one pass over the file at load time. Everything after this trusts
+    //the offsets and indices.
+    bool SceneFile::validate(const std::string& filePath) const
+    {
+        GUST_PROFILE_FUNCTION();
+
+        const uint8_t* base = _file.getData();
+        size_t size = _file.getSize();
+
+        if (isArrayValid(_header->transforms, base, size) == false || isArrayValid(_header->objects, base, size) == false ||
+            isArrayValid(_header->meshes, base, size) == false || isArrayValid(_header->materials, base, size) == false)
+        {
+            GUST_ERROR("Scene {0} has an array outside the file.", filePath);
+            return false;
+        }
+
+        for (const auto& reference : _header->meshes)
+        {
+            if (isArrayValid(reference.path.characters, base, size) == false)
+            {
+                GUST_ERROR("Scene {0} has a broken mesh path.", filePath);
+                return false;
+            }
+        }
+
+        for (const auto& reference : _header->materials)
+        {
+            if (isArrayValid(reference.path.characters, base, size) == false)
+            {
+                GUST_ERROR("Scene {0} has a broken material path.", filePath);
+                return false;
+            }
+        }
+
+        for (const auto& object : _header->objects)
+        {
+            if (object.transform >= _header->transforms.count || object.mesh >= _header->meshes.count ||
+                (object.material != SCENE_NO_MATERIAL && object.material >= _header->materials.count))
+            {
+                GUST_ERROR("Scene {0} has an object referencing something that isn't there.", filePath);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool SceneFile::write(const std::string& filePath, const SceneDescription& description)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        //Work out where everything goes first, then fill the image in place.
+        size_t offset = sizeof(SceneFileHeader);
+        size_t transformsOffset = alignUp(offset, SCENE_ALIGNMENT);
+        offset = transformsOffset + sizeof(SceneTransform) * description.transforms.size();
+        size_t objectsOffset = alignUp(offset, SCENE_ALIGNMENT);
+        offset = objectsOffset + sizeof(SceneObject) * description.objects.size();
+        size_t meshesOffset = alignUp(offset, SCENE_ALIGNMENT);
+        offset = meshesOffset + sizeof(SceneAssetReference) * description.meshes.size();
+        size_t materialsOffset = alignUp(offset, SCENE_ALIGNMENT);
+        offset = materialsOffset + sizeof(SceneAssetReference) * description.materials.size();
+        size_t stringsOffset = offset;
+        for (const auto& path : description.meshes)
+        {
+            offset += path.size();
+        }
+        for (const auto& path : description.materials)
+        {
+            offset += path.size();
+        }
+        size_t fileSize = alignUp(offset, SCENE_ALIGNMENT);
+
+        std::vector<uint8_t> bytes(fileSize, 0);
+        uint8_t* base = bytes.data();
+
+        auto* header = reinterpret_cast<SceneFileHeader*>(base);
+        *header = SceneFileHeader{};
+        header->magic = SCENE_MAGIC;
+        header->version = SCENE_VERSION;
+        header->fileSize = fileSize;
+
+        header->transforms.count = description.transforms.size();
+        header->objects.count = description.objects.size();
+        header->meshes.count = description.meshes.size();
+        header->materials.count = description.materials.size();
+        setRelative(header->transforms.data, base, transformsOffset);
+        setRelative(header->objects.data, base, objectsOffset);
+        setRelative(header->meshes.data, base, meshesOffset);
+        setRelative(header->materials.data, base, materialsOffset);
+
+        static_assert(sizeof(glm::mat4) == sizeof(SceneTransform), "Transforms are copied straight from glm.");
+        if (description.transforms.empty() == false)
+        {
+            memcpy(base + transformsOffset, description.transforms.data(), sizeof(SceneTransform) * description.transforms.size());
+        }
+        if (description.objects.empty() == false)
+        {
+            memcpy(base + objectsOffset, description.objects.data(), sizeof(SceneObject) * description.objects.size());
+        }
+
+        size_t stringCursor = stringsOffset;
+        auto writeReferences = [&](const std::vector<std::string>& paths, size_t referencesOffset)
+        {
+            auto* references = reinterpret_cast<SceneAssetReference*>(base + referencesOffset);
+            for (size_t i = 0; i < paths.size(); i++)
+            {
+                references[i] = SceneAssetReference{};
+                references[i].path.characters.count = paths[i].size();
+                if (paths[i].empty() == false)
+                {
+                    setRelative(references[i].path.characters.data, base, stringCursor);
+                    memcpy(base + stringCursor, paths[i].data(), paths[i].size());
+                    stringCursor += paths[i].size();
+                }
+            }
+        };
+        writeReferences(description.meshes, meshesOffset);
+        writeReferences(description.materials, materialsOffset);
+
+        //Written to the side then renamed so the hot reloader never sees a
+        //half written level.
+        std::string temporaryPath = filePath + ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                GUST_ERROR("Failed to write scene {0}", filePath);
+                return false;
+            }
+            file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            if (!file.good())
+            {
+                GUST_ERROR("Failed to write scene {0}", filePath);
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, filePath, error);
+        if (error)
+        {
+            GUST_ERROR("Failed to replace scene {0}: {1}", filePath, error.message());
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+
+        return true;
+    }
+}
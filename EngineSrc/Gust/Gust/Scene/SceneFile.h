@@ -0,0 +1,42 @@
+#ifndef SCENE_FILE_HDR
+#define SCENE_FILE_HDR
+
+#include "PreComp.h"
+
+#include "SceneFormat.h"
+#include "Gust/Core/MappedFile.h"
+
+#include <glm/glm.hpp>
+
+namespace Gust
+{
+    //What a level is built from before it is written out.
+    struct SceneDescription
+    {
+        std::vector<glm::mat4> transforms;
+        std::vector<SceneObject> objects;
+        std::vector<std::string> meshes;
+        std::vector<std::string> materials;
+    };
+
+    //A level file mapped into memory. Opening checks every offset and index
+    //once so the rest of the engine can read the arrays without checks.
+    class SceneFile
+    {
+    public:
+        bool open(const std::string& filePath);
+        void close();
+
+        bool isOpen() const { return _header != nullptr; }
+        const SceneFileHeader& getHeader() const { return *_header; }
+
+        static bool write(const std::string& filePath, const SceneDescription& description);
+    private:
+        bool validate(const std::string& filePath) const;
+    private:
+        MappedFile _file;
+        const SceneFileHeader* _header = nullptr;
+    };
+}
+
+#endif // !SCENE_FILE_HDR
@@ -0,0 +1,96 @@
+#ifndef SCENE_FORMAT_HDR
+#define SCENE_FORMAT_HDR
+
+#include "Gust/Assets/CookedFormats.h"
+
+#include <string_view>
+
+//The level format. The file is the in memory layout, every reference is an
+//offset from the field holding it, so a mapped file can be used where it
+//lies without fixing anything up. Like CookedFormats.h this has to stay free
+//of engine includes so the tools can write it.
+namespace Gust
+{
+    constexpr uint32_t SCENE_MAGIC = makeFourCC('G', 'S', 'C', 'N');
+    constexpr uint32_t SCENE_VERSION = 1;
+    constexpr const char* SCENE_EXTENSION = ".gscene";
+
+    //Every array in the file starts on this boundary so transforms can be
+    //loaded with aligned SIMD moves.
+    constexpr size_t SCENE_ALIGNMENT = 16;
+
+    //Points to a T at this field's own address plus offset. Zero is null.
+    template<typename T>
+    struct RelativePointer
+    {
+        int64_t offset = 0;
+
+        const T* get() const
+        {
+            return offset == 0 ? nullptr : reinterpret_cast<const T*>(reinterpret_cast<const uint8_t*>(this) + offset);
+        }
+    };
+
+    template<typename T>
+    struct RelativeArray
+    {
+        RelativePointer<T> data;
+        uint64_t count = 0;
+
+        const T* begin() const { return data.get(); }
+        const T* end() const { return data.get() + count; }
+        const T& operator[](size_t index) const { return data.get()[index]; }
+    };
+
+    struct SceneString
+    {
+        RelativeArray<char> characters;
+
+        std::string_view view() const { return std::string_view(characters.begin(), static_cast<size_t>(characters.count)); }
+    };
+
+    //Column major, the same as glm::mat4.
+    struct alignas(16) SceneTransform
+    {
+        float matrix[16];
+    };
+
+    //Indices are into the file's own transform, mesh and material arrays.
+    //Bounds are in world space so streaming can bin objects without touching
+    //the transforms.
+    struct SceneObject
+    {
+        uint32_t transform;
+        uint32_t mesh;
+        uint32_t material;
+        uint32_t flags;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    constexpr uint32_t SCENE_NO_MATERIAL = 0xFFFFFFFF;
+
+    //A reference to another cooked asset, by path relative to the working
+    //directory.
+    struct SceneAssetReference
+    {
+        SceneString path;
+    };
+
+    struct SceneFileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t fileSize;
+        RelativeArray<SceneTransform> transforms;
+        RelativeArray<SceneObject> objects;
+        RelativeArray<SceneAssetReference> meshes;
+        RelativeArray<SceneAssetReference> materials;
+    };
+
+    static_assert(sizeof(SceneTransform) == 64, "SceneTransform must match glm::mat4.");
+    static_assert(sizeof(SceneObject) == 40, "SceneObject is part of the file format.");
+    static_assert(sizeof(SceneFileHeader) % SCENE_ALIGNMENT == 0, "Arrays following the header must stay aligned.");
+}
+
+#endif // !SCENE_FORMAT_HDR
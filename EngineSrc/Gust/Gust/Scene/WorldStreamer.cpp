@@ -0,0 +1,340 @@
+#include "PreComp.h"
+#include "WorldStreamer.h"
+
+#include "Scene.h"
+#include "Gust/Core/ThreadPool.h"
+
+#include <cmath>
+#include <filesystem>
+
+namespace Gust
+{
+    WorldStreamer::WorldStreamer(const Scene& scene, const StreamingSettings& settings, UploadFunc upload, ReleaseFunc release) :
+        _scene(scene), _settings(settings), _upload(std::move(upload)), _release(std::move(release))
+    {
+        GUST_PROFILE_FUNCTION();
+
+        _settings.unloadRadius = std::max(_settings.unloadRadius, _settings.loadRadius);
+
+        const auto& meshPaths = _scene.getMeshPaths();
+        _meshes.resize(meshPaths.size());
+        for (size_t i = 0; i < meshPaths.size(); i++)
+        {
+            std::error_code error;
+            uintmax_t fileSize = std::filesystem::file_size(meshPaths[i], error);
+            _meshes[i].bytes = error ? 0 : static_cast<uint64_t>(fileSize);
+        }
+
+        //Objects go in the cell holding the centre of their bounds.
+        const auto& boundsMin = _scene.getBoundsMin();
+        const auto& boundsMax = _scene.getBoundsMax();
+        const auto& objectMeshes = _scene.getMeshes();
+        for (uint32_t object = 0; object < _scene.getObjectCount(); object++)
+        {
+            glm::vec3 centre = (boundsMin[object] + boundsMax[object]) * 0.5f;
+            int32_t x = static_cast<int32_t>(std::floor(centre.x / _settings.cellSize));
+            int32_t y = static_cast<int32_t>(std::floor(centre.y / _settings.cellSize));
+
+            Cell& cell = _cells[cellKey(x, y)];
+            if (cell.objects.empty())
+            {
+                cell.centre = glm::vec2((x + 0.5f) * _settings.cellSize, (y + 0.5f) * _settings.cellSize);
+            }
+            cell.objects.push_back(object);
+            cell.meshes.push_back(objectMeshes[object]);
+        }
+
+        //Each cell's asset list only names a mesh once.
+        for (auto& [key, cell] : _cells)
+        {
+            std::sort(cell.meshes.begin(), cell.meshes.end());
+            cell.meshes.erase(std::unique(cell.meshes.begin(), cell.meshes.end()), cell.meshes.end());
+        }
+
+        GUST_INFO("World streaming: {0} objects in {1} cells of {2} units, {3} unique meshes.",
+                  _scene.getObjectCount(), _cells.size(), _settings.cellSize, _meshes.size());
+    }
+
+    WorldStreamer::~WorldStreamer()
+    {
+        {
+            //Load jobs write back into this object.
+            std::unique_lock<std::mutex> lock(_completedMutex);
+            _idle.wait(lock, [this]() { return _loadsInFlight == 0; });
+        }
+
+        for (uint32_t mesh = 0; mesh < _meshes.size(); mesh++)
+        {
+            if (_meshes[mesh].state == MeshState::RESIDENT)
+            {
+                _release(mesh);
+            }
+        }
+    }
+
+    uint64_t WorldStreamer::cellKey(int32_t x, int32_t y)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    void WorldStreamer::update(const glm::vec3& cameraPosition)
+    {
+        GUST_PROFILE_FUNCTION();
+
+        collectLoads();
+
+        glm::vec2 camera(cameraPosition.x, cameraPosition.y);
+
+        //Drop cells that have moved out of range.
+        for (size_t i = 0; i < _activeCells.size();)
+        {
+            Cell& cell = _cells[_activeCells[i]];
+            if (glm::distance(camera, cell.centre) > _settings.unloadRadius)
+            {
+                deactivateCell(cell);
+                _activeCells[i] = _activeCells.back();
+                _activeCells.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        //Only the cells around the camera are looked at, so the cost doesn't
+        //grow with the size of the world.
+        int32_t range = static_cast<int32_t>(std::ceil(_settings.loadRadius / _settings.cellSize));
+        int32_t cameraX = static_cast<int32_t>(std::floor(camera.x / _settings.cellSize));
+        int32_t cameraY = static_cast<int32_t>(std::floor(camera.y / _settings.cellSize));
+
+        std::vector<std::pair<float, uint64_t>> entering;
+        for (int32_t y = cameraY - range; y <= cameraY + range; y++)
+        {
+            for (int32_t x = cameraX - range; x <= cameraX + range; x++)
+            {
+                uint64_t key = cellKey(x, y);
+                auto found = _cells.find(key);
+                if (found == _cells.end() || found->second.active)
+                {
+                    continue;
+                }
+
+                float distance = glm::distance(camera, found->second.centre);
+                if (distance <= _settings.loadRadius)
+                {
+                    entering.push_back({ distance, key });
+                }
+            }
+        }
+
+        //Nearest first so what is in front of the camera arrives first.
+        std::sort(entering.begin(), entering.end());
+        for (const auto& [distance, key] : entering)
+        {
+            activateCell(_cells[key]);
+            _activeCells.push_back(key);
+        }
+
+        startLoads();
+        applyUploads();
+        updateStats();
+    }
+
+    void WorldStreamer::activateCell(Cell& cell)
+    {
+        cell.active = true;
+        for (uint32_t mesh : cell.meshes)
+        {
+            MeshResidency& residency = _meshes[mesh];
+            residency.references++;
+            if (residency.state == MeshState::UNLOADED)
+            {
+                residency.state = MeshState::QUEUED;
+                _loadQueue.push_back(mesh);
+            }
+        }
+    }
+
+    void WorldStreamer::deactivateCell(Cell& cell)
+    {
+        cell.active = false;
+        for (uint32_t mesh : cell.meshes)
+        {
+            MeshResidency& residency = _meshes[mesh];
+            if (--residency.references > 0)
+            {
+                continue;
+            }
+
+            //Meshes still loading or waiting to upload are dropped when they
+            //come out the other end.
+            if (residency.state == MeshState::RESIDENT)
+            {
+                _release(mesh);
+                _residentBytes -= residency.bytes;
+                residency.state = MeshState::UNLOADED;
+            }
+            else if (residency.state == MeshState::QUEUED)
+            {
+                residency.state = MeshState::UNLOADED;
+            }
+        }
+    }
+
+    void WorldStreamer::collectLoads()
+    {
+        std::vector<LoadedMesh> completed;
+        {
+            std::lock_guard<std::mutex> lock(_completedMutex);
+            completed.swap(_completed);
+        }
+
+        for (auto& loaded : completed)
+        {
+            MeshResidency& residency = _meshes[loaded.mesh];
+            if (!loaded.data)
+            {
+                GUST_ERROR("Streaming failed to load {0}.", _scene.getMeshPaths()[loaded.mesh]);
+                _pendingBytes -= residency.bytes;
+                residency.state = MeshState::FAILED;
+                continue;
+            }
+
+            residency.state = MeshState::READY;
+            _readyUploads.push_back(std::move(loaded));
+        }
+    }
+
+    void WorldStreamer::startLoads()
+    {
+        while (_loadQueue.empty() == false && _loadsInFlight < _settings.maxLoadsInFlight)
+        {
+            uint32_t mesh = _loadQueue.front();
+            MeshResidency& residency = _meshes[mesh];
+            if (residency.state != MeshState::QUEUED)
+            {
+                _loadQueue.pop_front();
+                continue;
+            }
+
+            if (_residentBytes + _pendingBytes + residency.bytes > _settings.maxResidentBytes)
+            {
+                if (_memoryCapWarned == false)
+                {
+                    GUST_WARN("World streaming hit its {0} MB cap, waiting for cells to unload.", _settings.maxResidentBytes >> 20);
+                    _memoryCapWarned = true;
+                }
+                break;
+            }
+            _memoryCapWarned = false;
+
+            _loadQueue.pop_front();
+            residency.state = MeshState::LOADING;
+            _pendingBytes += residency.bytes;
+            {
+                std::lock_guard<std::mutex> lock(_completedMutex);
+                _loadsInFlight++;
+            }
+
+            ThreadPool::get().submit([this, mesh, path = _scene.getMeshPaths()[mesh]]()
+            {
+                auto data = std::make_shared<CookedMesh>();
+                if (CookedAssets::loadMesh(path, *data) == false)
+                {
+                    data.reset();
+                }
+
+                std::lock_guard<std::mutex> lock(_completedMutex);
+                _completed.push_back({ mesh, std::move(data) });
+                _loadsInFlight--;
+                _idle.notify_all();
+            });
+        }
+    }
+
+    void WorldStreamer::applyUploads()
+    {
+        _uploadedBytes = 0;
+        while (_readyUploads.empty() == false)
+        {
+            LoadedMesh& loaded = _readyUploads.front();
+            MeshResidency& residency = _meshes[loaded.mesh];
+
+            if (residency.references == 0)
+            {
+                //Its cells went out of range while it was loading.
+                _pendingBytes -= residency.bytes;
+                residency.state = MeshState::UNLOADED;
+                _readyUploads.pop_front();
+                continue;
+            }
+
+            uint64_t bytes = sizeof(CookedVertex) * loaded.data->vertices.size() + sizeof(uint32_t) * loaded.data->indices.size();
+            if (_uploadedBytes > 0 && _uploadedBytes + bytes > _settings.uploadBudgetBytes)
+            {
+                break;
+            }
+
+            _upload(loaded.mesh, *loaded.data);
+            _pendingBytes -= residency.bytes;
+            residency.bytes = bytes;
+            residency.state = MeshState::RESIDENT;
+            _residentBytes += bytes;
+            _uploadedBytes += bytes;
+            _readyUploads.pop_front();
+        }
+    }
+
+    void WorldStreamer::gatherVisibleObjects(std::vector<uint32_t>& objects) const
+    {
+        GUST_PROFILE_FUNCTION();
+
+        const auto& objectMeshes = _scene.getMeshes();
+        for (uint64_t key : _activeCells)
+        {
+            const Cell& cell = _cells.at(key);
+            bool complete = std::all_of(cell.meshes.begin(), cell.meshes.end(), [this](uint32_t mesh)
+            {
+                return _meshes[mesh].state == MeshState::RESIDENT || _meshes[mesh].state == MeshState::FAILED;
+            });
+            if (complete == false)
+            {
+                continue;
+            }
+
+            for (uint32_t object : cell.objects)
+            {
+                if (_meshes[objectMeshes[object]].state == MeshState::RESIDENT)
+                {
+                    objects.push_back(object);
+                }
+            }
+        }
+    }
+
+    void WorldStreamer::updateStats()
+    {
+        _stats = StreamingStats();
+        _stats.activeCells = static_cast<uint32_t>(_activeCells.size());
+        for (uint64_t key : _activeCells)
+        {
+            const Cell& cell = _cells.at(key);
+            bool complete = std::all_of(cell.meshes.begin(), cell.meshes.end(), [this](uint32_t mesh)
+            {
+                return _meshes[mesh].state == MeshState::RESIDENT || _meshes[mesh].state == MeshState::FAILED;
+            });
+            _stats.visibleCells += complete ? 1 : 0;
+        }
+        for (const auto& mesh : _meshes)
+        {
+            _stats.residentMeshes += mesh.state == MeshState::RESIDENT ? 1 : 0;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_completedMutex);
+            _stats.loadsInFlight = _loadsInFlight;
+        }
+        _stats.uploadsWaiting = static_cast<uint32_t>(_readyUploads.size());
+        _stats.residentBytes = _residentBytes;
+        _stats.uploadedBytes = _uploadedBytes;
+    }
+}
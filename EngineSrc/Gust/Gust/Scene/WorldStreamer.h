@@ -0,0 +1,140 @@
+#ifndef WORLD_STREAMER_HDR
+#define WORLD_STREAMER_HDR
+
+#include "PreComp.h"
+
+#include "Gust/Assets/CookedAssets.h"
+
+#include <glm/glm.hpp>
+#include <mutex>
+#include <condition_variable>
+
+namespace Gust
+{
+    class Scene;
+
+    struct StreamingSettings
+    {
+        //Cells are squares on the ground plane, X and Y as the engine is Z up.
+        float cellSize = 32.f;
+        //Cells closer than this start loading...
+        float loadRadius = 96.f;
+        //...and only unload once they are further than this, so a camera
+        //sitting on a cell boundary doesn't load and unload every frame.
+        float unloadRadius = 128.f;
+        //GPU uploads allowed per frame. One upload is always allowed so a
+        //mesh bigger than the budget still gets through.
+        uint64_t uploadBudgetBytes = 4ull * 1024 * 1024;
+        //Hard cap on streamed geometry, loaded or loading. Only the cells in
+        //range are ever active so this holds however big the world is.
+        uint64_t maxResidentBytes = 256ull * 1024 * 1024;
+        uint32_t maxLoadsInFlight = 4;
+    };
+
+    struct StreamingStats
+    {
+        uint32_t activeCells = 0;
+        uint32_t visibleCells = 0;
+        uint32_t residentMeshes = 0;
+        uint32_t loadsInFlight = 0;
+        uint32_t uploadsWaiting = 0;
+        uint64_t residentBytes = 0;
+        uint64_t uploadedBytes = 0;
+    };
+
+    //Splits a scene into grid cells and keeps only the cells around the
+    //camera loaded. Meshes are read on the thread pool and handed to the
+    //renderer at the frame boundary within the upload budget. A mesh shared
+    //by several cells is reference counted and loaded once.
+    class WorldStreamer
+    {
+    public:
+        //Called on the main thread. Upload must create the GPU copy of the
+        //mesh, release must hand it back for deferred destruction.
+        using UploadFunc = std::function<void(uint32_t mesh, const CookedMesh& data)>;
+        using ReleaseFunc = std::function<void(uint32_t mesh)>;
+
+        WorldStreamer(const Scene& scene, const StreamingSettings& settings, UploadFunc upload, ReleaseFunc release);
+        ~WorldStreamer();
+
+        WorldStreamer(const WorldStreamer&) = delete;
+        WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+        //Call once a frame from the main thread.
+        void update(const glm::vec3& cameraPosition);
+
+        //Objects in cells that have finished loading. Cells appear whole so
+        //nothing pops in a piece at a time.
+        void gatherVisibleObjects(std::vector<uint32_t>& objects) const;
+
+        const StreamingStats& getStats() const { return _stats; }
+    private:
+        enum class MeshState
+        {
+            UNLOADED,
+            QUEUED,
+            LOADING,
+            READY,
+            RESIDENT,
+            FAILED
+        };
+
+        struct MeshResidency
+        {
+            uint32_t references = 0;
+            MeshState state = MeshState::UNLOADED;
+            //Estimated from the file size until it's loaded.
+            uint64_t bytes = 0;
+        };
+
+        struct Cell
+        {
+            glm::vec2 centre;
+            std::vector<uint32_t> objects;
+            std::vector<uint32_t> meshes;
+            bool active = false;
+        };
+
+        struct LoadedMesh
+        {
+            uint32_t mesh;
+            //Null when the load failed.
+            std::shared_ptr<CookedMesh> data;
+        };
+
+        static uint64_t cellKey(int32_t x, int32_t y);
+
+        void activateCell(Cell& cell);
+        void deactivateCell(Cell& cell);
+        void collectLoads();
+        void startLoads();
+        void applyUploads();
+        void updateStats();
+    private:
+        const Scene& _scene;
+        StreamingSettings _settings;
+        UploadFunc _upload;
+        ReleaseFunc _release;
+
+        std::unordered_map<uint64_t, Cell> _cells;
+        std::vector<uint64_t> _activeCells;
+        std::vector<MeshResidency> _meshes;
+
+        std::deque<uint32_t> _loadQueue;
+        std::deque<LoadedMesh> _readyUploads;
+        uint64_t _residentBytes = 0;
+        //Loading or waiting to upload, counted against the memory cap.
+        uint64_t _pendingBytes = 0;
+        uint64_t _uploadedBytes = 0;
+        bool _memoryCapWarned = false;
+
+        std::mutex _completedMutex;
+        std::condition_variable _idle;
+        std::vector<LoadedMesh> _completed;
+        uint32_t _loadsInFlight = 0;
+
+        StreamingStats _stats;
+    };
+}
+
+#endif // !WORLD_STREAMER_HDR
@@ -1,6 +1,17 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(binding = 1) uniform sampler2D texSampler;
+//Every texture lives in the bindless set, the draw says which one it wants.
+layout(set = 1, binding = 0) uniform texture2D bindlessTextures[];
+layout(set = 1, binding = 2) uniform sampler bindlessSampler;
+
+layout(push_constant) uniform PushConstants
+{
+    layout(offset = 64) uint textureIndex;
+} pushConstants;
+
+//Picked per pipeline by ShaderVariants, the branch is gone once specialised.
+layout(constant_id = 0) const bool ALPHA_TEST = false;
 
 layout(location = 0) in vec3 fragColour;
 layout(location = 1) in vec2 fragTexCoord;
@@ -9,5 +20,12 @@ layout(location = 0) out vec4 outColour;
 
 void main()
 {
-    outColour = vec4(fragColour * texture(texSampler, fragTexCoord).rgb, 1.0);
+    //The index comes from a push constant so it's the same across the draw,
+    //it doesn't need nonuniformEXT.
+    vec4 texColour = texture(sampler2D(bindlessTextures[pushConstants.textureIndex], bindlessSampler), fragTexCoord);
+    if (ALPHA_TEST && texColour.a < 0.5)
+    {
+        discard;
+    }
+    outColour = vec4(fragColour * texColour.rgb, 1.0);
 }
\ No newline at end of file
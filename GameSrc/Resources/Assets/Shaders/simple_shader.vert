@@ -2,11 +2,15 @@
 
 layout(binding = 0) uniform UniformBufferObject 
 {
-    mat4 model;
     mat4 view;
     mat4 proj;
 } uniformBufferObj;
 
+layout(push_constant) uniform PushConstants
+{
+    mat4 model;
+} pushConstants;
+
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColour;
 layout(location = 2) in vec2 inTexCoord;
@@ -16,7 +20,7 @@ layout(location = 1) out vec2 fragTexCoord;
 
 void main()
 {
-    gl_Position = uniformBufferObj.proj * uniformBufferObj.view * uniformBufferObj.model * vec4(inPosition, 1.0);
+    gl_Position = uniformBufferObj.proj * uniformBufferObj.view * pushConstants.model * vec4(inPosition, 1.0);
     fragColour = inColour;
     fragTexCoord = inTexCoord;
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef BENCH_TIMER_HDR
+#define BENCH_TIMER_HDR
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+
+namespace GustBench
+{
+    struct TimingResult
+    {
+        double minMilliseconds = std::numeric_limits<double>::max();
+        double averageMilliseconds = 0.0;
+    };
+
+    //Runs the function the given number of times. The best run is the one to
+    //compare, the average shows how noisy the machine was.
+    inline TimingResult timeRuns(uint32_t runs, const std::function<void()>& function)
+    {
+        TimingResult result;
+        double total = 0.0;
+        for (uint32_t i = 0; i < runs; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            result.minMilliseconds = std::min(result.minMilliseconds, milliseconds);
+            total += milliseconds;
+        }
+        result.averageMilliseconds = runs > 0 ? total / runs : 0.0;
+        return result;
+    }
+}
+
+#endif // !BENCH_TIMER_HDR
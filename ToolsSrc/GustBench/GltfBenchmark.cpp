@@ -0,0 +1,375 @@
+#include "GltfBenchmark.h"
+#include "BenchTimer.h"
+
+#include "Gust/Assets/GltfLoader.h"
+
+#include <spdlog/spdlog.h>
+#include <tiny_obj_loader.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace
+{
+    struct BenchOptions
+    {
+        uint32_t objects = 64;
+        uint32_t grid = 64;
+        uint32_t runs = 5;
+        std::string objPath;
+        std::string glbPath;
+    };
+
+    bool parseOptions(const std::vector<std::string>& arguments, BenchOptions& options)
+    {
+        for (size_t i = 0; i < arguments.size(); i++)
+        {
+            const std::string& argument = arguments[i];
+            bool hasValue = i + 1 < arguments.size();
+            if (argument == "--objects" && hasValue)
+            {
+                options.objects = static_cast<uint32_t>(std::stoul(arguments[++i]));
+            }
+            else if (argument == "--grid" && hasValue)
+            {
+                options.grid = std::max(static_cast<uint32_t>(std::stoul(arguments[++i])), 2u);
+            }
+            else if (argument == "--runs" && hasValue)
+            {
+                options.runs = std::max(static_cast<uint32_t>(std::stoul(arguments[++i])), 1u);
+            }
+            else if (argument == "--obj" && hasValue)
+            {
+                options.objPath = arguments[++i];
+            }
+            else if (argument == "--glb" && hasValue)
+            {
+                options.glbPath = arguments[++i];
+            }
+            else
+            {
+                spdlog::error("Unknown option {}", argument);
+                return false;
+            }
+        }
+
+        return options.objPath.empty() == options.glbPath.empty();
+    }
+
+    void appendBytes(std::vector<uint8_t>& out, const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    //Writes the same scene twice: an OBJ with one object per grid and a GLB
+    //with one mesh and node per grid. The GLB is laid out the way the engine
+    //wants it so the loader can use it in place.
+    void writeScene(const BenchOptions& options, const std::string& objPath, const std::string& glbPath)
+    {
+        uint32_t grid = options.grid;
+        uint32_t vertexCount = grid * grid;
+        uint32_t indexCount = (grid - 1) * (grid - 1) * 6;
+
+        std::ofstream obj(objPath);
+        std::vector<uint8_t> binary;
+        std::ostringstream json;
+        std::ostringstream meshes;
+        std::ostringstream nodes;
+        std::ostringstream views;
+        std::ostringstream accessors;
+
+        uint32_t objVertexBase = 1;
+        for (uint32_t object = 0; object < options.objects; object++)
+        {
+            float offsetX = static_cast<float>(object % 16) * 2.f;
+            float offsetZ = static_cast<float>(object / 16) * 2.f;
+
+            std::vector<Gust::CookedVertex> vertices(vertexCount);
+            std::vector<uint32_t> indices;
+            indices.reserve(indexCount);
+
+            obj << "o grid_" << object << "\n";
+            for (uint32_t y = 0; y < grid; y++)
+            {
+                for (uint32_t x = 0; x < grid; x++)
+                {
+                    float u = static_cast<float>(x) / (grid - 1);
+                    float v = static_cast<float>(y) / (grid - 1);
+                    Gust::CookedVertex& vertex = vertices[y * grid + x];
+                    vertex.pos[0] = u;
+                    vertex.pos[1] = 0.1f * std::sin(u * 12.f + object);
+                    vertex.pos[2] = v;
+                    vertex.colour[0] = vertex.colour[1] = vertex.colour[2] = 1.f;
+                    vertex.texCoord[0] = u;
+                    vertex.texCoord[1] = 1.f - v;
+                }
+            }
+
+            for (const auto& vertex : vertices)
+            {
+                obj << "v " << vertex.pos[0] + offsetX << " " << vertex.pos[1] << " " << vertex.pos[2] + offsetZ << "\n";
+            }
+            for (const auto& vertex : vertices)
+            {
+                obj << "vt " << vertex.texCoord[0] << " " << 1.f - vertex.texCoord[1] << "\n";
+            }
+            for (uint32_t i = 0; i < vertexCount; i++)
+            {
+                obj << "vn 0 1 0\n";
+            }
+
+            for (uint32_t y = 0; y + 1 < grid; y++)
+            {
+                for (uint32_t x = 0; x + 1 < grid; x++)
+                {
+                    uint32_t a = y * grid + x;
+                    uint32_t b = a + 1;
+                    uint32_t c = a + grid;
+                    uint32_t d = c + 1;
+                    uint32_t quad[6] = { a, c, b, b, c, d };
+                    indices.insert(indices.end(), quad, quad + 6);
+
+                    for (uint32_t t = 0; t < 2; t++)
+                    {
+                        obj << "f";
+                        for (uint32_t k = 0; k < 3; k++)
+                        {
+                            uint32_t index = quad[t * 3 + k] + objVertexBase;
+                            obj << " " << index << "/" << index << "/" << index;
+                        }
+                        obj << "\n";
+                    }
+                }
+            }
+            objVertexBase += vertexCount;
+
+            //Three views per mesh: interleaved vertices, normals, indices.
+            uint32_t firstView = object * 3;
+            uint32_t firstAccessor = object * 5;
+
+            size_t vertexOffset = binary.size();
+            appendBytes(binary, vertices.data(), vertices.size() * sizeof(Gust::CookedVertex));
+            size_t normalOffset = binary.size();
+            for (uint32_t i = 0; i < vertexCount; i++)
+            {
+                float normal[3] = { 0.f, 1.f, 0.f };
+                appendBytes(binary, normal, sizeof(normal));
+            }
+            size_t indexOffset = binary.size();
+            appendBytes(binary, indices.data(), indices.size() * sizeof(uint32_t));
+
+            const char* separator = object == 0 ? "" : ",";
+            views << separator
+                  << "{\"buffer\":0,\"byteOffset\":" << vertexOffset << ",\"byteLength\":" << vertexCount * sizeof(Gust::CookedVertex) << ",\"byteStride\":32},"
+                  << "{\"buffer\":0,\"byteOffset\":" << normalOffset << ",\"byteLength\":" << vertexCount * 12 << "},"
+                  << "{\"buffer\":0,\"byteOffset\":" << indexOffset << ",\"byteLength\":" << indexCount * 4 << "}";
+
+            accessors << separator
+                      << "{\"bufferView\":" << firstView << ",\"byteOffset\":0,\"componentType\":5126,\"count\":" << vertexCount
+                      << ",\"type\":\"VEC3\",\"min\":[0,-0.1,0],\"max\":[1,0.1,1]},"
+                      << "{\"bufferView\":" << firstView << ",\"byteOffset\":12,\"componentType\":5126,\"count\":" << vertexCount << ",\"type\":\"VEC3\"},"
+                      << "{\"bufferView\":" << firstView << ",\"byteOffset\":24,\"componentType\":5126,\"count\":" << vertexCount << ",\"type\":\"VEC2\"},"
+                      << "{\"bufferView\":" << firstView + 1 << ",\"componentType\":5126,\"count\":" << vertexCount << ",\"type\":\"VEC3\"},"
+                      << "{\"bufferView\":" << firstView + 2 << ",\"componentType\":5125,\"count\":" << indexCount << ",\"type\":\"SCALAR\"}";
+
+            meshes << separator << "{\"name\":\"grid_" << object << "\",\"primitives\":[{\"attributes\":{\"POSITION\":" << firstAccessor
+                   << ",\"COLOR_0\":" << firstAccessor + 1 << ",\"TEXCOORD_0\":" << firstAccessor + 2 << ",\"NORMAL\":" << firstAccessor + 3
+                   << "},\"indices\":" << firstAccessor + 4 << "}]}";
+
+            nodes << separator << "{\"mesh\":" << object << ",\"translation\":[" << offsetX << ",0," << offsetZ << "]}";
+        }
+
+        std::ostringstream sceneNodes;
+        for (uint32_t object = 0; object < options.objects; object++)
+        {
+            sceneNodes << (object == 0 ? "" : ",") << object;
+        }
+
+        json << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"GustBench\"},\"scene\":0,\"scenes\":[{\"nodes\":[" << sceneNodes.str() << "]}],"
+             << "\"nodes\":[" << nodes.str() << "],\"meshes\":[" << meshes.str() << "],"
+             << "\"buffers\":[{\"byteLength\":" << binary.size() << "}],"
+             << "\"bufferViews\":[" << views.str() << "],\"accessors\":[" << accessors.str() << "]}";
+
+        std::string jsonText = json.str();
+        jsonText.resize((jsonText.size() + 3) & ~size_t(3), ' ');
+        binary.resize((binary.size() + 3) & ~size_t(3), 0);
+
+        uint32_t header[3] = { 0x46546C67, 2, static_cast<uint32_t>(12 + 8 + jsonText.size() + 8 + binary.size()) };
+        uint32_t jsonChunk[2] = { static_cast<uint32_t>(jsonText.size()), 0x4E4F534A };
+        uint32_t binaryChunk[2] = { static_cast<uint32_t>(binary.size()), 0x004E4942 };
+
+        std::ofstream glb(glbPath, std::ios::binary);
+        glb.write(reinterpret_cast<const char*>(header), sizeof(header));
+        glb.write(reinterpret_cast<const char*>(jsonChunk), sizeof(jsonChunk));
+        glb.write(jsonText.data(), jsonText.size());
+        glb.write(reinterpret_cast<const char*>(binaryChunk), sizeof(binaryChunk));
+        glb.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+    }
+
+    struct VertexKey
+    {
+        int vertex;
+        int texCoord;
+
+        bool operator==(const VertexKey& other) const
+        {
+            return vertex == other.vertex && texCoord == other.texCoord;
+        }
+    };
+
+    struct VertexKeyHash
+    {
+        size_t operator()(const VertexKey& key) const
+        {
+            return std::hash<uint64_t>()((static_cast<uint64_t>(key.vertex) << 32) | static_cast<uint32_t>(key.texCoord));
+        }
+    };
+
+    //What the engine used to do at runtime: parse the OBJ then weld the
+    //corners into an indexed vertex buffer.
+    double loadObj(const std::string& path, bool buildVertices)
+    {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warning;
+        std::string error;
+        if (tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, path.c_str()) == false)
+        {
+            spdlog::error("tinyobj failed on {}: {}", path, error);
+            return 0.0;
+        }
+
+        double checksum = 0.0;
+        if (buildVertices == false)
+        {
+            for (float value : attrib.vertices)
+            {
+                checksum += value;
+            }
+            return checksum;
+        }
+
+        for (const auto& shape : shapes)
+        {
+            std::vector<Gust::CookedVertex> vertices;
+            std::vector<uint32_t> indices;
+            std::unordered_map<VertexKey, uint32_t, VertexKeyHash> unique;
+
+            for (const auto& index : shape.mesh.indices)
+            {
+                VertexKey key{ index.vertex_index, index.texcoord_index };
+                auto found = unique.find(key);
+                if (found == unique.end())
+                {
+                    Gust::CookedVertex vertex{};
+                    memcpy(vertex.pos, &attrib.vertices[3 * index.vertex_index], sizeof(vertex.pos));
+                    vertex.colour[0] = vertex.colour[1] = vertex.colour[2] = 1.f;
+                    vertex.texCoord[0] = attrib.texcoords[2 * index.texcoord_index];
+                    vertex.texCoord[1] = 1.f - attrib.texcoords[2 * index.texcoord_index + 1];
+
+                    found = unique.emplace(key, static_cast<uint32_t>(vertices.size())).first;
+                    vertices.push_back(vertex);
+                }
+                indices.push_back(found->second);
+            }
+
+            for (const auto& vertex : vertices)
+            {
+                checksum += vertex.pos[0] + vertex.pos[1] + vertex.pos[2];
+            }
+        }
+        return checksum;
+    }
+
+    //Touches every vertex so the mapped pages actually get read, otherwise
+    //the GLB side would only be measuring the JSON.
+    double loadGlb(const std::string& path, uint32_t& zeroCopy, uint32_t& streams)
+    {
+        Gust::Model model;
+        if (Gust::GltfLoader::load(path, model) == false)
+        {
+            return 0.0;
+        }
+
+        double checksum = 0.0;
+        zeroCopy = 0;
+        streams = 0;
+        for (const auto& mesh : model.meshes)
+        {
+            for (const auto& primitive : mesh.primitives)
+            {
+                for (uint32_t i = 0; i < primitive.vertices.count; i++)
+                {
+                    const auto& vertex = primitive.vertices.data[i];
+                    checksum += vertex.pos[0] + vertex.pos[1] + vertex.pos[2];
+                }
+                for (uint32_t i = 0; i < primitive.indices.count; i++)
+                {
+                    checksum += primitive.indices.data[i] * 0.0;
+                }
+
+                streams += 2;
+                zeroCopy += (primitive.vertices.isZeroCopy() ? 1 : 0) + (primitive.indices.isZeroCopy() ? 1 : 0);
+            }
+        }
+        return checksum;
+    }
+}
+
+namespace GustBench
+{
+    int runGltfBenchmark(const std::vector<std::string>& arguments)
+    {
+        BenchOptions options;
+        if (parseOptions(arguments, options) == false)
+        {
+            spdlog::error("Usage: GustBench gltf [--objects N] [--grid N] [--runs N] [--obj file --glb file]");
+            return 1;
+        }
+
+        std::string objPath = options.objPath;
+        std::string glbPath = options.glbPath;
+        if (objPath.empty())
+        {
+            std::filesystem::path directory = std::filesystem::temp_directory_path();
+            objPath = (directory / "gustbench_scene.obj").string();
+            glbPath = (directory / "gustbench_scene.glb").string();
+
+            spdlog::info("Writing {} grids of {}x{} vertices...", options.objects, options.grid, options.grid);
+            writeScene(options, objPath, glbPath);
+        }
+
+        std::error_code error;
+        spdlog::info("OBJ {:.1f} MB, GLB {:.1f} MB", std::filesystem::file_size(objPath, error) / (1024.0 * 1024.0),
+                     std::filesystem::file_size(glbPath, error) / (1024.0 * 1024.0));
+
+        //The loader logs every load, which would swamp the results.
+        auto level = Gust::Log::getLogger()->level();
+        Gust::Log::getLogger()->set_level(spdlog::level::warn);
+
+        double objChecksum = 0.0;
+        double glbChecksum = 0.0;
+        uint32_t zeroCopy = 0;
+        uint32_t streams = 0;
+
+        TimingResult parseOnly = timeRuns(options.runs, [&]() { objChecksum = loadObj(objPath, false); });
+        TimingResult objTotal = timeRuns(options.runs, [&]() { objChecksum = loadObj(objPath, true); });
+        TimingResult glbTotal = timeRuns(options.runs, [&]() { glbChecksum = loadGlb(glbPath, zeroCopy, streams); });
+
+        Gust::Log::getLogger()->set_level(level);
+
+        spdlog::info("tinyobj::LoadObj                 min {:8.2f} ms  avg {:8.2f} ms", parseOnly.minMilliseconds, parseOnly.averageMilliseconds);
+        spdlog::info("tinyobj::LoadObj + vertex build  min {:8.2f} ms  avg {:8.2f} ms", objTotal.minMilliseconds, objTotal.averageMilliseconds);
+        spdlog::info("GltfLoader::load (GLB)           min {:8.2f} ms  avg {:8.2f} ms", glbTotal.minMilliseconds, glbTotal.averageMilliseconds);
+        spdlog::info("{}/{} GLB streams used in place, {:.1f}x faster than LoadObj alone.", zeroCopy, streams,
+                     parseOnly.minMilliseconds / std::max(glbTotal.minMilliseconds, 0.001));
+        //Printed so the compiler can't throw the loads away.
+        spdlog::info("Checksums: OBJ {:.3f}, GLB {:.3f}", objChecksum, glbChecksum);
+        return 0;
+    }
+}
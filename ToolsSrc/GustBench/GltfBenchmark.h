@@ -0,0 +1,14 @@
+#ifndef GLTF_BENCHMARK_HDR
+#define GLTF_BENCHMARK_HDR
+
+#include <string>
+#include <vector>
+
+namespace GustBench
+{
+    //Compares loading a GLB through the engine loader with tinyobj::LoadObj
+    //on the same geometry.
+    int runGltfBenchmark(const std::vector<std::string>& arguments);
+}
+
+#endif // !GLTF_BENCHMARK_HDR
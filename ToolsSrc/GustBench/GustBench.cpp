@@ -0,0 +1,53 @@
+#include "GltfBenchmark.h"
+#include "SceneBenchmark.h"
+#include "StreamingBenchmark.h"
+
+#include "Gust/Core/Log.h"
+
+#include <spdlog/spdlog.h>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    void printUsage()
+    {
+        spdlog::info("Usage: GustBench <benchmark> [options]");
+        spdlog::info("  gltf [--objects N] [--grid N] [--runs N] [--obj file --glb file]");
+        spdlog::info("  scene [--objects N] [--runs N]");
+        spdlog::info("  streaming [--side N] [--meshes N] [--frames N] [--frame-ms N]");
+    }
+}
+
+//Offline benchmarks for engine systems that don't need a GPU.
+int main(int argc, char** argv)
+{
+    Gust::Log::init();
+
+    if (argc < 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::string benchmark = argv[1];
+    std::vector<std::string> arguments(argv + 2, argv + argc);
+
+    if (benchmark == "gltf")
+    {
+        return GustBench::runGltfBenchmark(arguments);
+    }
+    if (benchmark == "scene")
+    {
+        return GustBench::runSceneBenchmark(arguments);
+    }
+    if (benchmark == "streaming")
+    {
+        return GustBench::runStreamingBenchmark(arguments);
+    }
+
+    spdlog::error("Unknown benchmark {}", benchmark);
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,125 @@
+#include "SceneBenchmark.h"
+#include "BenchTimer.h"
+
+#include "Gust/Scene/Scene.h"
+#include "Gust/Scene/SceneFile.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+
+namespace
+{
+    struct BenchOptions
+    {
+        uint32_t objects = 10000;
+        uint32_t meshes = 16;
+        uint32_t materials = 8;
+        uint32_t runs = 20;
+    };
+
+    bool parseOptions(const std::vector<std::string>& arguments, BenchOptions& options)
+    {
+        for (size_t i = 0; i < arguments.size(); i++)
+        {
+            const std::string& argument = arguments[i];
+            bool hasValue = i + 1 < arguments.size();
+            if (argument == "--objects" && hasValue)
+            {
+                options.objects = static_cast<uint32_t>(std::stoul(arguments[++i]));
+            }
+            else if (argument == "--runs" && hasValue)
+            {
+                options.runs = std::max(static_cast<uint32_t>(std::stoul(arguments[++i])), 1u);
+            }
+            else
+            {
+                spdlog::error("Unknown option {}", argument);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //Lays the objects out on a square grid, one unit cube each.
+    Gust::SceneDescription buildScene(const BenchOptions& options)
+    {
+        Gust::SceneDescription description;
+        for (uint32_t i = 0; i < options.meshes; i++)
+        {
+            description.meshes.push_back("Assets/Models/bench_" + std::to_string(i) + ".gmesh");
+        }
+        for (uint32_t i = 0; i < options.materials; i++)
+        {
+            description.materials.push_back("Assets/Materials/bench_" + std::to_string(i) + ".gmat");
+        }
+
+        uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(options.objects))));
+        description.transforms.reserve(options.objects);
+        description.objects.reserve(options.objects);
+        for (uint32_t i = 0; i < options.objects; i++)
+        {
+            glm::vec3 position(static_cast<float>(i % side) * 4.f, 0.f, static_cast<float>(i / side) * 4.f);
+            description.transforms.push_back(glm::translate(glm::mat4(1.f), position));
+
+            Gust::SceneObject object{};
+            object.transform = i;
+            object.mesh = i % options.meshes;
+            object.material = i % options.materials;
+            for (int c = 0; c < 3; c++)
+            {
+                object.boundsMin[c] = position[c] - 0.5f;
+                object.boundsMax[c] = position[c] + 0.5f;
+            }
+            description.objects.push_back(object);
+        }
+
+        return description;
+    }
+}
+
+namespace GustBench
+{
+    int runSceneBenchmark(const std::vector<std::string>& arguments)
+    {
+        BenchOptions options;
+        if (parseOptions(arguments, options) == false)
+        {
+            spdlog::error("Usage: GustBench scene [--objects N] [--runs N]");
+            return 1;
+        }
+
+        std::string path = (std::filesystem::temp_directory_path() / "gustbench_level.gscene").string();
+        if (Gust::SceneFile::write(path, buildScene(options)) == false)
+        {
+            return 1;
+        }
+
+        std::error_code error;
+        spdlog::info("Level with {} objects is {:.2f} MB", options.objects, std::filesystem::file_size(path, error) / (1024.0 * 1024.0));
+
+        uint32_t loaded = 0;
+        TimingResult openOnly = timeRuns(options.runs, [&]()
+        {
+            Gust::SceneFile file;
+            file.open(path);
+        });
+
+        TimingResult total = timeRuns(options.runs, [&]()
+        {
+            Gust::SceneFile file;
+            Gust::Scene scene;
+            if (file.open(path))
+            {
+                scene.instantiate(file);
+            }
+            loaded = scene.getObjectCount();
+        });
+
+        spdlog::info("Map and validate        min {:8.3f} ms  avg {:8.3f} ms", openOnly.minMilliseconds, openOnly.averageMilliseconds);
+        spdlog::info("Map, validate, instance min {:8.3f} ms  avg {:8.3f} ms", total.minMilliseconds, total.averageMilliseconds);
+        spdlog::info("{} objects instantiated, {:.1f} ns per object.", loaded, total.minMilliseconds * 1e6 / std::max(loaded, 1u));
+        return loaded == options.objects ? 0 : 1;
+    }
+}
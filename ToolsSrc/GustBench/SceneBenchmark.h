@@ -0,0 +1,13 @@
+#ifndef SCENE_BENCHMARK_HDR
+#define SCENE_BENCHMARK_HDR
+
+#include <string>
+#include <vector>
+
+namespace GustBench
+{
+    //Times opening a level file and instantiating every object from it.
+    int runSceneBenchmark(const std::vector<std::string>& arguments);
+}
+
+#endif // !SCENE_BENCHMARK_HDR
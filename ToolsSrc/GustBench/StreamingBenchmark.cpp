@@ -0,0 +1,213 @@
+#include "StreamingBenchmark.h"
+
+#include "Gust/Assets/CookedFormats.h"
+#include "Gust/Scene/Scene.h"
+#include "Gust/Scene/SceneFile.h"
+#include "Gust/Scene/WorldStreamer.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+    struct BenchOptions
+    {
+        //World is side by side units, one object every spacing units.
+        float side = 2048.f;
+        float spacing = 8.f;
+        uint32_t meshes = 256;
+        uint32_t verticesPerMesh = 4096;
+        uint32_t frames = 2000;
+        float frameMilliseconds = 2.f;
+    };
+
+    bool parseOptions(const std::vector<std::string>& arguments, BenchOptions& options)
+    {
+        for (size_t i = 0; i < arguments.size(); i++)
+        {
+            const std::string& argument = arguments[i];
+            bool hasValue = i + 1 < arguments.size();
+            if (argument == "--side" && hasValue)
+            {
+                options.side = std::stof(arguments[++i]);
+            }
+            else if (argument == "--meshes" && hasValue)
+            {
+                options.meshes = std::max(static_cast<uint32_t>(std::stoul(arguments[++i])), 1u);
+            }
+            else if (argument == "--frames" && hasValue)
+            {
+                options.frames = static_cast<uint32_t>(std::stoul(arguments[++i]));
+            }
+            else if (argument == "--frame-ms" && hasValue)
+            {
+                options.frameMilliseconds = std::stof(arguments[++i]);
+            }
+            else
+            {
+                spdlog::error("Unknown option {}", argument);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool writeMesh(const std::filesystem::path& path, uint32_t vertexCount)
+    {
+        std::vector<Gust::CookedVertex> vertices(vertexCount, Gust::CookedVertex{});
+        std::vector<uint32_t> indices(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            indices[i] = i;
+        }
+
+        Gust::CookedMeshHeader header{};
+        header.magic = Gust::COOKED_MESH_MAGIC;
+        header.version = Gust::COOKED_MESH_VERSION;
+        header.vertexCount = vertexCount;
+        header.indexCount = vertexCount;
+
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(vertices.data()), sizeof(Gust::CookedVertex) * vertices.size());
+        file.write(reinterpret_cast<const char*>(indices.data()), sizeof(uint32_t) * indices.size());
+        return file.good();
+    }
+
+    //Every mesh gets its own patch of the world so moving the camera always
+    //brings in new geometry rather than reusing what's resident.
+    Gust::SceneDescription buildScene(const BenchOptions& options, const std::filesystem::path& directory)
+    {
+        Gust::SceneDescription description;
+        for (uint32_t i = 0; i < options.meshes; i++)
+        {
+            description.meshes.push_back((directory / ("mesh_" + std::to_string(i) + ".gmesh")).string());
+        }
+
+        uint32_t perSide = static_cast<uint32_t>(options.side / options.spacing);
+        uint32_t patchesPerSide = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(options.meshes))));
+        for (uint32_t y = 0; y < perSide; y++)
+        {
+            for (uint32_t x = 0; x < perSide; x++)
+            {
+                glm::vec3 position(x * options.spacing, y * options.spacing, 0.f);
+                description.transforms.push_back(glm::translate(glm::mat4(1.f), position));
+
+                uint32_t patchX = x * patchesPerSide / perSide;
+                uint32_t patchY = y * patchesPerSide / perSide;
+
+                Gust::SceneObject object{};
+                object.transform = static_cast<uint32_t>(description.objects.size());
+                object.mesh = (patchY * patchesPerSide + patchX) % options.meshes;
+                object.material = Gust::SCENE_NO_MATERIAL;
+                for (int c = 0; c < 3; c++)
+                {
+                    object.boundsMin[c] = position[c] - 0.5f;
+                    object.boundsMax[c] = position[c] + 0.5f;
+                }
+                description.objects.push_back(object);
+            }
+        }
+
+        return description;
+    }
+}
+
+namespace GustBench
+{
+    int runStreamingBenchmark(const std::vector<std::string>& arguments)
+    {
+        BenchOptions options;
+        if (parseOptions(arguments, options) == false)
+        {
+            spdlog::error("Usage: GustBench streaming [--side N] [--meshes N] [--frames N] [--frame-ms N]");
+            return 1;
+        }
+
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "gustbench_streaming";
+        std::filesystem::create_directories(directory);
+        for (uint32_t i = 0; i < options.meshes; i++)
+        {
+            if (writeMesh(directory / ("mesh_" + std::to_string(i) + ".gmesh"), options.verticesPerMesh) == false)
+            {
+                spdlog::error("Failed to write the benchmark meshes to {}", directory.string());
+                return 1;
+            }
+        }
+
+        std::string levelPath = (directory / "level.gscene").string();
+        if (Gust::SceneFile::write(levelPath, buildScene(options, directory)) == false)
+        {
+            return 1;
+        }
+
+        Gust::SceneFile level;
+        Gust::Scene scene;
+        if (level.open(levelPath) == false)
+        {
+            return 1;
+        }
+        scene.instantiate(level);
+
+        uint64_t worldBytes = static_cast<uint64_t>(options.meshes) * options.verticesPerMesh * (sizeof(Gust::CookedVertex) + sizeof(uint32_t));
+        Gust::StreamingSettings settings;
+
+        //The GPU side is stood in for by counting what would be uploaded.
+        uint64_t uploads = 0;
+        uint64_t releases = 0;
+        uint64_t peakResidentBytes = 0;
+        uint64_t peakUploadBytes = 0;
+        float peakUpdateMilliseconds = 0.f;
+        float totalUpdateMilliseconds = 0.f;
+        uint64_t visibleObjects = 0;
+        {
+            Gust::WorldStreamer streamer(scene, settings,
+                [&uploads](uint32_t, const Gust::CookedMesh&) { uploads++; },
+                [&releases](uint32_t) { releases++; });
+
+            std::vector<uint32_t> visible;
+            for (uint32_t frame = 0; frame < options.frames; frame++)
+            {
+                //Corner to corner across the world.
+                float t = options.frames > 1 ? static_cast<float>(frame) / (options.frames - 1) : 0.f;
+                glm::vec3 camera(t * options.side, t * options.side, 2.f);
+
+                auto startTime = std::chrono::steady_clock::now();
+                streamer.update(camera);
+                float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+                visible.clear();
+                streamer.gatherVisibleObjects(visible);
+                visibleObjects += visible.size();
+
+                const Gust::StreamingStats& stats = streamer.getStats();
+                peakResidentBytes = std::max(peakResidentBytes, stats.residentBytes);
+                peakUploadBytes = std::max(peakUploadBytes, stats.uploadedBytes);
+                peakUpdateMilliseconds = std::max(peakUpdateMilliseconds, milliseconds);
+                totalUpdateMilliseconds += milliseconds;
+
+                std::this_thread::sleep_for(std::chrono::duration<float, std::milli>(options.frameMilliseconds));
+            }
+        }
+
+        spdlog::info("World: {} objects, {} meshes, {:.1f} MB of geometry, {} x {} units.",
+                     scene.getObjectCount(), options.meshes, worldBytes / (1024.0 * 1024.0), options.side, options.side);
+        spdlog::info("Settings: cell {} units, load {} / unload {}, upload budget {:.1f} MB per frame, cap {:.0f} MB.",
+                     settings.cellSize, settings.loadRadius, settings.unloadRadius,
+                     settings.uploadBudgetBytes / (1024.0 * 1024.0), settings.maxResidentBytes / (1024.0 * 1024.0));
+        spdlog::info("Peak resident   {:8.2f} MB", peakResidentBytes / (1024.0 * 1024.0));
+        spdlog::info("Peak upload     {:8.2f} MB in one frame", peakUploadBytes / (1024.0 * 1024.0));
+        spdlog::info("Update          avg {:.3f} ms  max {:.3f} ms", totalUpdateMilliseconds / std::max(options.frames, 1u), peakUpdateMilliseconds);
+        spdlog::info("{} uploads, {} releases, {:.0f} visible objects per frame.", uploads, releases,
+                     static_cast<double>(visibleObjects) / std::max(options.frames, 1u));
+
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+        return 0;
+    }
+}
@@ -0,0 +1,14 @@
+#ifndef STREAMING_BENCHMARK_HDR
+#define STREAMING_BENCHMARK_HDR
+
+#include <string>
+#include <vector>
+
+namespace GustBench
+{
+    //Flies a camera across a generated world and reports how much geometry
+    //the streamer keeps resident and how much it uploads per frame.
+    int runStreamingBenchmark(const std::vector<std::string>& arguments);
+}
+
+#endif // !STREAMING_BENCHMARK_HDR
@@ -0,0 +1,69 @@
+#include "CookIO.h"
+
+#include <fstream>
+#include <system_error>
+
+namespace GustCook
+{
+    uint64_t hashBytes(const void* data, size_t size, uint64_t seed)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = seed;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    uint64_t hashString(const std::string& text, uint64_t seed)
+    {
+        return hashBytes(text.data(), text.size(), seed);
+    }
+
+    bool readFile(const std::filesystem::path& filePath, std::vector<uint8_t>& bytes)
+    {
+        std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        bytes.resize(fileSize);
+
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(bytes.data()), fileSize);
+
+        return file.good();
+    }
+
+    bool writeFileAtomic(const std::filesystem::path& filePath, const void* data, size_t size)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(filePath.parent_path(), error);
+
+        std::filesystem::path tempPath = filePath;
+        tempPath += ".tmp";
+
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+            {
+                return false;
+            }
+
+            file.write(static_cast<const char*>(data), size);
+            if (!file.good())
+            {
+                return false;
+            }
+        }
+
+        std::filesystem::rename(tempPath, filePath, error);
+        return !error;
+    }
+}
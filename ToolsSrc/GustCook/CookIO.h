@@ -0,0 +1,30 @@
+#ifndef COOK_IO_HDR
+#define COOK_IO_HDR
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace GustCook
+{
+    //64 bit FNV-1a. Good enough to spot changed content, it isn't meant to
+    //stand up to anyone trying to make collisions.
+    uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+    uint64_t hashString(const std::string& text, uint64_t seed = 14695981039346656037ull);
+
+    bool readFile(const std::filesystem::path& filePath, std::vector<uint8_t>& bytes);
+
+    //Writes next to the target then renames over it. A crash or a killed
+    //build never leaves a half written asset that looks up to date.
+    bool writeFileAtomic(const std::filesystem::path& filePath, const void* data, size_t size);
+
+    template<typename T>
+    void appendBytes(std::vector<uint8_t>& bytes, const T* data, size_t count)
+    {
+        const uint8_t* begin = reinterpret_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), begin, begin + sizeof(T) * count);
+    }
+}
+
+#endif // !COOK_IO_HDR
@@ -0,0 +1,42 @@
+#ifndef COOK_JOB_HDR
+#define COOK_JOB_HDR
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace GustCook
+{
+    struct CookSettings
+    {
+        std::filesystem::path glslcPath;
+        bool compressTextures = true;
+        bool optimiseShaders = true;
+    };
+
+    enum class CookType
+    {
+        MESH,
+        TEXTURE,
+        SHADER,
+        COPY
+    };
+
+    struct CookJob
+    {
+        CookType type;
+        std::filesystem::path source;
+        std::filesystem::path output;
+    };
+
+    //Every file that went into the output is listed in inputs, the source
+    //first. The manifest uses these to decide what needs re-cooking.
+    struct CookResult
+    {
+        bool success = false;
+        std::vector<std::filesystem::path> inputs;
+        std::string message;
+    };
+}
+
+#endif // !COOK_JOB_HDR
@@ -0,0 +1,193 @@
+#include "CookManifest.h"
+#include "CookIO.h"
+
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+namespace
+{
+    const char* MANIFEST_HEADER = "gustcook-manifest 1";
+}
+
+namespace GustCook
+{
+    bool CookManifest::load(const std::filesystem::path& filePath)
+    {
+        std::ifstream file(filePath);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        std::string line;
+        if (!std::getline(file, line) || line != MANIFEST_HEADER)
+        {
+            //A manifest from another version is treated as no manifest, so
+            //everything gets cooked again.
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.clear();
+
+        ManifestEntry* current = nullptr;
+        while (std::getline(file, line))
+        {
+            std::istringstream fields(line);
+            std::string tag;
+            std::getline(fields, tag, '\t');
+
+            if (tag == "entry")
+            {
+                std::string output;
+                std::string settings;
+                std::getline(fields, output, '\t');
+                std::getline(fields, settings, '\t');
+
+                current = &_entries[output];
+                current->settingsHash = std::stoull(settings);
+                current->inputs.clear();
+            }
+            else if (tag == "input" && current != nullptr)
+            {
+                InputStamp stamp;
+                std::string size;
+                std::string writeTime;
+                std::string hash;
+                std::getline(fields, stamp.path, '\t');
+                std::getline(fields, size, '\t');
+                std::getline(fields, writeTime, '\t');
+                std::getline(fields, hash, '\t');
+
+                stamp.size = std::stoull(size);
+                stamp.writeTime = std::stoll(writeTime);
+                stamp.hash = std::stoull(hash);
+                current->inputs.push_back(stamp);
+            }
+        }
+
+        return true;
+    }
+
+    bool CookManifest::save(const std::filesystem::path& filePath) const
+    {
+        std::ostringstream out;
+        out << MANIFEST_HEADER << '\n';
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (const auto& [output, entry] : _entries)
+            {
+                out << "entry\t" << output << '\t' << entry.settingsHash << '\n';
+                for (const auto& input : entry.inputs)
+                {
+                    out << "input\t" << input.path << '\t' << input.size << '\t' << input.writeTime << '\t' << input.hash << '\n';
+                }
+            }
+        }
+
+        std::string text = out.str();
+        return writeFileAtomic(filePath, text.data(), text.size());
+    }
+
+    bool CookManifest::isUpToDate(const std::filesystem::path& output, uint64_t settingsHash) const
+    {
+        std::error_code error;
+        if (!std::filesystem::exists(output, error))
+        {
+            return false;
+        }
+
+        ManifestEntry entry;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto found = _entries.find(output.generic_string());
+            if (found == _entries.end())
+            {
+                return false;
+            }
+            entry = found->second;
+        }
+
+        if (entry.settingsHash != settingsHash || entry.inputs.empty())
+        {
+            return false;
+        }
+
+        for (const auto& input : entry.inputs)
+        {
+            InputStamp current;
+            if (stampFile(input.path, current, false) == false)
+            {
+                return false;
+            }
+
+            if (current.size == input.size && current.writeTime == input.writeTime)
+            {
+                continue;
+            }
+
+            //The file was touched, only re-cook if the content moved too.
+            if (stampFile(input.path, current, true) == false || current.hash != input.hash)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void CookManifest::record(const std::filesystem::path& output, uint64_t settingsHash, const std::vector<std::filesystem::path>& inputs)
+    {
+        ManifestEntry entry;
+        entry.settingsHash = settingsHash;
+
+        for (const auto& input : inputs)
+        {
+            InputStamp stamp;
+            if (stampFile(input, stamp, true))
+            {
+                entry.inputs.push_back(stamp);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries[output.generic_string()] = std::move(entry);
+    }
+
+    void CookManifest::forget(const std::filesystem::path& output)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.erase(output.generic_string());
+    }
+
+    bool CookManifest::stampFile(const std::filesystem::path& filePath, InputStamp& stamp, bool computeHash)
+    {
+        std::error_code error;
+        stamp.path = filePath.generic_string();
+        stamp.size = std::filesystem::file_size(filePath, error);
+        if (error)
+        {
+            return false;
+        }
+
+        stamp.writeTime = std::filesystem::last_write_time(filePath, error).time_since_epoch().count();
+        if (error)
+        {
+            return false;
+        }
+
+        if (computeHash)
+        {
+            std::vector<uint8_t> bytes;
+            if (readFile(filePath, bytes) == false)
+            {
+                return false;
+            }
+            stamp.hash = hashBytes(bytes.data(), bytes.size());
+        }
+
+        return true;
+    }
+}
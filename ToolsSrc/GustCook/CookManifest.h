@@ -0,0 +1,52 @@
+#ifndef COOK_MANIFEST_HDR
+#define COOK_MANIFEST_HDR
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GustCook
+{
+    //What a source file looked like the last time it was cooked. Size and
+    //write time are the cheap check, the content hash is only looked at when
+    //those disagree so touching a file doesn't force a re-cook.
+    struct InputStamp
+    {
+        std::string path;
+        uint64_t size = 0;
+        int64_t writeTime = 0;
+        uint64_t hash = 0;
+    };
+
+    struct ManifestEntry
+    {
+        uint64_t settingsHash = 0;
+        std::vector<InputStamp> inputs;
+    };
+
+    //Tracks every output the cooker has produced and which inputs it was
+    //built from. An output is only rebuilt when one of its inputs, or the
+    //settings used to build it, change.
+    class CookManifest
+    {
+    public:
+        bool load(const std::filesystem::path& filePath);
+        bool save(const std::filesystem::path& filePath) const;
+
+        bool isUpToDate(const std::filesystem::path& output, uint64_t settingsHash) const;
+
+        //Safe to call from the worker threads.
+        void record(const std::filesystem::path& output, uint64_t settingsHash, const std::vector<std::filesystem::path>& inputs);
+        void forget(const std::filesystem::path& output);
+
+        static bool stampFile(const std::filesystem::path& filePath, InputStamp& stamp, bool computeHash);
+    private:
+        mutable std::mutex _mutex;
+        std::unordered_map<std::string, ManifestEntry> _entries;
+    };
+}
+
+#endif // !COOK_MANIFEST_HDR
@@ -0,0 +1,292 @@
+#include "CookJob.h"
+#include "CookManifest.h"
+#include "MeshCooker.h"
+#include "ShaderCooker.h"
+#include "TextureCooker.h"
+
+#include "Gust/Assets/CookedFormats.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const char* MANIFEST_NAME = ".gustcook_manifest";
+
+    struct CookOptions
+    {
+        std::filesystem::path sourceRoot;
+        std::filesystem::path outputRoot;
+        GustCook::CookSettings settings;
+        uint32_t jobCount = 0;
+        bool force = false;
+    };
+
+    void printUsage()
+    {
+        spdlog::info("Usage: GustCook <source root> <output root> [--jobs N] [--force] [--glslc path] [--no-compress] [--no-optimise-shaders]");
+    }
+
+    bool parseArguments(int argc, char** argv, CookOptions& options)
+    {
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string argument = argv[i];
+            if (argument == "--jobs" && i + 1 < argc)
+            {
+                options.jobCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+            }
+            else if (argument == "--glslc" && i + 1 < argc)
+            {
+                options.settings.glslcPath = argv[++i];
+            }
+            else if (argument == "--force")
+            {
+                options.force = true;
+            }
+            else if (argument == "--no-compress")
+            {
+                options.settings.compressTextures = false;
+            }
+            else if (argument == "--no-optimise-shaders")
+            {
+                options.settings.optimiseShaders = false;
+            }
+            else if (!argument.empty() && argument[0] == '-')
+            {
+                spdlog::error("Unknown option {}", argument);
+                return false;
+            }
+            else
+            {
+                positional.push_back(argument);
+            }
+        }
+
+        if (positional.size() != 2)
+        {
+            return false;
+        }
+
+        options.sourceRoot = positional[0];
+        options.outputRoot = positional[1];
+        return true;
+    }
+
+    std::string lowerExtension(const std::filesystem::path& path)
+    {
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension;
+    }
+
+    //Works out what to do with each file under the source root. Anything we
+    //don't know how to cook is copied across so the runtime still finds it.
+    std::vector<GustCook::CookJob> gatherJobs(const CookOptions& options)
+    {
+        std::vector<GustCook::CookJob> jobs;
+
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(options.sourceRoot))
+        {
+            if (!entry.is_regular_file())
+            {
+                continue;
+            }
+
+            const std::filesystem::path& source = entry.path();
+            std::filesystem::path relative = std::filesystem::relative(source, options.sourceRoot);
+            std::filesystem::path output = options.outputRoot / relative;
+            std::string extension = lowerExtension(source);
+
+            GustCook::CookJob job;
+            job.source = source;
+
+            if (extension == ".obj")
+            {
+                job.type = GustCook::CookType::MESH;
+                job.output = output.replace_extension(Gust::COOKED_MESH_EXTENSION);
+            }
+            else if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp")
+            {
+                job.type = GustCook::CookType::TEXTURE;
+                job.output = output.replace_extension(Gust::COOKED_TEXTURE_EXTENSION);
+            }
+            else if (extension == ".vert" || extension == ".frag" || extension == ".comp" ||
+                     extension == ".geom" || extension == ".tesc" || extension == ".tese")
+            {
+                job.type = GustCook::CookType::SHADER;
+                job.output = output += ".spv";
+            }
+            else if (extension == ".spv" || extension == ".mtl" || extension == ".glsl")
+            {
+                //Stale hand compiled SPIR-V, OBJ materials and shader
+                //includes have no use at runtime.
+                continue;
+            }
+            else
+            {
+                job.type = GustCook::CookType::COPY;
+                job.output = output;
+            }
+
+            jobs.push_back(job);
+        }
+
+        return jobs;
+    }
+
+    uint64_t settingsHashFor(GustCook::CookType type, const GustCook::CookSettings& settings)
+    {
+        switch (type)
+        {
+        case GustCook::CookType::MESH:
+            return GustCook::MeshCooker::settingsHash(settings);
+        case GustCook::CookType::TEXTURE:
+            return GustCook::TextureCooker::settingsHash(settings);
+        case GustCook::CookType::SHADER:
+            return GustCook::ShaderCooker::settingsHash(settings);
+        case GustCook::CookType::COPY:
+        default:
+            return 1;
+        }
+    }
+
+    GustCook::CookResult runJob(const GustCook::CookJob& job, const GustCook::CookSettings& settings)
+    {
+        switch (job.type)
+        {
+        case GustCook::CookType::MESH:
+            return GustCook::MeshCooker::cook(job, settings);
+        case GustCook::CookType::TEXTURE:
+            return GustCook::TextureCooker::cook(job, settings);
+        case GustCook::CookType::SHADER:
+            return GustCook::ShaderCooker::cook(job, settings);
+        case GustCook::CookType::COPY:
+        default:
+        {
+            GustCook::CookResult result;
+            result.inputs.push_back(job.source);
+
+            std::error_code error;
+            std::filesystem::create_directories(job.output.parent_path(), error);
+            std::filesystem::copy_file(job.source, job.output, std::filesystem::copy_options::overwrite_existing, error);
+            result.success = !error;
+            result.message = error ? error.message() : "copied";
+            return result;
+        }
+        }
+    }
+}
+
+//The offline asset cooker. Takes the raw resources tree and produces the
+//runtime ready versions in parallel, only redoing work whose inputs changed.
+int main(int argc, char** argv)
+{
+    CookOptions options;
+    if (parseArguments(argc, argv, options) == false)
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::error_code error;
+    if (!std::filesystem::is_directory(options.sourceRoot, error))
+    {
+        spdlog::error("Source root {} is not a directory.", options.sourceRoot.string());
+        return 1;
+    }
+    std::filesystem::create_directories(options.outputRoot, error);
+
+    options.settings.glslcPath = GustCook::ShaderCooker::findCompiler(options.settings.glslcPath);
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    GustCook::CookManifest manifest;
+    std::filesystem::path manifestPath = options.outputRoot / MANIFEST_NAME;
+    if (options.force == false)
+    {
+        manifest.load(manifestPath);
+    }
+
+    std::vector<GustCook::CookJob> allJobs = gatherJobs(options);
+    std::vector<GustCook::CookJob> jobs;
+    for (const auto& job : allJobs)
+    {
+        if (options.force || manifest.isUpToDate(job.output, settingsHashFor(job.type, options.settings)) == false)
+        {
+            jobs.push_back(job);
+        }
+    }
+
+    uint32_t workerCount = options.jobCount;
+    if (workerCount == 0)
+    {
+        workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    workerCount = std::min(workerCount, std::max(static_cast<uint32_t>(jobs.size()), 1u));
+
+    spdlog::info("GustCook: {} assets, {} out of date, {} workers.", allJobs.size(), jobs.size(), workerCount);
+
+    std::atomic<size_t> nextJob = 0;
+    std::atomic<uint32_t> failures = 0;
+
+    auto worker = [&]()
+    {
+        for (size_t i = nextJob++; i < jobs.size(); i = nextJob++)
+        {
+            const GustCook::CookJob& job = jobs[i];
+            auto jobStart = std::chrono::steady_clock::now();
+
+            GustCook::CookResult result = runJob(job, options.settings);
+
+            float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - jobStart).count();
+            std::error_code relativeError;
+            std::string name = std::filesystem::relative(job.source, options.sourceRoot, relativeError).generic_string();
+
+            if (result.success)
+            {
+                manifest.record(job.output, settingsHashFor(job.type, options.settings), result.inputs);
+                spdlog::info("  {} ({:.1f} ms): {}", name, milliseconds, result.message);
+            }
+            else
+            {
+                //Forget the entry so a half finished output is never trusted.
+                manifest.forget(job.output);
+                failures++;
+                spdlog::error("  {} failed: {}", name, result.message);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 1; i < workerCount; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+
+    if (manifest.save(manifestPath) == false)
+    {
+        spdlog::error("Failed to write the cook manifest {}", manifestPath.string());
+        return 1;
+    }
+
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+    spdlog::info("GustCook: finished in {:.2f}s with {} failures.", seconds, failures.load());
+
+    return failures == 0 ? 0 : 1;
+}
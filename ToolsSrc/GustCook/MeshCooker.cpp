@@ -0,0 +1,388 @@
+#include "MeshCooker.h"
+#include "CookIO.h"
+
+#include <spdlog/spdlog.h>
+#include <tiny_obj_loader.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
+namespace
+{
+    //Bump this whenever the mesh cooking changes output for the same input.
+    const uint32_t MESH_COOKER_VERSION = 1;
+
+    //Forsyth's linear speed vertex cache optimisation. The cache size here is
+    //the model the scores are built for, not a real hardware size.
+    const uint32_t OPTIMISE_CACHE_SIZE = 32;
+    const uint32_t REPORT_CACHE_SIZE = 16;
+
+    //Vertices closer than this are treated as the same vertex when welding.
+    const float WELD_EPSILON = 1e-5f;
+
+    float vertexScore(int cachePosition, uint32_t remainingValence)
+    {
+        if (remainingValence == 0)
+        {
+            return -1.f;
+        }
+
+        float score = 0.f;
+        if (cachePosition >= 0)
+        {
+            //The last triangle's vertices get a fixed score so we don't
+            //favour one winding over another.
+            if (cachePosition < 3)
+            {
+                score = 0.75f;
+            }
+            else
+            {
+                float scaler = 1.f / static_cast<float>(OPTIMISE_CACHE_SIZE - 3);
+                score = std::pow(1.f - static_cast<float>(cachePosition - 3) * scaler, 1.5f);
+            }
+        }
+
+        //Boost vertices with few triangles left so we finish them off and
+        //don't leave lonely triangles to be picked up later.
+        score += 2.f * std::pow(static_cast<float>(remainingValence), -0.5f);
+        return score;
+    }
+
+    struct WeldKey
+    {
+        int32_t values[8];
+
+        bool operator==(const WeldKey& other) const
+        {
+            return memcmp(values, other.values, sizeof(values)) == 0;
+        }
+    };
+
+    struct WeldKeyHash
+    {
+        size_t operator()(const WeldKey& key) const
+        {
+            return static_cast<size_t>(GustCook::hashBytes(key.values, sizeof(key.values)));
+        }
+    };
+
+    WeldKey makeWeldKey(const Gust::CookedVertex& vertex)
+    {
+        const float* floats = vertex.pos;
+        WeldKey key;
+        for (int i = 0; i < 8; i++)
+        {
+            key.values[i] = static_cast<int32_t>(std::lround(floats[i] / WELD_EPSILON));
+        }
+        return key;
+    }
+}
+
+namespace GustCook
+{
+    CookResult MeshCooker::cook(const CookJob& job, const CookSettings& /*settings*/)
+    {
+        CookResult result;
+        result.inputs.push_back(job.source);
+
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warning, error;
+
+        std::string baseDirectory = job.source.parent_path().string() + "/";
+        bool loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, job.source.string().c_str(), baseDirectory.c_str());
+        if (loaded == false)
+        {
+            result.message = "OBJ load failed: " + error;
+            return result;
+        }
+
+        std::vector<Gust::CookedVertex> vertices;
+        std::vector<uint32_t> indices;
+        std::unordered_map<WeldKey, uint32_t, WeldKeyHash> uniqueVertices;
+
+        for (const auto& shape : shapes)
+        {
+            for (const auto& index : shape.mesh.indices)
+            {
+                Gust::CookedVertex vertex{};
+
+                vertex.pos[0] = attrib.vertices[3 * index.vertex_index + 0];
+                vertex.pos[1] = attrib.vertices[3 * index.vertex_index + 1];
+                vertex.pos[2] = attrib.vertices[3 * index.vertex_index + 2];
+
+                if (index.texcoord_index >= 0)
+                {
+                    vertex.texCoord[0] = attrib.texcoords[2 * index.texcoord_index + 0];
+                    vertex.texCoord[1] = 1.f - attrib.texcoords[2 * index.texcoord_index + 1];
+                }
+
+                vertex.colour[0] = 1.f;
+                vertex.colour[1] = 1.f;
+                vertex.colour[2] = 1.f;
+
+                WeldKey key = makeWeldKey(vertex);
+                auto found = uniqueVertices.find(key);
+                if (found == uniqueVertices.end())
+                {
+                    found = uniqueVertices.emplace(key, static_cast<uint32_t>(vertices.size())).first;
+                    vertices.push_back(vertex);
+                }
+
+                indices.push_back(found->second);
+            }
+        }
+
+        if (vertices.empty() || indices.size() % 3 != 0)
+        {
+            result.message = "OBJ has no triangles.";
+            return result;
+        }
+
+        float missesBefore = averageCacheMissRatio(indices, REPORT_CACHE_SIZE);
+        optimiseVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+        optimiseVertexFetch(vertices, indices);
+        float missesAfter = averageCacheMissRatio(indices, REPORT_CACHE_SIZE);
+
+        Gust::CookedMeshHeader header{};
+        header.magic = Gust::COOKED_MESH_MAGIC;
+        header.version = Gust::COOKED_MESH_VERSION;
+        header.vertexCount = static_cast<uint32_t>(vertices.size());
+        header.indexCount = static_cast<uint32_t>(indices.size());
+        for (int axis = 0; axis < 3; axis++)
+        {
+            header.boundsMin[axis] = vertices[0].pos[axis];
+            header.boundsMax[axis] = vertices[0].pos[axis];
+        }
+        for (const auto& vertex : vertices)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                header.boundsMin[axis] = std::min(header.boundsMin[axis], vertex.pos[axis]);
+                header.boundsMax[axis] = std::max(header.boundsMax[axis], vertex.pos[axis]);
+            }
+        }
+
+        std::vector<uint8_t> bytes;
+        appendBytes(bytes, &header, 1);
+        appendBytes(bytes, vertices.data(), vertices.size());
+        appendBytes(bytes, indices.data(), indices.size());
+
+        if (writeFileAtomic(job.output, bytes.data(), bytes.size()) == false)
+        {
+            result.message = "Failed to write " + job.output.string();
+            return result;
+        }
+
+        result.success = true;
+        result.message = fmt::format("{} vertices, {} triangles, ACMR {:.3f} -> {:.3f}",
+                                     vertices.size(), indices.size() / 3, missesBefore, missesAfter);
+        return result;
+    }
+
+    uint64_t MeshCooker::settingsHash(const CookSettings& /*settings*/)
+    {
+        uint64_t hash = hashBytes(&MESH_COOKER_VERSION, sizeof(MESH_COOKER_VERSION));
+        return hashBytes(&Gust::COOKED_MESH_VERSION, sizeof(Gust::COOKED_MESH_VERSION), hash);
+    }
+
+    void MeshCooker::optimiseVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+    {
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        //Build a list of triangles per vertex. Emitted triangles are swapped
+        //to the end of each vertex's range so the front is what's left.
+        std::vector<uint32_t> remainingValence(vertexCount, 0);
+        for (uint32_t index : indices)
+        {
+            remainingValence[index]++;
+        }
+
+        std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            triangleOffsets[v + 1] = triangleOffsets[v] + remainingValence[v];
+        }
+
+        std::vector<uint32_t> vertexTriangles(indices.size());
+        std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            for (int corner = 0; corner < 3; corner++)
+            {
+                uint32_t v = indices[t * 3 + corner];
+                vertexTriangles[fill[v]++] = static_cast<uint32_t>(t);
+            }
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> scoreOfVertex(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            scoreOfVertex[v] = vertexScore(-1, remainingValence[v]);
+        }
+
+        std::vector<float> scoreOfTriangle(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        int64_t bestTriangle = -1;
+        float bestScore = -1.f;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            scoreOfTriangle[t] = scoreOfVertex[indices[t * 3]] + scoreOfVertex[indices[t * 3 + 1]] + scoreOfVertex[indices[t * 3 + 2]];
+            if (scoreOfTriangle[t] > bestScore)
+            {
+                bestScore = scoreOfTriangle[t];
+                bestTriangle = static_cast<int64_t>(t);
+            }
+        }
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> newCache;
+        cache.reserve(OPTIMISE_CACHE_SIZE + 3);
+        newCache.reserve(OPTIMISE_CACHE_SIZE + 3);
+
+        size_t fallbackCursor = 0;
+
+        for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+        {
+            //Nothing in the cache is connected to anything left, so carry on
+            //from the next triangle in input order.
+            if (bestTriangle < 0)
+            {
+                while (emitted[fallbackCursor])
+                {
+                    fallbackCursor++;
+                }
+                bestTriangle = static_cast<int64_t>(fallbackCursor);
+            }
+
+            size_t triangle = static_cast<size_t>(bestTriangle);
+            emitted[triangle] = true;
+
+            newCache.clear();
+            for (int corner = 0; corner < 3; corner++)
+            {
+                uint32_t v = indices[triangle * 3 + corner];
+                output.push_back(v);
+                newCache.push_back(v);
+
+                uint32_t begin = triangleOffsets[v];
+                uint32_t end = begin + remainingValence[v];
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    if (vertexTriangles[i] == triangle)
+                    {
+                        std::swap(vertexTriangles[i], vertexTriangles[end - 1]);
+                        break;
+                    }
+                }
+                remainingValence[v]--;
+            }
+
+            for (uint32_t v : cache)
+            {
+                if (v != newCache[0] && v != newCache[1] && v != newCache[2])
+                {
+                    newCache.push_back(v);
+                }
+            }
+
+            for (size_t i = 0; i < newCache.size(); i++)
+            {
+                cachePosition[newCache[i]] = i < OPTIMISE_CACHE_SIZE ? static_cast<int>(i) : -1;
+            }
+
+            //Rescore everything that was in the cache, including the ones
+            //that just fell out, then find the best triangle they touch.
+            bestTriangle = -1;
+            bestScore = -1.f;
+            for (uint32_t v : newCache)
+            {
+                scoreOfVertex[v] = vertexScore(cachePosition[v], remainingValence[v]);
+            }
+
+            for (uint32_t v : newCache)
+            {
+                uint32_t begin = triangleOffsets[v];
+                uint32_t end = begin + remainingValence[v];
+                for (uint32_t i = begin; i < end; i++)
+                {
+                    uint32_t t = vertexTriangles[i];
+                    scoreOfTriangle[t] = scoreOfVertex[indices[t * 3]] + scoreOfVertex[indices[t * 3 + 1]] + scoreOfVertex[indices[t * 3 + 2]];
+                    if (scoreOfTriangle[t] > bestScore)
+                    {
+                        bestScore = scoreOfTriangle[t];
+                        bestTriangle = t;
+                    }
+                }
+            }
+
+            if (newCache.size() > OPTIMISE_CACHE_SIZE)
+            {
+                newCache.resize(OPTIMISE_CACHE_SIZE);
+            }
+            std::swap(cache, newCache);
+        }
+
+        indices = std::move(output);
+    }
+
+    void MeshCooker::optimiseVertexFetch(std::vector<Gust::CookedVertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        //Lay vertices out in the order the index buffer first touches them.
+        const uint32_t UNUSED = ~0u;
+        std::vector<uint32_t> remap(vertices.size(), UNUSED);
+        std::vector<Gust::CookedVertex> reordered;
+        reordered.reserve(vertices.size());
+
+        for (uint32_t& index : indices)
+        {
+            if (remap[index] == UNUSED)
+            {
+                remap[index] = static_cast<uint32_t>(reordered.size());
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        vertices = std::move(reordered);
+    }
+
+    float MeshCooker::averageCacheMissRatio(const std::vector<uint32_t>& indices, uint32_t cacheSize)
+    {
+        if (indices.size() < 3)
+        {
+            return 0.f;
+        }
+
+        std::deque<uint32_t> fifo;
+        size_t misses = 0;
+
+        for (uint32_t index : indices)
+        {
+            if (std::find(fifo.begin(), fifo.end(), index) == fifo.end())
+            {
+                misses++;
+                fifo.push_back(index);
+                if (fifo.size() > cacheSize)
+                {
+                    fifo.pop_front();
+                }
+            }
+        }
+
+        return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    }
+}
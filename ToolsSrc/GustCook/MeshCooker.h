@@ -0,0 +1,27 @@
+#ifndef MESH_COOKER_HDR
+#define MESH_COOKER_HDR
+
+#include "CookJob.h"
+
+#include "Gust/Assets/CookedFormats.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace GustCook
+{
+    //Turns an OBJ into a .gmesh. Vertices are welded, triangles reordered for
+    //the post transform cache and vertices reordered for fetch locality.
+    class MeshCooker
+    {
+    public:
+        static CookResult cook(const CookJob& job, const CookSettings& settings);
+        static uint64_t settingsHash(const CookSettings& settings);
+
+        static void optimiseVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+        static void optimiseVertexFetch(std::vector<Gust::CookedVertex>& vertices, std::vector<uint32_t>& indices);
+        static float averageCacheMissRatio(const std::vector<uint32_t>& indices, uint32_t cacheSize);
+    };
+}
+
+#endif // !MESH_COOKER_HDR
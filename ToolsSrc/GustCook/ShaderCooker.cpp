@@ -0,0 +1,172 @@
+#include "ShaderCooker.h"
+#include "CookIO.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+namespace
+{
+    //Bump this whenever the shader cooking changes output for the same input.
+    const uint32_t SHADER_COOKER_VERSION = 1;
+
+    std::string quote(const std::filesystem::path& path)
+    {
+        return "\"" + path.string() + "\"";
+    }
+}
+
+namespace GustCook
+{
+    CookResult ShaderCooker::cook(const CookJob& job, const CookSettings& settings)
+    {
+        CookResult result;
+        result.inputs.push_back(job.source);
+
+        std::error_code error;
+        std::filesystem::create_directories(job.output.parent_path(), error);
+
+        std::filesystem::path tempOutput = job.output;
+        tempOutput += ".tmp";
+        std::filesystem::path depfile = job.output;
+        depfile += ".d";
+
+        std::string command = quote(settings.glslcPath) + " " + quote(job.source) +
+                              " -o " + quote(tempOutput) + " -MD -MF " + quote(depfile);
+        if (settings.optimiseShaders)
+        {
+            command += " -O";
+        }
+
+#ifdef _WIN32
+        //cmd.exe strips the first and last quote of the whole line.
+        command = "\"" + command + "\"";
+#endif
+
+        int exitCode = std::system(command.c_str());
+        if (exitCode != 0)
+        {
+            std::filesystem::remove(tempOutput, error);
+            result.message = "glslc failed with exit code " + std::to_string(exitCode);
+            return result;
+        }
+
+        std::filesystem::rename(tempOutput, job.output, error);
+        if (error)
+        {
+            result.message = "Failed to write " + job.output.string();
+            return result;
+        }
+
+        for (const auto& dependency : parseDepfile(depfile))
+        {
+            if (std::filesystem::equivalent(dependency, job.source, error) == false)
+            {
+                result.inputs.push_back(dependency);
+            }
+        }
+        std::filesystem::remove(depfile, error);
+
+        result.success = true;
+        result.message = std::to_string(std::filesystem::file_size(job.output, error)) + " bytes of SPIR-V";
+        return result;
+    }
+
+    uint64_t ShaderCooker::settingsHash(const CookSettings& settings)
+    {
+        uint64_t hash = hashBytes(&SHADER_COOKER_VERSION, sizeof(SHADER_COOKER_VERSION));
+        return hashBytes(&settings.optimiseShaders, sizeof(settings.optimiseShaders), hash);
+    }
+
+    std::filesystem::path ShaderCooker::findCompiler(const std::filesystem::path& requested)
+    {
+        if (!requested.empty())
+        {
+            return requested;
+        }
+
+#ifdef _WIN32
+        const char* executable = "glslc.exe";
+#else
+        const char* executable = "glslc";
+#endif
+
+        if (const char* sdk = std::getenv("VULKAN_SDK"))
+        {
+            std::error_code error;
+            for (const char* binDirectory : { "Bin", "bin" })
+            {
+                std::filesystem::path candidate = std::filesystem::path(sdk) / binDirectory / executable;
+                if (std::filesystem::exists(candidate, error))
+                {
+                    return candidate;
+                }
+            }
+        }
+
+#ifdef GUST_COOK_GLSLC
+        return GUST_COOK_GLSLC;
+#else
+        //Leave it to the PATH.
+        return executable;
+#endif
+    }
+
+    //Depfiles are in make syntax, "target: dep dep \" with spaces in paths
+    //escaped by a backslash.
+    std::vector<std::filesystem::path> ShaderCooker::parseDepfile(const std::filesystem::path& depfile)
+    {
+        std::vector<std::filesystem::path> dependencies;
+
+        std::ifstream file(depfile);
+        if (!file.is_open())
+        {
+            return dependencies;
+        }
+
+        std::stringstream contents;
+        contents << file.rdbuf();
+        std::string text = contents.str();
+
+        size_t colon = text.find(": ");
+        if (colon == std::string::npos)
+        {
+            return dependencies;
+        }
+
+        std::string current;
+        for (size_t i = colon + 2; i < text.size(); i++)
+        {
+            char c = text[i];
+            if (c == '\\' && i + 1 < text.size() && text[i + 1] == ' ')
+            {
+                current += ' ';
+                i++;
+            }
+            else if (c == '\\' && i + 1 < text.size() && (text[i + 1] == '\n' || text[i + 1] == '\r'))
+            {
+                continue;
+            }
+            else if (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+            {
+                if (!current.empty())
+                {
+                    dependencies.emplace_back(current);
+                    current.clear();
+                }
+            }
+            else
+            {
+                current += c;
+            }
+        }
+
+        if (!current.empty())
+        {
+            dependencies.emplace_back(current);
+        }
+
+        return dependencies;
+    }
+}
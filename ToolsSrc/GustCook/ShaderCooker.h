@@ -0,0 +1,24 @@
+#ifndef SHADER_COOKER_HDR
+#define SHADER_COOKER_HDR
+
+#include "CookJob.h"
+
+#include <cstdint>
+
+namespace GustCook
+{
+    //Compiles GLSL to SPIR-V with glslc. glslc writes a depfile alongside so
+    //editing an included file re-cooks every shader that uses it.
+    class ShaderCooker
+    {
+    public:
+        static CookResult cook(const CookJob& job, const CookSettings& settings);
+        static uint64_t settingsHash(const CookSettings& settings);
+
+        static std::filesystem::path findCompiler(const std::filesystem::path& requested);
+    private:
+        static std::vector<std::filesystem::path> parseDepfile(const std::filesystem::path& depfile);
+    };
+}
+
+#endif // !SHADER_COOKER_HDR
@@ -0,0 +1,445 @@
+#include "TextureCooker.h"
+#include "CookIO.h"
+
+#include "Gust/Assets/CookedFormats.h"
+
+#include <spdlog/spdlog.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    //Bump this whenever the texture cooking changes output for the same input.
+    const uint32_t TEXTURE_COOKER_VERSION = 1;
+
+    //Mip filtering happens in linear space, averaging sRGB values directly
+    //darkens every level.
+    const std::array<float, 256>& srgbToLinearTable()
+    {
+        static const std::array<float, 256> table = []()
+        {
+            std::array<float, 256> values{};
+            for (int i = 0; i < 256; i++)
+            {
+                float c = static_cast<float>(i) / 255.f;
+                values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return values;
+        }();
+
+        return table;
+    }
+
+    uint8_t linearToSrgb(float value)
+    {
+        value = std::clamp(value, 0.f, 1.f);
+        float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+        return static_cast<uint8_t>(std::lround(c * 255.f));
+    }
+
+    //Copies a 4x4 block out of the image. Texels past the edge repeat the
+    //last row or column so they don't pull the endpoints around.
+    void fetchBlock(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t* texels)
+    {
+        for (uint32_t y = 0; y < 4; y++)
+        {
+            uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+            for (uint32_t x = 0; x < 4; x++)
+            {
+                uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+                const uint8_t* texel = &rgba[(static_cast<size_t>(sourceY) * width + sourceX) * 4];
+                std::copy(texel, texel + 4, &texels[(y * 4 + x) * 4]);
+            }
+        }
+    }
+
+    uint16_t pack565(const float* colour)
+    {
+        uint32_t r = static_cast<uint32_t>(std::lround(std::clamp(colour[0], 0.f, 255.f) * 31.f / 255.f));
+        uint32_t g = static_cast<uint32_t>(std::lround(std::clamp(colour[1], 0.f, 255.f) * 63.f / 255.f));
+        uint32_t b = static_cast<uint32_t>(std::lround(std::clamp(colour[2], 0.f, 255.f) * 31.f / 255.f));
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void unpack565(uint16_t packed, int* rgb)
+    {
+        int r = (packed >> 11) & 0x1F;
+        int g = (packed >> 5) & 0x3F;
+        int b = packed & 0x1F;
+
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    //Fits the endpoints along the principal axis of the block's colours. It's
+    //a range fit rather than a cluster fit, fast and good enough for albedo.
+    void encodeColourBlock(const uint8_t* texels, uint8_t* block)
+    {
+        float mean[3] = { 0.f, 0.f, 0.f };
+        for (int i = 0; i < 16; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                mean[c] += texels[i * 4 + c];
+            }
+        }
+        for (int c = 0; c < 3; c++)
+        {
+            mean[c] /= 16.f;
+        }
+
+        float covariance[6] = {};
+        for (int i = 0; i < 16; i++)
+        {
+            float r = texels[i * 4 + 0] - mean[0];
+            float g = texels[i * 4 + 1] - mean[1];
+            float b = texels[i * 4 + 2] - mean[2];
+            covariance[0] += r * r;
+            covariance[1] += r * g;
+            covariance[2] += r * b;
+            covariance[3] += g * g;
+            covariance[4] += g * b;
+            covariance[5] += b * b;
+        }
+
+        float axis[3] = { 1.f, 1.f, 1.f };
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+            float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+            float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+            float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+            float length = std::max(std::max(std::abs(x), std::abs(y)), std::abs(z));
+            if (length < 1e-6f)
+            {
+                break;
+            }
+            axis[0] = x / length;
+            axis[1] = y / length;
+            axis[2] = z / length;
+        }
+
+        float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        for (int c = 0; c < 3; c++)
+        {
+            axis[c] /= axisLength;
+        }
+
+        float minProjection = 0.f;
+        float maxProjection = 0.f;
+        for (int i = 0; i < 16; i++)
+        {
+            float projection = (texels[i * 4 + 0] - mean[0]) * axis[0] +
+                               (texels[i * 4 + 1] - mean[1]) * axis[1] +
+                               (texels[i * 4 + 2] - mean[2]) * axis[2];
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+
+        float maxEnd[3];
+        float minEnd[3];
+        for (int c = 0; c < 3; c++)
+        {
+            maxEnd[c] = mean[c] + axis[c] * maxProjection;
+            minEnd[c] = mean[c] + axis[c] * minProjection;
+        }
+
+        uint16_t colour0 = pack565(maxEnd);
+        uint16_t colour1 = pack565(minEnd);
+
+        //colour0 > colour1 selects the four colour mode with no transparency.
+        if (colour0 < colour1)
+        {
+            std::swap(colour0, colour1);
+        }
+
+        uint32_t indices = 0;
+        if (colour0 != colour1)
+        {
+            int palette[4][3];
+            unpack565(colour0, palette[0]);
+            unpack565(colour1, palette[1]);
+            for (int c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+
+            for (int i = 0; i < 16; i++)
+            {
+                int bestIndex = 0;
+                int bestDistance = std::numeric_limits<int>::max();
+                for (int p = 0; p < 4; p++)
+                {
+                    int dr = texels[i * 4 + 0] - palette[p][0];
+                    int dg = texels[i * 4 + 1] - palette[p][1];
+                    int db = texels[i * 4 + 2] - palette[p][2];
+                    int distance = dr * dr + dg * dg + db * db;
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        bestIndex = p;
+                    }
+                }
+                indices |= static_cast<uint32_t>(bestIndex) << (i * 2);
+            }
+        }
+
+        block[0] = static_cast<uint8_t>(colour0 & 0xFF);
+        block[1] = static_cast<uint8_t>(colour0 >> 8);
+        block[2] = static_cast<uint8_t>(colour1 & 0xFF);
+        block[3] = static_cast<uint8_t>(colour1 >> 8);
+        block[4] = static_cast<uint8_t>(indices & 0xFF);
+        block[5] = static_cast<uint8_t>((indices >> 8) & 0xFF);
+        block[6] = static_cast<uint8_t>((indices >> 16) & 0xFF);
+        block[7] = static_cast<uint8_t>(indices >> 24);
+    }
+
+    void encodeAlphaBlock(const uint8_t* texels, uint8_t* block)
+    {
+        int alpha0 = 0;
+        int alpha1 = 255;
+        for (int i = 0; i < 16; i++)
+        {
+            alpha0 = std::max(alpha0, static_cast<int>(texels[i * 4 + 3]));
+            alpha1 = std::min(alpha1, static_cast<int>(texels[i * 4 + 3]));
+        }
+
+        uint64_t indices = 0;
+        if (alpha0 != alpha1)
+        {
+            //alpha0 > alpha1 picks the eight value interpolation mode.
+            int values[8];
+            values[0] = alpha0;
+            values[1] = alpha1;
+            for (int i = 1; i < 7; i++)
+            {
+                values[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+            }
+
+            for (int i = 0; i < 16; i++)
+            {
+                int bestIndex = 0;
+                int bestDistance = 256;
+                for (int v = 0; v < 8; v++)
+                {
+                    int distance = std::abs(texels[i * 4 + 3] - values[v]);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        bestIndex = v;
+                    }
+                }
+                indices |= static_cast<uint64_t>(bestIndex) << (i * 3);
+            }
+        }
+
+        block[0] = static_cast<uint8_t>(alpha0);
+        block[1] = static_cast<uint8_t>(alpha1);
+        for (int i = 0; i < 6; i++)
+        {
+            block[2 + i] = static_cast<uint8_t>((indices >> (i * 8)) & 0xFF);
+        }
+    }
+
+    const char* formatName(Gust::CookedTextureFormat format)
+    {
+        switch (format)
+        {
+        case Gust::CookedTextureFormat::BC1_SRGB:
+            return "BC1";
+        case Gust::CookedTextureFormat::BC3_SRGB:
+            return "BC3";
+        case Gust::CookedTextureFormat::RGBA8_SRGB:
+        default:
+            return "RGBA8";
+        }
+    }
+}
+
+namespace GustCook
+{
+    CookResult TextureCooker::cook(const CookJob& job, const CookSettings& settings)
+    {
+        CookResult result;
+        result.inputs.push_back(job.source);
+
+        int texWidth = -1, texHeight = -1, texChannels = -1;
+        stbi_uc* pixels = stbi_load(job.source.string().c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+        if (pixels == nullptr)
+        {
+            result.message = std::string("Failed to load image: ") + stbi_failure_reason();
+            return result;
+        }
+
+        uint32_t width = static_cast<uint32_t>(texWidth);
+        uint32_t height = static_cast<uint32_t>(texHeight);
+        std::vector<uint8_t> level(pixels, pixels + static_cast<size_t>(width) * height * 4);
+        stbi_image_free(pixels);
+
+        bool hasAlpha = false;
+        for (size_t i = 3; i < level.size(); i += 4)
+        {
+            if (level[i] != 255)
+            {
+                hasAlpha = true;
+                break;
+            }
+        }
+
+        Gust::CookedTextureFormat format = Gust::CookedTextureFormat::RGBA8_SRGB;
+        if (settings.compressTextures)
+        {
+            format = hasAlpha ? Gust::CookedTextureFormat::BC3_SRGB : Gust::CookedTextureFormat::BC1_SRGB;
+        }
+
+        uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+
+        std::vector<Gust::CookedMipHeader> mips(mipLevels);
+        std::vector<uint8_t> mipData;
+
+        uint64_t dataOffset = sizeof(Gust::CookedTextureHeader) + sizeof(Gust::CookedMipHeader) * mipLevels;
+        uint32_t mipWidth = width;
+        uint32_t mipHeight = height;
+        std::vector<uint8_t> encoded;
+        std::vector<uint8_t> nextLevel;
+
+        for (uint32_t mip = 0; mip < mipLevels; mip++)
+        {
+            if (format == Gust::CookedTextureFormat::BC1_SRGB)
+            {
+                compressBC1(level, mipWidth, mipHeight, encoded);
+            }
+            else if (format == Gust::CookedTextureFormat::BC3_SRGB)
+            {
+                compressBC3(level, mipWidth, mipHeight, encoded);
+            }
+            else
+            {
+                encoded = level;
+            }
+
+            mips[mip].width = mipWidth;
+            mips[mip].height = mipHeight;
+            mips[mip].offset = dataOffset + mipData.size();
+            mips[mip].size = encoded.size();
+            mipData.insert(mipData.end(), encoded.begin(), encoded.end());
+
+            if (mip + 1 < mipLevels)
+            {
+                uint32_t nextWidth = std::max(mipWidth / 2, 1u);
+                uint32_t nextHeight = std::max(mipHeight / 2, 1u);
+                downsample(level, mipWidth, mipHeight, nextLevel, nextWidth, nextHeight);
+                std::swap(level, nextLevel);
+                mipWidth = nextWidth;
+                mipHeight = nextHeight;
+            }
+        }
+
+        Gust::CookedTextureHeader header{};
+        header.magic = Gust::COOKED_TEXTURE_MAGIC;
+        header.version = Gust::COOKED_TEXTURE_VERSION;
+        header.format = format;
+        header.width = width;
+        header.height = height;
+        header.mipLevels = mipLevels;
+
+        std::vector<uint8_t> bytes;
+        bytes.reserve(dataOffset + mipData.size());
+        appendBytes(bytes, &header, 1);
+        appendBytes(bytes, mips.data(), mips.size());
+        appendBytes(bytes, mipData.data(), mipData.size());
+
+        if (writeFileAtomic(job.output, bytes.data(), bytes.size()) == false)
+        {
+            result.message = "Failed to write " + job.output.string();
+            return result;
+        }
+
+        result.success = true;
+        result.message = fmt::format("{}x{}, {} mips, {}, {:.2f} MiB", width, height, mipLevels,
+                                     formatName(format), static_cast<double>(bytes.size()) / (1024.0 * 1024.0));
+        return result;
+    }
+
+    uint64_t TextureCooker::settingsHash(const CookSettings& settings)
+    {
+        uint64_t hash = hashBytes(&TEXTURE_COOKER_VERSION, sizeof(TEXTURE_COOKER_VERSION));
+        hash = hashBytes(&Gust::COOKED_TEXTURE_VERSION, sizeof(Gust::COOKED_TEXTURE_VERSION), hash);
+        return hashBytes(&settings.compressTextures, sizeof(settings.compressTextures), hash);
+    }
+
+    void TextureCooker::downsample(const std::vector<uint8_t>& source, uint32_t width, uint32_t height,
+                                   std::vector<uint8_t>& dest, uint32_t destWidth, uint32_t destHeight)
+    {
+        const auto& toLinear = srgbToLinearTable();
+        dest.resize(static_cast<size_t>(destWidth) * destHeight * 4);
+
+        for (uint32_t y = 0; y < destHeight; y++)
+        {
+            uint32_t y0 = std::min(y * 2, height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, height - 1);
+            for (uint32_t x = 0; x < destWidth; x++)
+            {
+                uint32_t x0 = std::min(x * 2, width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, width - 1);
+
+                const uint8_t* taps[4] =
+                {
+                    &source[(static_cast<size_t>(y0) * width + x0) * 4],
+                    &source[(static_cast<size_t>(y0) * width + x1) * 4],
+                    &source[(static_cast<size_t>(y1) * width + x0) * 4],
+                    &source[(static_cast<size_t>(y1) * width + x1) * 4]
+                };
+
+                uint8_t* out = &dest[(static_cast<size_t>(y) * destWidth + x) * 4];
+                for (int c = 0; c < 3; c++)
+                {
+                    float sum = toLinear[taps[0][c]] + toLinear[taps[1][c]] + toLinear[taps[2][c]] + toLinear[taps[3][c]];
+                    out[c] = linearToSrgb(sum * 0.25f);
+                }
+                out[3] = static_cast<uint8_t>((taps[0][3] + taps[1][3] + taps[2][3] + taps[3][3] + 2) / 4);
+            }
+        }
+    }
+
+    void TextureCooker::compressBC1(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& blocks)
+    {
+        uint32_t blocksWide = (width + 3) / 4;
+        uint32_t blocksHigh = (height + 3) / 4;
+        blocks.resize(static_cast<size_t>(blocksWide) * blocksHigh * 8);
+
+        uint8_t texels[16 * 4];
+        for (uint32_t by = 0; by < blocksHigh; by++)
+        {
+            for (uint32_t bx = 0; bx < blocksWide; bx++)
+            {
+                fetchBlock(rgba, width, height, bx, by, texels);
+                encodeColourBlock(texels, &blocks[(static_cast<size_t>(by) * blocksWide + bx) * 8]);
+            }
+        }
+    }
+
+    void TextureCooker::compressBC3(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& blocks)
+    {
+        uint32_t blocksWide = (width + 3) / 4;
+        uint32_t blocksHigh = (height + 3) / 4;
+        blocks.resize(static_cast<size_t>(blocksWide) * blocksHigh * 16);
+
+        uint8_t texels[16 * 4];
+        for (uint32_t by = 0; by < blocksHigh; by++)
+        {
+            for (uint32_t bx = 0; bx < blocksWide; bx++)
+            {
+                uint8_t* block = &blocks[(static_cast<size_t>(by) * blocksWide + bx) * 16];
+                fetchBlock(rgba, width, height, bx, by, texels);
+                encodeAlphaBlock(texels, block);
+                encodeColourBlock(texels, block + 8);
+            }
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef TEXTURE_COOKER_HDR
+#define TEXTURE_COOKER_HDR
+
+#include "CookJob.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace GustCook
+{
+    //Turns a source image into a .gtex with a full mip chain. Opaque images
+    //are compressed to BC1 and images with alpha to BC3.
+    class TextureCooker
+    {
+    public:
+        static CookResult cook(const CookJob& job, const CookSettings& settings);
+        static uint64_t settingsHash(const CookSettings& settings);
+
+        //Each source and destination is tightly packed sRGB RGBA8.
+        static void downsample(const std::vector<uint8_t>& source, uint32_t width, uint32_t height,
+                               std::vector<uint8_t>& dest, uint32_t destWidth, uint32_t destHeight);
+        static void compressBC1(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& blocks);
+        static void compressBC3(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& blocks);
+    };
+}
+
+#endif // !TEXTURE_COOKER_HDR
@@ -1,2 +0,0 @@
-D:\Windows\VulkanSDK\1.3.236.0\Bin\glslc.exe GameSrc\Resources\Assets\Shaders\simple_shader.vert -o GameSrc\Resources\Assets\Shaders\simple_shader.vert.spv
-D:\Windows\VulkanSDK\1.3.236.0\Bin\glslc.exe GameSrc\Resources\Assets\Shaders\simple_shader.frag -o GameSrc\Resources\Assets\Shaders\simple_shader.frag.spv
\ No newline at end of file